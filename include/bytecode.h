@@ -0,0 +1,108 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include <code.h>
+
+namespace FJP {
+
+    /// This class stores the code generated by the parser into a binary bytecode file (.pl0b) and loads
+    /// it back, so a compiled program can be executed without lexing and parsing its source code again.
+    /// The file starts with a header (magic number, version, layout of the instructions, checksum)
+    /// followed by the instructions themselves in the packed form (see PackedInstruction) and the table
+    /// of wide instructions, so they are executed right from the memory-mapped file.
+    /// The rest of the code (constant pool, vector loops, jump tables, in-place updates, sizes of arrays,
+    /// line table, functions) follows the instructions as a sequence of 32-bit integers.
+    class BytecodeFile {
+    private:
+        /// Version of the format (increased whenever the layout of the file changes).
+        static constexpr uint32_t VERSION = 2;
+
+        /// Value stored in the header to detect a file written on a machine with a different byte order.
+        static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+        /// Header of the bytecode file.
+        struct Header {
+            char magic[4];             ///< "PL0B"
+            uint32_t version;          ///< version of the format
+            uint32_t byteOrder;        ///< BYTE_ORDER_MARK as stored by the machine that wrote the file
+            uint32_t instructionSize;  ///< size of a single (wide) instruction in bytes
+            uint32_t instructionCount; ///< number of the packed instructions
+            uint32_t wideCount;        ///< number of the wide instructions following the packed ones
+            uint32_t metadataSize;     ///< number of 32-bit integers following the instructions
+            uint32_t reserved;         ///< padding (always 0)
+            uint64_t checksum;         ///< FNV-1a hash of everything following the header
+        };
+
+    private:
+        /// Contents of the file mapped into the memory (nullptr if it is not mapped).
+        void *mapping;
+
+        /// Size of the mapped file in bytes.
+        size_t mappingSize;
+
+        /// Contents of the file read into the memory if it cannot be mapped (8-byte aligned).
+        std::vector<uint64_t> buffer;
+
+    private:
+        /// Deleted copy constructor of the class
+        BytecodeFile(BytecodeFile &) = delete;
+
+        /// Deleted assign operator of the class
+        void operator=(BytecodeFile const &) = delete;
+
+        /// Maps the file into the memory (or reads it if mapping is not supported).
+        /// \param filename path to the bytecode file
+        /// \param size size of the file in bytes
+        /// \return the contents of the file (nullptr if it cannot be opened)
+        const unsigned char *open(const std::string &filename, size_t &size);
+
+        /// Releases the contents of the file.
+        void close();
+
+        /// Loads the code from a bytecode file.
+        /// \param filename path to the bytecode file
+        /// \param code the code stored within the file
+        /// \return error message (nullptr if the code has been loaded)
+        const char *read(const std::string &filename, FJP::GeneratedCode &code);
+
+    public:
+        /// Constructor - creates an instance of the class
+        BytecodeFile();
+
+        /// Destructor - unmaps the file (the code loaded from it can no longer be used)
+        ~BytecodeFile();
+
+        /// Calculates the checksum of a block of memory (64-bit FNV-1a).
+        /// \param data the block of memory
+        /// \param size size of the block in bytes
+        /// \return the checksum
+        static uint64_t checksum(const unsigned char *data, size_t size);
+
+        /// Stores the code into a bytecode file.
+        /// \param code the code generated by the parser
+        /// \param filename path to the output file
+        static void store(const FJP::GeneratedCode &code, const std::string &filename);
+
+        /// Stores the code into a bytecode file without terminating the program if it fails.
+        /// \param code the code generated by the parser
+        /// \param filename path to the output file
+        /// \return false if the file could not be written
+        static bool write(const FJP::GeneratedCode &code, const std::string &filename);
+
+        /// Loads the code from a bytecode file. The instructions stay within the mapped file,
+        /// so the code can only be used for as long as this object exists.
+        /// \param filename path to the bytecode file
+        /// \return the code stored within the file
+        FJP::GeneratedCode load(const std::string &filename);
+
+        /// Loads the code from a bytecode file without terminating the program if it fails.
+        /// \param filename path to the bytecode file
+        /// \param code the code stored within the file (left untouched if it cannot be loaded)
+        /// \return false if the file does not exist, or it is not a valid bytecode file
+        bool tryLoad(const std::string &filename, FJP::GeneratedCode &code);
+    };
+}
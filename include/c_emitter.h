@@ -0,0 +1,98 @@
+#pragma once
+
+#include <set>
+#include <string>
+#include <ostream>
+
+#include <code.h>
+
+namespace FJP {
+
+    /// This class translates the code generated by the parser into a self-contained C translation unit,
+    /// so programs run many times can be compiled ahead of time by an optimizing C compiler. Every instruction
+    /// is translated into a few C statements manipulating the same stack the virtual machine uses (frames, static
+    /// links, return addresses), so the program behaves exactly the same way, including all runtime errors.
+    /// Jumps are translated into gotos, and the return addresses are dispatched by a switch statement.
+    class CEmitter {
+    private:
+        /// Emitter error code (used when terminating the application).
+        static constexpr int ERR_CODE = 2;
+
+    private:
+        /// Program being translated.
+        const FJP::GeneratedCode &program;
+
+        /// Check the indexes of the LDX and STX instructions against the sizes of the arrays.
+        bool boundsChecking;
+
+        /// The program is known to fit in the stack (no need to check its growth).
+        bool stackBoundProven;
+
+        /// Number of slots of the stack.
+        int stackSize;
+
+        /// Addresses of all instructions that are jumped to (they get a label).
+        std::set<int> labels;
+
+        /// Addresses the functions return to (the instructions following the CAL instructions).
+        std::set<int> returnAddresses;
+
+        /// The data segment is accessed by some of the instructions (LDD, STD, CPD).
+        bool usesDataSegment;
+
+    private:
+        /// Determines the size of the stack exactly the way the virtual machine does.
+        void allocateStack();
+
+        /// Collects the addresses of all instructions that are jumped to
+        /// and finds out whether the data segment is used at all.
+        void findLabels();
+
+        /// Returns the expression calculating the base of the frame at the given level.
+        /// \param l level/depth relative to the current frame
+        /// \return C expression
+        static std::string base(int l);
+
+        /// Returns the label of an instruction.
+        /// \param address address of the instruction
+        /// \return name of the label
+        static std::string label(int address);
+
+        /// Returns the C operator of a comparison.
+        /// \param comparison type of the comparison (OPR_EQ ... OPR_GRT_EQ)
+        /// \return C operator
+        static const char *comparisonOperator(int comparison);
+
+        /// Writes out the stack check preceding an instruction pushing a value (if the stack is not proven).
+        /// \param out output stream
+        void emitPushCheck(std::ostream &out) const;
+
+        /// Writes out the declarations and helper functions preceding the main function.
+        /// \param out output stream
+        void emitPrologue(std::ostream &out) const;
+
+        /// Writes out the statements of a single instruction.
+        /// \param out output stream
+        /// \param address address of the instruction
+        void emitInstruction(std::ostream &out, int address) const;
+
+        /// Writes out the statements of an OPR instruction.
+        /// \param out output stream
+        /// \param m type of the operation
+        void emitOperation(std::ostream &out, int m) const;
+
+        /// Writes out the switch statement dispatching the return addresses and the end of the main function.
+        /// \param out output stream
+        void emitEpilogue(std::ostream &out) const;
+
+    public:
+        /// Constructor - creates an instance of the class
+        /// \param code the program to be translated
+        /// \param checkBounds check the indexes of arrays against their sizes (--check-bounds)
+        CEmitter(const FJP::GeneratedCode &code, bool checkBounds);
+
+        /// Translates the program and writes it out into a file.
+        /// \param filename path to the output file
+        void emit(const std::string &filename);
+    };
+}
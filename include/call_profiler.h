@@ -0,0 +1,74 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <iprofiler.h>
+
+namespace FJP {
+
+    /// This class implements a call-graph profiler. It keeps a shadow
+    /// call stack of the functions being executed and attributes every
+    /// executed instruction to the current call path. The call paths are
+    /// written out as collapsed stacks compatible with flame-graph tools.
+    class CallProfiler : public IProfiler {
+    private:
+        /// Output file containing the collapsed stacks (flame-graph input).
+        static constexpr const char *OUTPUT_FOLDED_FILE = "profile_calls.folded";
+
+        /// Output file containing the summary of the profile.
+        static constexpr const char *OUTPUT_FILE = "profile_calls.txt";
+
+        /// Profiler error code (used when terminating the application).
+        static constexpr int ERR_CODE = 3;
+
+        /// Definition of a node of the call tree. Each node represents
+        /// one call path, e.g. main -> fact -> fact.
+        struct CallNode {
+            int parent;                   ///< index of the parent node (-1 for the root)
+            int function;                 ///< first address of the function
+            uint64_t calls;               ///< number of times the path has been entered
+            uint64_t exclusive;           ///< instructions executed directly in the function
+            std::map<int, int> children;  ///< child nodes mapped by the first address of the function
+        };
+
+    private:
+        /// All nodes of the call tree (the first one is the main block).
+        std::vector<CallNode> nodes;
+
+        /// Index of the node (call path) that is currently being executed.
+        int currentNode;
+
+        /// Returns the call path of a node, e.g. main;fact;fact
+        /// \param node index of the node
+        /// \param program the program that has been executed (names of the functions)
+        /// \return call path of the node separated by semicolons
+        std::string getCallPath(int node, const FJP::GeneratedCode &program) const;
+
+        /// Checks whether the function of a node occurs among the ancestors of the node (recursion).
+        /// \param node index of the node
+        /// \return true/false depending on whether the function has been called recursively
+        bool isRecursiveCall(int node) const;
+
+    public:
+        /// Constructor - creates an instance of the class
+        CallProfiler();
+
+        /// Attributes the instruction to the current call path.
+        /// \param address address of the instruction
+        void instructionExecuted(int address) override;
+
+        /// Pushes the function onto the shadow call stack.
+        /// \param address the first address of the function
+        void functionCalled(int address) override;
+
+        /// Pops the current function off the shadow call stack.
+        void functionReturned() override;
+
+        /// Stores the collapsed stacks and the summary into the output files.
+        /// \param program the program that has been executed
+        void report(const FJP::GeneratedCode &program) override;
+    };
+}
@@ -1,11 +1,108 @@
 #pragma once
 
+#include <map>
+#include <string>
 #include <vector>
 
 #include <isa.h>
 
 namespace FJP {
 
+    /// Definition of an entry of the line table. An entry says that
+    /// all instructions starting at the given address (up to the address
+    /// of the following entry) were generated from the same line of the source code.
+    struct LineTableEntry {
+        int address;    ///< address of the first instruction of the range
+        int lineNumber; ///< number of the line in the source code
+    };
+
+    /// Definition of a function defined in the program.
+    /// Its instructions occupy the range [address, endAddress).
+    struct FunctionEntry {
+        std::string name; ///< name of the function
+        int endAddress;   ///< address right after the last instruction of the function
+    };
+
+    /// Definition of the stack requirement of a program computed at compile time.
+    /// If the program is recursive, the maximum depth does not include any recursive
+    /// call, and every level of the recursion adds levelCost slots on top of it.
+    struct StackBound {
+        bool known;     ///< the requirement could be determined statically
+        bool recursive; ///< the program contains recursion
+        int maxDepth;   ///< maximum value of the stack pointer
+        int levelCost;  ///< number of slots taken up by each level of recursion
+    };
+
+    /// Definition of a scalar operand of a vector loop. It is either
+    /// a constant or a variable stored within a frame.
+    struct VectorValue {
+        bool isVariable; ///< the value is stored in a variable (otherwise it is a constant)
+        int value;       ///< the constant
+        int level;       ///< level of the variable (relative to the loop)
+        int address;     ///< address of the variable within its frame
+    };
+
+    /// Definition of an array operand of a vector loop.
+    struct VectorArray {
+        bool inDataSegment; ///< the array is stored in the data segment
+        int level;          ///< level of the array (relative to the loop; unused for the data segment)
+        int address;        ///< address of the array within its frame or the data segment
+        int size;           ///< number of elements of the array
+    };
+
+    /// Definition of a loop replaced by a vector instruction. The vector instruction is placed
+    /// in front of the original loop followed by a JMP over it. The loop itself stays in the
+    /// code, and it is executed instead whenever the vector instruction cannot produce the
+    /// very same result (an index out of the bounds of an array, an arithmetic overflow).
+    struct VectorLoop {
+        bool foreachLoop;        ///< the loop goes over all elements of the first array (foreach)
+        VectorValue counter;     ///< counter of the for loop / temporary index of the foreach loop
+        VectorValue bound;       ///< value the counter of the for loop is compared against
+        bool inclusive;          ///< the condition of the for loop is 'counter <= bound'
+        VectorValue iterator;    ///< iterator of the foreach loop (gets the last element)
+        VectorValue target;      ///< variable accumulating the result (VSUM, VMIN, VMAX, VCMP)
+        VectorArray destination; ///< array being written (VADD, VMUL, VFILL)
+        VectorArray first;       ///< first source array
+        VectorArray second;      ///< second source array (VADD, VMUL, VCMP if secondIsArray)
+        bool secondIsArray;      ///< the right-hand side of the comparison is an array (VCMP)
+        VectorValue operand;     ///< value filled in (VFILL) or compared against (VCMP)
+        int comparison;          ///< type of the comparison (OPR_EQ ... OPR_GRT_EQ) (VCMP)
+        bool normalize;          ///< the value is converted into 1/0 (VFILL of a bool array)
+    };
+
+    /// Definition of a jump table used by the JTB instruction to dispatch a switch statement.
+    /// A dense table holds a target for every value from low up to low + targets.size() - 1
+    /// (the values with no case jump to the default target). A sparse table holds the case values
+    /// in ascending order along with their targets, and the value is looked up by a binary search.
+    struct JumpTable {
+        bool dense;                ///< the targets are indexed by the value itself (value - low)
+        int low;                   ///< the lowest case value (dense table)
+        std::vector<int> values;   ///< the case values in ascending order (sparse table)
+        std::vector<int> targets;  ///< addresses to jump to
+        int defaultTarget;         ///< address to jump to if no case matches the value
+    };
+
+    /// Definition of an in-place update of a variable by a constant (x += k, x -= k, x *= k)
+    /// used by the ADDVI, SUBVI, and MULVI instructions.
+    struct VariableUpdate {
+        int level;   ///< level of the variable (relative to the instruction)
+        int address; ///< address of the variable within its frame
+        int value;   ///< the constant
+    };
+
+    /// Instructions of a program converted into the packed form executed by the virtual machine.
+    struct PackedCode {
+        std::vector<PackedInstruction> instructions; ///< the packed instructions
+        std::vector<Instruction> wideInstructions;   ///< instructions whose level does not fit into the packed form
+    };
+
+    /// Packed instructions stored outside of the code (within a memory-mapped bytecode file).
+    struct PackedCodeView {
+        const PackedInstruction *instructions; ///< the packed instructions
+        const Instruction *wideInstructions;   ///< instructions whose level does not fit into the packed form
+        int size;                              ///< number of the packed instructions
+    };
+
     /// This class represents a code generated by the parser.
     /// The code is writen in an extended an slightly customized version
     /// of the PL0 programming language.
@@ -13,6 +110,60 @@ namespace FJP {
     private:
         std::vector<Instruction> code; ///< all instructions that make up the program
 
+        /// Packed instructions of a program loaded from a bytecode file. They are executed right from
+        /// the memory-mapped file (nullptr instructions if the code has been generated by the parser).
+        PackedCodeView mappedCode;
+
+        /// Line table mapping ranges of instructions onto the lines of the source code.
+        /// It is kept aside from the instructions themselves, so it does not affect fetching them.
+        std::vector<LineTableEntry> lineTable;
+
+        /// All functions defined in the program mapped by their first address.
+        std::map<int, FunctionEntry> functions;
+
+        /// Stack requirement of the program.
+        StackBound stackBound;
+
+        /// Number of slots of the data segment (arrays stored outside of the stack).
+        int dataSize;
+
+        /// Read-only constant pool holding the initial values of arrays. Each block starts
+        /// with a header (number of values, target address) followed by the values themselves.
+        std::vector<int> constantPool;
+
+        /// Loops replaced by vector instructions (addressed by the m parameter of the instructions).
+        std::vector<VectorLoop> vectorLoops;
+
+        /// Jump tables of switch statements (addressed by the m parameter of the JTB instructions).
+        std::vector<JumpTable> jumpTables;
+
+        /// In-place updates of variables by constants (addressed by the m parameter of the ADDVI, SUBVI, and MULVI instructions).
+        std::vector<VariableUpdate> variableUpdates;
+
+        /// Sizes of the arrays accessed by the LDX and STX instructions mapped by the addresses of the instructions.
+        /// Just like the line table, they are kept aside from the instructions, so they do not affect fetching them.
+        std::map<int, int> arraySizes;
+
+    private:
+        /// Moves the targets of the jumps (and calls, and jump tables) of all instructions placed
+        /// at or after the given position that target the address or anything after it.
+        /// \param position address of the first instruction whose targets are moved
+        /// \param address the lowest target being moved
+        /// \param count by how many instructions the targets are moved
+        void moveTargets(int position, int address, int count);
+
+        /// Keeps the array sizes in sync with the code after instructions have
+        /// been inserted (count > 0) or removed (count < 0) at the address.
+        /// \param address address of the first inserted or removed instruction
+        /// \param count number of the inserted instructions (negative if they were removed)
+        void moveArraySizes(int address, int count);
+
+        /// Keeps the functions in sync with the code after instructions have
+        /// been inserted (count > 0) or removed (count < 0) at the address.
+        /// \param address address of the first inserted or removed instruction
+        /// \param count number of the inserted instructions (negative if they were removed)
+        void moveFunctions(int address, int count);
+
     public:
         /// Constructor - creates an instance of the class
         GeneratedCode();
@@ -29,8 +180,166 @@ namespace FJP {
         /// \return returns the instruction
         Instruction &operator[](size_t index);
 
+        /// Overloaded [] operator for reading instructions as if the code was an array.
+        /// Instructions loaded from a bytecode file are unpacked on the fly.
+        /// \param index the index of the instruction we want to access
+        /// \return returns the instruction
+        Instruction operator[](size_t index) const;
+
+        /// Converts the instructions into the packed form executed by the virtual machine.
+        /// Unpacking them gives back the very same instructions.
+        /// \return the packed instructions
+        PackedCode pack() const;
+
+        /// Returns the packed instructions of a program loaded from a bytecode file.
+        /// \return the packed instructions (nullptr if the code has been generated by the parser)
+        const PackedCodeView *getMappedInstructions() const;
+
+        /// Makes the code use packed instructions stored outside of it (within a memory-mapped bytecode file).
+        /// The instructions have to outlive the code, and they are not supposed to be modified.
+        /// \param instructions the packed instructions
+        void mapInstructions(const PackedCodeView &instructions);
+
         /// Adds another instruction into the code.
         /// \param instruction the instruction that is about to be added into the code.
         void addInstruction(FJP::Instruction instruction);
+
+        /// Inserts instructions into the code. All instructions from the address onwards
+        /// are moved along, and so are their jumps (and jump tables) targeting the address
+        /// or anything after it, the line table, the array sizes, and the functions. Instructions placed before the address are
+        /// left untouched, so nothing placed there may jump past the address, and no function recorded so far may contain it.
+        /// \param address the address the instructions are inserted at
+        /// \param instructions the instructions to be inserted
+        void insertInstructions(int address, const std::vector<FJP::Instruction> &instructions);
+
+        /// Removes an instruction from the code. All instructions after it are moved back, and so are their
+        /// jumps (and jump tables) targeting anything after it, the line table, the array sizes, and the functions.
+        /// Jumps targeting the instruction itself now target the one that follows it. Just like
+        /// with insertInstructions, nothing placed before the address may jump past it.
+        /// \param address address of the instruction
+        void removeInstruction(int address);
+
+        /// Sets the line of the source code all instructions
+        /// added from now on are generated from.
+        /// \param lineNumber number of the line in the source code
+        void setLineNumber(int lineNumber);
+
+        /// Returns the line of the source code the instruction was generated from.
+        /// \param address address of the instruction
+        /// \return number of the line in the source code (-1 if it is not known)
+        int getLineNumber(int address) const;
+
+        /// Returns the line table of the code.
+        /// \return ranges of instructions mapped onto the lines of the source code
+        const std::vector<LineTableEntry> &getLineTable() const;
+
+        /// Sets the line table of the code (a program loaded from a bytecode file).
+        /// \param table ranges of instructions mapped onto the lines of the source code
+        void setLineTable(const std::vector<LineTableEntry> &table);
+
+        /// Records a function defined in the program.
+        /// \param address the first address of the function
+        /// \param endAddress address right after the last instruction of the function
+        /// \param name the name of the function
+        void addFunction(int address, int endAddress, const std::string &name);
+
+        /// Returns the name of the function starting at the given address.
+        /// \param address the first address of the function
+        /// \return the name of the function ("main" for the main block of the program)
+        std::string getFunctionName(int address) const;
+
+        /// Finds the innermost function the instruction belongs to. Nested functions
+        /// are placed within the range of their parent, hence the innermost one.
+        /// \param address address of an instruction
+        /// \return the first address of the function (0 for the main block of the program)
+        int findFunction(int address) const;
+
+        /// Returns all functions defined in the program.
+        /// \return functions mapped by their first address
+        const std::map<int, FunctionEntry> &getFunctions() const;
+
+        /// Allocates space for an array within the data segment.
+        /// \param size number of elements of the array
+        /// \return the address of the array within the data segment
+        int allocateData(int size);
+
+        /// Returns the size of the data segment.
+        /// \return number of slots of the data segment
+        int getDataSize() const;
+
+        /// Adds a block of values into the constant pool.
+        /// \param address the address the values are copied to (within a frame or the data segment)
+        /// \param values the values to be copied
+        /// \return the address of the block within the constant pool
+        int addConstants(int address, const std::vector<int> &values);
+
+        /// Returns the constant pool.
+        /// \return the constant pool of the program
+        const std::vector<int> &getConstantPool() const;
+
+        /// Adds a loop replaced by a vector instruction.
+        /// \param loop description of the loop
+        /// \return the index of the loop (the m parameter of the vector instruction)
+        int addVectorLoop(const VectorLoop &loop);
+
+        /// Returns a loop replaced by a vector instruction.
+        /// \param index the index of the loop
+        /// \return description of the loop
+        const VectorLoop &getVectorLoop(int index) const;
+
+        /// Returns all loops replaced by vector instructions.
+        /// \return description of the loops
+        const std::vector<VectorLoop> &getVectorLoops() const;
+
+        /// Adds a jump table of a switch statement.
+        /// \param table the jump table
+        /// \return the index of the table (the m parameter of the JTB instruction)
+        int addJumpTable(const JumpTable &table);
+
+        /// Returns a jump table of a switch statement.
+        /// \param index the index of the table
+        /// \return the jump table
+        const JumpTable &getJumpTable(int index) const;
+
+        /// Returns all jump tables of the program.
+        /// \return the jump tables
+        const std::vector<JumpTable> &getJumpTables() const;
+
+        /// Adds an in-place update of a variable by a constant.
+        /// \param update the update
+        /// \return the index of the update (the m parameter of the ADDVI, SUBVI, or MULVI instruction)
+        int addVariableUpdate(const VariableUpdate &update);
+
+        /// Returns an in-place update of a variable by a constant.
+        /// \param index the index of the update
+        /// \return the update
+        const VariableUpdate &getVariableUpdate(int index) const;
+
+        /// Returns all in-place updates of variables by constants.
+        /// \return the updates
+        const std::vector<VariableUpdate> &getVariableUpdates() const;
+
+        /// Records the size of the array accessed by an instruction (LDX, STX). This has to be
+        /// called right before the instruction is added into the code.
+        /// \param address address of the instruction
+        /// \param size number of elements of the array
+        void setArraySize(int address, int size);
+
+        /// Returns the size of the array accessed by an instruction.
+        /// \param address address of the instruction (LDX, STX)
+        /// \return number of elements of the array (-1 if it is not known)
+        int getArraySize(int address) const;
+
+        /// Returns the sizes of all arrays accessed by the LDX and STX instructions.
+        /// \return the sizes mapped by the addresses of the instructions
+        const std::map<int, int> &getArraySizes() const;
+
+        /// Sets the stack requirement of the program.
+        /// \param bound the stack requirement computed at compile time
+        void setStackBound(const StackBound &bound);
+
+        /// Returns the stack requirement of the program.
+        /// \return the stack requirement computed at compile time
+        const StackBound &getStackBound() const;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <filesystem>
+
+#include <code.h>
+#include <bytecode.h>
+
+namespace FJP {
+
+    /// This class implements a content-addressed cache of compiled programs (bytecode files). A program is
+    /// looked up by the hash of its source code and the identity of the compiler, so changing either of them
+    /// makes the cache miss. Each entry is written into a temporary file first and then renamed, so concurrent
+    /// processes never see a partially written one. Whenever an entry is added, the least recently used
+    /// entries are removed until the cache fits within its size limit.
+    class CompileCache {
+    private:
+        /// Maximum size of all entries of the cache in bytes (64 MB).
+        static constexpr uintmax_t MAX_SIZE = 64 * 1024 * 1024;
+
+        /// Age (in seconds) after which a temporary file is considered abandoned by a crashed process.
+        static constexpr int ABANDONED_AGE = 3600;
+
+        /// Extension of the entries of the cache.
+        static constexpr const char *EXTENSION = ".pl0b";
+
+    private:
+        /// Directory holding the entries (empty if the cache is disabled).
+        std::filesystem::path directory;
+
+        /// Hash of the program being compiled (empty if it is not known).
+        std::string key;
+
+    private:
+        /// Returns the directory of the cache. It can be set by FJP_CACHE_DIR, otherwise
+        /// it is placed in $XDG_CACHE_HOME/fjp or ~/.cache/fjp.
+        /// \return path to the directory (empty if none of the variables is set)
+        static std::filesystem::path defaultDirectory();
+
+        /// Returns a description of the compiler (the path, size, and modification time of its executable),
+        /// so rebuilding the compiler invalidates all entries compiled by the previous build.
+        /// \return description of the compiler
+        static std::string compilerIdentity();
+
+        /// Returns the path to the entry of the program being compiled.
+        /// \return path to the entry
+        std::filesystem::path entryPath() const;
+
+        /// Removes the least recently used entries until the cache fits within MAX_SIZE,
+        /// as well as temporary files left behind by crashed processes.
+        void evict();
+
+    public:
+        /// Constructor - creates an instance of the class
+        CompileCache();
+
+        /// Looks up the compiled program. On a hit, the entry is marked as the most recently used one.
+        /// \param sourceFile path to the source code of the program
+        /// \param file bytecode file the entry is loaded from (it has to outlive the code)
+        /// \param code the compiled program
+        /// \return true if the program has been found
+        bool load(const std::string &sourceFile, FJP::BytecodeFile &file, FJP::GeneratedCode &code);
+
+        /// Stores the compiled program looked up by the previous call of load. Failures are ignored,
+        /// as the program can always be compiled again.
+        /// \param code the compiled program
+        void store(const FJP::GeneratedCode &code);
+    };
+}
@@ -20,6 +20,10 @@ namespace FJP {
     namespace IOErrors {
         static constexpr const char *ERROR_00 = "input file not found";
         static constexpr const char *ERROR_01 = "could not open output file";
+        static constexpr const char *ERROR_02 = "could not create shared memory segment";
+        static constexpr const char *ERROR_03 = "not a bytecode file";
+        static constexpr const char *ERROR_04 = "unsupported version of the bytecode file";
+        static constexpr const char *ERROR_05 = "bytecode file is corrupted";
     }
 
     /// Compilation error messages. These messages are used at compile time.
@@ -69,6 +73,7 @@ namespace FJP {
         static constexpr const char *ERROR_43 = "name is already taken";
         static constexpr const char *ERROR_44 = "missing identifier";
         static constexpr const char *ERROR_45 = "symbol not found";
+        static constexpr const char *ERROR_46 = "data segment is too large";
     }
 
     /// Runtime error messages. These messages are used at runtime.
@@ -76,5 +81,6 @@ namespace FJP {
         static constexpr const char *ERROR_00 = "stack overflow error";
         static constexpr const char *ERROR_01 = "arithmetic exception: division by zero error";
         static constexpr const char *ERROR_02 = "arithmetic exception: integer overflow";
+        static constexpr const char *ERROR_03 = "array index out of bounds";
     }
 }
\ No newline at end of file
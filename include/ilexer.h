@@ -16,15 +16,20 @@ namespace FJP {
         /// for parsing it.
         /// \param filename path to the input file (source code)
         /// \param debug if this flag is on, the tokens will be output into a file in a JSON format.
-        virtual void init(std::string filename, bool debug = false) = 0;
+        /// \param tokenDumpFile path to the binary dump of the tokens (none if it is empty)
+        virtual void init(std::string filename, bool debug = false, const std::string &tokenDumpFile = "") = 0;
 
-        /// Returns the next token. All tokens have been parsed
-        /// beforehand and they are no trodden as a stream. This
-        /// method is called by the parser when performing a recursive descent.
+        /// Returns the next token. The tokens are parsed on demand as
+        /// the stream is being trodden. This method is called by the parser
+        /// when performing a recursive descent.
         /// \return the next token in the stream of tokens.
         virtual FJP::Token getNextToken() = 0;
 
         /// Goes back one token within the stream of tokens.
         virtual void returnToPreviousToken() = 0;
+
+        /// Parses the rest of the input file the parser has not asked for,
+        /// so a lexical error within it is still reported.
+        virtual void finish() = 0;
     };
 }
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <code.h>
+
+namespace FJP {
+
+    /// This class represents the interface of a profiler.
+    /// A profiler is attached to the virtual machine which notifies
+    /// it about the events happening while a program is being executed.
+    class IProfiler {
+    public:
+        /// Called right before an instruction is executed.
+        /// \param address address of the instruction
+        virtual void instructionExecuted(int address) = 0;
+
+        /// Called when a function is called (CAL instruction).
+        /// \param address the first address of the function
+        virtual void functionCalled(int address) = 0;
+
+        /// Called when the program returns from a function (OPR_RET).
+        virtual void functionReturned() = 0;
+
+        /// Called once the execution of the program has finished.
+        /// \param program the program that has been executed
+        virtual void report(const FJP::GeneratedCode &program) = 0;
+    };
+}
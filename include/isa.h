@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
 
 namespace FJP {
@@ -18,7 +19,43 @@ namespace FJP {
         JPC,     ///< Conditional jump. It jumps if there is a 1 on the top of the stack (result of an operation).
         SIO,     ///< System I/O operation (read/write).
         LDA,     ///< Loads data on the top of the stack from an address which is stored on the top of the stack.
-        STA      ///< Stores the value which is on the top of the stack at the address which is at the second position from the top of the stack.
+        STA,     ///< Stores the value which is on the top of the stack at the address which is at the second position from the top of the stack.
+        LDD,     ///< Loads an element of an array stored in the data segment (the index is on the top of the stack).
+        STD,     ///< Stores the value on the top of the stack into an element of an array stored in the data segment (the index is below the value).
+        CPY,     ///< Copies a block of values from the constant pool into a frame (array initialization).
+        CPD,     ///< Copies a block of values from the constant pool into the data segment (array initialization).
+        VADD,    ///< Vector loop - adds up two arrays element-wise (a[i] := b[i] + c[i]).
+        VMUL,    ///< Vector loop - multiplies two arrays element-wise (a[i] := b[i] * c[i]).
+        VSUM,    ///< Vector loop - adds up the elements of an array into a variable (s := s + a[i]).
+        VMIN,    ///< Vector loop - finds the minimum of an array and a variable (if (a[i] < m) m := a[i]).
+        VMAX,    ///< Vector loop - finds the maximum of an array and a variable (if (a[i] > m) m := a[i]).
+        VCMP,    ///< Vector loop - counts the elements of an array satisfying a comparison (if (a[i] < x) c := c + 1).
+        VFILL,   ///< Vector loop - fills up an array with a value (a[i] := x).
+        JTB,     ///< Indexed jump - pops a value and jumps to its target within a jump table (switch).
+        JEQ,     ///< Pops two values and jumps if x == y.
+        JNE,     ///< Pops two values and jumps if x != y.
+        JLT,     ///< Pops two values and jumps if x < y.
+        JLE,     ///< Pops two values and jumps if x <= y.
+        JGT,     ///< Pops two values and jumps if x > y.
+        JGE,     ///< Pops two values and jumps if x >= y.
+        JEQI,    ///< Pops a value and jumps if x == l (immediate operand).
+        JNEI,    ///< Pops a value and jumps if x != l (immediate operand).
+        JLTI,    ///< Pops a value and jumps if x < l (immediate operand).
+        JLEI,    ///< Pops a value and jumps if x <= l (immediate operand).
+        JGTI,    ///< Pops a value and jumps if x > l (immediate operand).
+        JGEI,    ///< Pops a value and jumps if x >= l (immediate operand).
+        ADDI,    ///< Adds m (immediate operand) to the value on the top of the stack.
+        SUBI,    ///< Subtracts m (immediate operand) from the value on the top of the stack.
+        MULI,    ///< Multiplies the value on the top of the stack by m (immediate operand).
+        CMPI,    ///< Compares the value on the top of the stack with m (immediate operand), l is the type of the comparison.
+        ADDV,    ///< Pops a value and adds it to the variable at the address (in-place update, x += y).
+        SUBV,    ///< Pops a value and subtracts it from the variable at the address (in-place update, x -= y).
+        MULV,    ///< Pops a value and multiplies the variable at the address by it (in-place update, x *= y).
+        ADDVI,   ///< Adds a constant to a variable (in-place update, x += k), m is the index of the update.
+        SUBVI,   ///< Subtracts a constant from a variable (in-place update, x -= k), m is the index of the update.
+        MULVI,   ///< Multiplies a variable by a constant (in-place update, x *= k), m is the index of the update.
+        LDX,     ///< Pops an index and loads the element of an array stored within a frame, m is the base address of the array.
+        STX      ///< Stores the value on the top of the stack into an element of an array stored within a frame (the index is below the value), m is the base address of the array.
     };
 
     /// Enumeration of different operations supported
@@ -58,12 +95,79 @@ namespace FJP {
         int m;           ///< the second parameter of the instruction (constance value, type of an operation, address, etc.)
     };
 
+    /// Packed 8-byte form of an instruction executed by the virtual machine. Bits 0-7 hold the OP code,
+    /// bits 8-31 hold the level as a signed 24-bit number, and bits 32-63 hold the parameter m.
+    /// An instruction whose level does not fit into 24 bits (e.g. a large immediate of JEQI)
+    /// is kept aside in a table of wide instructions. Its packed form holds PACKED_WIDE
+    /// as the OP code and the index into the table as the parameter m.
+    using PackedInstruction = uint64_t;
+
+    /// Number of bits of the level of a packed instruction.
+    constexpr int PACKED_L_BITS = 24;
+
+    /// OP code of a packed instruction referring to the table of wide instructions (no real OP code is 0).
+    constexpr uint32_t PACKED_WIDE = 0;
+
+    /// Checks whether a value is one of the OP codes (e.g. an OP code read from a bytecode file).
+    /// \param value the value
+    /// \return true if the value lies between LIT and STX
+    bool is_op_code(uint32_t value);
+
+    /// Checks whether an instruction can be packed without using the table of wide instructions.
+    /// \param instruction the instruction
+    /// \return true if its level fits into PACKED_L_BITS bits
+    bool fits_packed(const Instruction &instruction);
+
+    /// Packs an instruction.
+    /// \param instruction the instruction (fits_packed must hold)
+    /// \return the packed form of the instruction
+    PackedInstruction pack_instruction(const Instruction &instruction);
+
+    /// Packs a reference to an entry of the table of wide instructions.
+    /// \param index index of the wide instruction within the table
+    /// \return the packed form of the reference
+    PackedInstruction pack_wide_instruction(int index);
+
+    /// Unpacks an instruction. It is defined here, so it can be inlined into the fetch cycle of the virtual machine.
+    /// \param packed the packed form of the instruction
+    /// \param wideInstructions table of wide instructions
+    /// \return the original instruction
+    inline Instruction unpack_instruction(PackedInstruction packed, const Instruction *wideInstructions) {
+        uint32_t low = static_cast<uint32_t>(packed);
+        int m = static_cast<int32_t>(static_cast<uint32_t>(packed >> 32));
+        if ((low & 0xFF) == PACKED_WIDE) {
+            return wideInstructions[m];
+        }
+        return {static_cast<OP_CODE>(low & 0xFF), static_cast<int32_t>(low) >> (32 - PACKED_L_BITS), m};
+    }
+
     /// Prints out an instructions
     /// \param out the output stream the instruction will be printed out into.
     /// \param instruction the instruction itself
     /// \return modified output stream (extended by the instruction)
     std::ostream &operator<<(std::ostream &out, const Instruction &instruction);
 
+    /// Returns the compare-and-branch instruction jumping if a comparison holds.
+    /// \param comparison type of the comparison (OPR_EQ ... OPR_GRT_EQ)
+    /// \param immediate the second operand is an immediate value (otherwise it is on the stack)
+    /// \return OP code of the instruction
+    OP_CODE branch_on(int comparison, bool immediate);
+
+    /// Returns the comparison a compare-and-branch instruction jumps on.
+    /// \param op the OP code of the instruction
+    /// \return type of the comparison (OPR_EQ ... OPR_GRT_EQ), or -1 if the instruction is not a compare-and-branch
+    int branch_comparison(OP_CODE op);
+
+    /// Returns true if the compare-and-branch instruction takes its second operand from the l parameter.
+    /// \param op the OP code of the instruction
+    /// \return true if the instruction compares against an immediate value
+    bool is_immediate_branch(OP_CODE op);
+
+    /// Returns the comparison which holds if and only if the given one does not.
+    /// \param comparison type of the comparison (OPR_EQ ... OPR_GRT_EQ)
+    /// \return type of the negated comparison
+    int negate_comparison(int comparison);
+
     /// Converts an OP code into a string value. This method
     /// is used when an instruction is being printed out.
     /// \param op the OP code of the instruction
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <code.h>
+#include <iprofiler.h>
+#include <live_stats.h>
+#include <sampling_profiler.h>
 
 namespace FJP {
 
@@ -13,5 +16,25 @@ namespace FJP {
         /// \param program the instance of a program to be executed
         /// \param debug flag if want to create an output file - stacktrace.txt
         virtual void execute(FJP::GeneratedCode &program, bool debug = false) = 0;
+
+        /// Attaches a profiler to the virtual machine. The profiler will be
+        /// notified about the events happening while a program is being executed.
+        /// \param profiler the profiler to be attached
+        virtual void addProfiler(FJP::IProfiler *profiler) = 0;
+
+        /// Sets a sampling profiler which will periodically take samples
+        /// of the virtual machine while a program is being executed.
+        /// \param profiler the sampling profiler (nullptr turns sampling off)
+        virtual void setSamplingProfiler(FJP::SamplingProfiler *profiler) = 0;
+
+        /// Sets the object publishing live statistics of the virtual
+        /// machine while a program is being executed.
+        /// \param stats live statistics (nullptr turns them off)
+        virtual void setLiveStats(FJP::LiveStats *stats) = 0;
+
+        /// Turns on/off checking the indexes of arrays stored within frames against
+        /// their sizes. Otherwise, an index is only checked not to point out of the stack.
+        /// \param enabled check the bounds of the arrays
+        virtual void setBoundsChecking(bool enabled) = 0;
     };
 }
\ No newline at end of file
@@ -1,16 +1,31 @@
 #pragma once
 
-#include <list>
-#include <unordered_set>
+#include <array>
+#include <memory>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <string_view>
+#include <unordered_map>
 
 #include <ilexer.h>
 #include <token.h>
+#include <scanner.h>
+#include <source_file.h>
+#include <token_queue.h>
+#include <token_writer.h>
 
 namespace FJP {
 
     /// This class implements the functionality of a lexer.
     /// It takes an input file and converts it into a stream
-    /// of tokens which are then consumed by the parser.
+    /// of tokens which are then consumed by the parser. The tokens
+    /// are parsed on demand, and only the last few of them are kept,
+    /// so the memory used does not grow with the size of the file.
+    /// A large file is split into chunks instead, which are lexed
+    /// on several threads ahead of the parser (see splitIntoChunks),
+    /// and a smaller one is lexed on a thread of its own while the
+    /// parser is consuming the tokens (see startPipeline).
     class Lexer : public ILexer {
     private:
         /// Lexer error code (used when terminating the application).
@@ -19,40 +34,103 @@ namespace FJP {
         /// Output file containing tokens in a JSON format.
         static constexpr const char *OUTPUT_FILE = "tokens.json";
 
-    private:
-        /// Characters used to indicate the start of a comment.
-        static constexpr const char *COMMENT_START = "/*";
-
-        /// Characters used to indicate the end of a comment.
-        static constexpr const char *COMMENT_END   = "*/";
+        /// Environment variable overriding the number of threads the input file is lexed on.
+        static constexpr const char *THREADS_VARIABLE = "FJP_LEXER_THREADS";
+
+        /// Minimal size of a chunk of the input file lexed on its own thread (in bytes).
+        static constexpr long MIN_CHUNK_SIZE = 1024 * 1024;
+
+        /// Minimal size of the input file lexed on a thread of its own while the parser is consuming
+        /// the tokens (in bytes). Lexing a smaller one takes less time than starting the thread.
+        static constexpr long MIN_PIPELINE_SIZE = 64 * 1024;
+
+        /// Size of the input file from which it is no longer split into chunks (the tokens
+        /// of a chunk refer to their values by 32-bit offsets and 24-bit lengths).
+        static constexpr size_t MAX_SPLIT_SIZE = 1ul << 32;
+
+        /// Token parsed from a chunk of the input file in a compact form (turned back into a Token
+        /// when it is passed on to the parser), so the tokens of a chunk take up less memory.
+        struct ChunkToken {
+            uint32_t offset;         ///< offset of the value of the token within the chunk
+            uint32_t length : 24;    ///< length of the value of the token
+            uint32_t tokenType : 8;  ///< type of the token
+            int32_t lineNumber;      ///< number of the line within the chunk
+            int32_t value;           ///< value of a number, or ID of an identifier within the chunk
+        };
+
+        /// Chunk of the input file lexed on its own thread.
+        struct Chunk {
+            std::string_view text;          ///< the chunk (it ends with a white character unless it is the last one)
+            bool last;                      ///< flag indicating that the chunk ends at the end of the input file
+            FJP::Scanner scanner;           ///< scanner of the chunk (line numbers and IDs are local to the chunk)
+            std::vector<ChunkToken> tokens; ///< tokens parsed from the chunk
+            bool failed;                    ///< flag indicating that a lexical error follows the tokens
+            bool unclosedComment;           ///< flag indicating that a comment runs past the end of the chunk
+            std::thread worker;             ///< thread lexing the chunk
+        };
 
-        /// Maximum allowed length of an identifier.
-        static constexpr int MAX_IDENTIFIER_LEN = 16;
+    private:
+        /// Number of the tokens kept in the ring (the parser can go back by up to HISTORY_SIZE tokens).
+        static constexpr long HISTORY_SIZE = 16;
 
         /// The instance of the class.
         static Lexer *instance;
 
-        /// Current index (pointer) within the source input file
-        /// (which character is currently being processed)
-        long currentCharIndex;
+        /// The input file (memory-mapped if possible).
+        FJP::SourceFile sourceFile;
+
+        /// The content of the input file (followed by '\0').
+        std::string_view fileContent;
+
+        /// Scanner of the whole input file (unless it is split into chunks).
+        FJP::Scanner scanner;
+
+        /// Chunks of the input file (empty unless the file is split into chunks).
+        std::vector<std::unique_ptr<Chunk>> chunks;
+
+        /// Index of the chunk the tokens are currently taken from.
+        size_t chunkIndex;
+
+        /// Index of the next token within the current chunk.
+        size_t chunkTokenIndex;
+
+        /// Number of the lines preceding the current chunk.
+        int chunkLineOffset;
+
+        /// IDs of the identifiers of the current chunk mapped onto the IDs within the whole file.
+        std::vector<int> chunkIdentifierIds;
+
+        /// Flag indicating that the input file is being lexed on a thread of its own.
+        bool pipelined;
+
+        /// Tokens lexed on the thread of its own, which have not been taken by the parser yet.
+        FJP::TokenQueue tokenQueue;
+
+        /// Thread lexing the input file (if it is pipelined).
+        std::thread producer;
 
-        /// Current line within the input file, so we can keep
-        /// track of which token is on which line.
-        int currentLineNumber;
+        /// Flag indicating that a lexical error follows the tokens in the queue
+        /// (written by the producer before the queue is closed).
+        bool producerFailed;
 
-        /// The content of the input file.
-        /// TODO it'd be better if the file was read as a stream instead.
-        std::string fileContent;
+        /// Ring of the last tokens parsed from the input file
+        /// (the token number i is stored at the index i % HISTORY_SIZE).
+        std::array<Token, HISTORY_SIZE> tokenRing;
 
-        /// List of all tokens extracted from the input file.
-        std::list<Token> tokens;
+        /// Number of the tokens parsed from the input file so far.
+        long tokenCount;
 
-        /// Iterator used to send tokens off to the parser when requested.
-        std::list<Token>::const_iterator currentTokenIt;
+        /// Number of the token that is going to be sent off to the parser next.
+        long tokenPosition;
 
-        /// Helper set of alphabetic keywords of the language.
-        /// It is used to find keywords in the input file.
-        std::unordered_set<std::string> alphabetic_keywords;
+        /// IDs of the identifiers found in the input file mapped by their names (if it is split into chunks).
+        std::unordered_map<std::string_view, int> identifierIds;
+
+        /// Output file containing tokens in a JSON format (open only if the debug flag is on).
+        FJP::TokenWriter outputJSONFile;
+
+        /// Binary dump of the tokens (open only if it has been requested).
+        FJP::TokenWriter outputDumpFile;
 
     private:
         /// Construction - creates an instance of the class
@@ -64,34 +142,72 @@ namespace FJP {
         /// Delete assign operator of the class
         void operator=(Lexer const &) = delete;
 
-        /// Processes all tokens. It goes thought the input file
-        /// in order to parse it into tokens.
-        /// \param debug flag if we want to output the tokens into a JSON format
-        void processAllTokens(bool debug);
+        /// Parses the next token from the input file into the ring
+        /// (and writes it into the output files if they are open).
+        void produceToken();
+
+        /// Finishes the output files containing tokens.
+        void closeOutputFile();
+
+        /// Finishes the output files when the application terminates (even due to an error),
+        /// so they contain all tokens parsed up to that point.
+        static void closeOutputFileAtExit();
+
+        /// Returns the number of threads the input file can be lexed on (the number of cores,
+        /// unless it is overridden by the FJP_LEXER_THREADS environment variable).
+        /// \return number of threads
+        static unsigned threadCount();
+
+        /// Finds the positions the input file can be split at. A fast prepass over the
+        /// delimiters of comments tracks their depth, so the file is only split outside
+        /// comments, right where a token starts after a white character.
+        /// \param count number of chunks the file is supposed to be split into
+        /// \return positions the chunks start at (except the first one)
+        std::vector<long> findChunkBoundaries(size_t count) const;
 
-        /// Parses a next token. This method is periodically used
-        /// in the processAllTokens method.
-        /// \return next token that was parsed from the input file.
-        FJP::Token parseNextToken();
+        /// Splits the input file into chunks and starts lexing each of them on its own thread.
+        /// \param count number of chunks the file is supposed to be split into
+        void splitIntoChunks(size_t count);
 
-        /// Skips all white characters in the input file.
-        void skipWhiteCharacters();
+        /// Parses all tokens of a chunk (run on a thread of its own).
+        /// \param chunk the chunk
+        static void lexChunk(Chunk *chunk);
 
-        /// Skips all comments in the input file.
-        void skipComments();
+        /// Stores a token parsed from a chunk in the compact form.
+        /// \param chunk the chunk
+        /// \param token the token
+        static void addChunkToken(Chunk *chunk, const FJP::Token &token);
 
-        /// Keeps consuming characters from the input file as long as
-        /// the validation_fce is satisfied. For example, this is used
-        /// when parsing numbers or variable names - keep consuming
-        /// characters as long as they are digits.
-        /// param validation_fce validation function used to consume characters
-        /// \return the result of the consumption of the input characters (name, number, ...)
-        std::string getValue(int (validation_fce)(int));
+        /// Moves on to the next chunk (waiting for it to be lexed). Its line numbers and
+        /// the IDs of its identifiers are adjusted to the whole file as the tokens are taken.
+        /// If a comment runs past the end of the chunk, the rest of the file is lexed as a whole.
+        /// \param index index of the chunk
+        void enterChunk(size_t index);
+
+        /// Waits for all chunks to be lexed and releases them.
+        void releaseChunks();
+
+        /// Starts lexing the input file on a thread of its own. The tokens are passed over
+        /// to the parser through a lock-free queue, and the last few of them are still kept
+        /// in the ring, so the parser can go back just like before.
+        void startPipeline();
+
+        /// Parses all tokens of the input file into the queue (run on a thread of its own).
+        void lexIntoQueue();
+
+        /// Stops the thread lexing the input file (if it is pipelined).
+        void stopPipeline();
+
+        /// Reports a lexical error and terminates the application.
+        /// \param error the error
+        /// \param lineOffset number of the lines preceding the scanned text
+        void reportError(const FJP::LexicalError &error, int lineOffset);
 
         /// Returns true/false depending on whether the whole
-        /// input file has been processed or not.
+        /// input file has been processed or not (waiting for the
+        /// next token if the file is being lexed on another thread).
         /// \return true/false - depending on whether it's the end of file.
-        bool isEndOfFile() const;
+        bool isEndOfFile();
 
     public:
         /// Returns the instance of the class.
@@ -103,15 +219,20 @@ namespace FJP {
         /// for parsing it.
         /// \param filename path to the input file (source code)
         /// \param debug if this flag is on, the tokens will be output into a file in a JSON format.
-        void init(std::string filename, bool debug = false) override;
+        /// \param tokenDumpFile path to the binary dump of the tokens (none if it is empty)
+        void init(std::string filename, bool debug = false, const std::string &tokenDumpFile = "") override;
 
-        /// Returns the next token. All tokens have been parsed
-        /// beforehand and they are no trodden as a stream. This
-        /// method is called by the parser when performing a recursive descent.
+        /// Returns the next token. The tokens are parsed on demand as
+        /// the stream is being trodden. This method is called by the parser
+        /// when performing a recursive descent.
         /// \return the next token in the stream of tokens.
         FJP::Token getNextToken() override;
 
         /// Goes back one token within the stream of tokens.
         void returnToPreviousToken() override;
+
+        /// Parses the rest of the input file the parser has not asked for,
+        /// so a lexical error within it is still reported.
+        void finish() override;
     };
 }
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <iprofiler.h>
+
+namespace FJP {
+
+    /// This class implements a source-line profiler. It counts how many
+    /// times each instruction has been executed and, using the line table
+    /// of the program, it reports the number of instructions executed
+    /// per line of the source code in an annotated-source format.
+    class LineProfiler : public IProfiler {
+    private:
+        /// Output file containing the annotated source code.
+        static constexpr const char *OUTPUT_FILE = "profile_lines.txt";
+
+        /// Profiler error code (used when terminating the application).
+        static constexpr int ERR_CODE = 3;
+
+    private:
+        /// Path to the source code of the program being profiled.
+        std::string sourceFile;
+
+        /// Number of times each instruction has been executed (indexed by address).
+        std::vector<uint64_t> executionCounts;
+
+    public:
+        /// Constructor - creates an instance of the class
+        /// \param filename path to the source code of the program being profiled
+        explicit LineProfiler(std::string filename);
+
+        /// Increments the execution count of the instruction.
+        /// \param address address of the instruction
+        void instructionExecuted(int address) override;
+
+        /// Function calls are not relevant to the line profiler.
+        void functionCalled(int address) override;
+
+        /// Returns from functions are not relevant to the line profiler.
+        void functionReturned() override;
+
+        /// Aggregates the execution counts by lines and stores
+        /// the annotated source code into the output file.
+        /// \param program the program that has been executed
+        void report(const FJP::GeneratedCode &program) override;
+    };
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include <code.h>
+#include <vm_stats.h>
+
+namespace FJP {
+
+    /// This class publishes live statistics of the virtual machine through a POSIX
+    /// shared memory segment (/fjp.<pid>), so they can be watched by fjp-top while
+    /// a program is running. The virtual machine only calls publish() at back-edges,
+    /// calls, returns, and I/O operations, so the overhead stays low. While it is active,
+    /// sending SIGUSR1 to the process dumps the current frames of the stack to stderr.
+    /// The signal handler never touches the registers or the stack of the virtual machine.
+    /// It only flags the request (atomic), and the virtual machine writes the dump
+    /// itself the next time it publishes the statistics.
+    class LiveStats {
+    private:
+        /// Number of slots of a frame printed out by the stack dump.
+        static constexpr int MAX_DUMPED_SLOTS = 16;
+
+        /// Maximum number of frames printed out by the stack dump.
+        static constexpr int MAX_DUMPED_FRAMES = 64;
+
+    private:
+        /// The instance of the class.
+        static LiveStats *instance;
+
+        /// Statistics mapped into the shared memory (nullptr if it is not active).
+        FJP::VMStats *stats;
+
+        /// Name of the shared memory segment.
+        std::string name;
+
+        /// Names of the functions mapped by their first address. They are copied
+        /// out before the execution, so the stack dump does not need to allocate.
+        std::vector<std::pair<int, std::string>> functionNames;
+
+        /// Program and the stack of the virtual machine being watched (accessed only by the virtual machine).
+        const FJP::GeneratedCode *program;
+        const int *stackMemory;
+        int stackSize;
+
+        /// Set by the signal handler when a stack dump is requested.
+        std::atomic<int> dumpRequested;
+
+        // The signal handler may only access lock-free atomic objects.
+        static_assert(std::atomic<int>::is_always_lock_free, "the live statistics require lock-free atomic integers");
+
+    private:
+        /// Constructor - creates an instance of the class
+        LiveStats();
+
+        /// Delete copy constructor of the class
+        LiveStats(LiveStats &) = delete;
+
+        /// Delete assign operator of the class
+        void operator=(LiveStats const &) = delete;
+
+        /// Signal handler (SIGUSR1) - requests a dump of the frames of the stack.
+        /// \param signal number of the signal
+        static void handleSignal(int signal);
+
+        /// Writes the frames of the stack out to stderr.
+        /// \param eip instruction pointer of the virtual machine
+        /// \param ebp base pointer of the virtual machine
+        /// \param esp stack pointer of the virtual machine
+        void dumpStack(int eip, int ebp, int esp) const;
+
+        /// Returns the name of the function starting at the given address.
+        /// \param address the first address of the function
+        /// \return the name of the function
+        const char *getFunctionName(int address) const;
+
+    public:
+        /// Returns the instance of the class.
+        /// \return the instance of the class
+        static LiveStats *getInstance();
+
+        /// Creates the shared memory segment and installs the SIGUSR1 handler.
+        /// \param code the program that is about to be executed
+        /// \param stack the stack of the virtual machine
+        /// \param size size of the stack
+        void start(const FJP::GeneratedCode &code, const int *stack, int size);
+
+        /// Publishes the current statistics. If a stack dump has been requested, it is written out as well.
+        /// \param instructions number of instructions executed so far
+        /// \param eip instruction pointer of the virtual machine
+        /// \param ebp base pointer of the virtual machine
+        /// \param esp current value of the stack pointer
+        /// \param peakESP highest value of the stack pointer so far
+        /// \param callDepth number of active function calls
+        /// \param reads number of SIO read operations
+        /// \param writes number of SIO write operations
+        void publish(uint64_t instructions, int eip, int ebp, int esp, int peakESP, int callDepth, uint64_t reads, uint64_t writes);
+
+        /// Marks the execution as finished, removes the shared memory
+        /// segment, and restores the default SIGUSR1 handler.
+        void stop();
+    };
+}
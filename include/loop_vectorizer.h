@@ -0,0 +1,148 @@
+#pragma once
+
+#include <vector>
+
+#include <code.h>
+
+namespace FJP {
+
+    /// This class recognizes simple loops over arrays in the code generated by the parser and
+    /// puts a vector instruction (VADD, VMUL, VSUM, VMIN, VMAX, VCMP, VFILL) in front of them.
+    /// The vector instruction processes the whole loop at once and jumps over it. If it cannot
+    /// guarantee the same result (the counter goes beyond the bounds of an array, an arithmetic
+    /// operation overflows), it falls through to the original loop instead. The recognized loops
+    /// are (for loops counting up by one, or foreach loops using the iterator instead of a[i]):
+    ///
+    ///     s := s + a[i];                       VSUM (also s += a[i])
+    ///     if (a[i] < m) m := a[i];             VMIN (also <=)
+    ///     if (a[i] > m) m := a[i];             VMAX (also >=)
+    ///     if (a[i] <op> x) c := c + 1;         VCMP (x is a constant, a variable, or b[i]; also c++)
+    ///     a[i] := b[i] + c[i];                 VADD (for loops only)
+    ///     a[i] := b[i] * c[i];                 VMUL (for loops only)
+    ///     a[i] := x;                           VFILL (for loops only)
+    class LoopVectorizer {
+    private:
+        /// Code being matched.
+        const FJP::GeneratedCode *program;
+
+        /// Address the instructions being matched must lie before.
+        int limit;
+
+        /// Description of the loop being matched.
+        FJP::VectorLoop loop;
+
+    private:
+        /// Matches an instruction with the given OP code and parameters.
+        /// \param position address of the instruction (moved past it if it matches)
+        /// \param op expected OP code
+        /// \param l expected level
+        /// \param m expected parameter
+        /// \return true if the instruction matches
+        bool matchInstruction(int &position, FJP::OP_CODE op, int l, int m);
+
+        /// Matches an instruction (LOD, STO) accessing a variable.
+        /// \param position address of the instruction (moved past it if it matches)
+        /// \param op expected OP code
+        /// \param variable the variable accessed by the instruction
+        /// \return true if the instruction matches
+        bool matchVariable(int &position, FJP::OP_CODE op, FJP::VectorValue &variable);
+
+        /// Matches a constant (LIT) or a variable (LOD).
+        /// \param position address of the instruction (moved past it if it matches)
+        /// \param value the constant or the variable
+        /// \return true if the instruction matches
+        bool matchValue(int &position, FJP::VectorValue &value);
+
+        /// Matches an instruction (ADDVI) adding one to a variable in place.
+        /// \param position address of the instruction (moved past it if it matches)
+        /// \param variable the variable updated by the instruction
+        /// \return true if the instruction matches
+        bool matchIncrement(int &position, FJP::VectorValue &variable);
+
+        /// Matches an OPR instruction.
+        /// \param position address of the instruction (moved past it if it matches)
+        /// \param type type of the operation
+        /// \return true if the instruction matches
+        bool matchOperation(int &position, int &type);
+
+        /// Matches a compare-and-branch instruction.
+        /// \param position address of the instruction (moved past it if it matches)
+        /// \param immediate the instruction is expected to compare against an immediate operand
+        /// \param target expected target of the jump
+        /// \param comparison the comparison guarding the code the jump skips (the negation of the one it jumps on)
+        /// \param operand the immediate operand
+        /// \return true if the instruction matches
+        bool matchBranch(int &position, bool immediate, int target, int &comparison, int &operand);
+
+        /// Matches a comparison of the value on the top of the stack against a constant or a variable
+        /// followed by a jump taken if it does not hold.
+        /// \param position address of the first instruction (moved past the jump if it matches)
+        /// \param target expected target of the jump
+        /// \param comparison type of the comparison
+        /// \param operand the constant or the variable
+        /// \return true if the instructions match
+        bool matchCondition(int &position, int target, int &comparison, FJP::VectorValue &operand);
+
+        /// Matches the index of the current element (the counter).
+        /// \param position address of the instruction (moved past it if it matches)
+        /// \return true if the instruction matches
+        bool matchIndex(int &position);
+
+        /// Matches an instruction accessing the current element of an array.
+        /// \param position address of the instruction (moved past it if it matches)
+        /// \param load the element is loaded (LDX, LDD) or stored (STX, STD)
+        /// \param array the array
+        /// \return true if the instruction matches
+        bool matchAccess(int &position, bool load, FJP::VectorArray &array);
+
+        /// Matches loading of the current element of an array (a[i] or the iterator of a foreach loop).
+        /// \param position address of the first instruction (moved past the element if it matches)
+        /// \param array the array
+        /// \return true if the instructions match
+        bool matchElement(int &position, FJP::VectorArray &array);
+
+        /// Matches the body of a loop against all supported shapes.
+        /// \param position address of the first instruction of the body
+        /// \param op OP code of the vector instruction replacing the loop
+        /// \return true if the body matches one of the shapes
+        bool matchBody(int position, FJP::OP_CODE &op);
+
+        /// Matches the body of a loop updating a variable (VSUM, VMIN, VMAX, VCMP).
+        bool matchReduction(int position, FJP::OP_CODE &op);
+
+        /// Matches the body of a loop writing an array (VADD, VMUL, VFILL).
+        bool matchElementWise(int position, FJP::OP_CODE &op);
+
+        /// Makes sure the variables and arrays of the loop do not overlap, so processing
+        /// the whole loop at once gives the same result as processing it element by element.
+        /// \param op OP code of the vector instruction replacing the loop
+        /// \return true if the loop can be replaced
+        bool checkOperands(FJP::OP_CODE op) const;
+
+        /// Inserts the vector instruction followed by a jump over the loop.
+        /// \param code generated code
+        /// \param address address the vector instruction is inserted at
+        /// \param end address right after the loop
+        /// \param op OP code of the vector instruction
+        void emit(FJP::GeneratedCode &code, int address, int end, FJP::OP_CODE op);
+
+    public:
+        /// Constructor - creates an instance of the class
+        LoopVectorizer();
+
+        /// Tries to vectorize a for loop that has just been generated. The loop spans
+        /// from its condition to the end of the code (the initial assignment precedes it).
+        /// \param code generated code
+        /// \param startCondition address of the first instruction of the condition
+        /// \return true if the loop has been vectorized
+        bool vectorizeFor(FJP::GeneratedCode &code, int startCondition);
+
+        /// Tries to vectorize a foreach loop that has just been generated. The loop spans from
+        /// the initialization of its index to the end of the code (INC removing the index).
+        /// \param code generated code
+        /// \param startLoop address of the first instruction after the allocation of the index
+        /// \param indexAddress address of the temporary index within the current frame
+        /// \return true if the loop has been vectorized
+        bool vectorizeForeach(FJP::GeneratedCode &code, int startLoop, int indexAddress);
+    };
+}
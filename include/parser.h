@@ -7,6 +7,7 @@
 #include <iparser.h>
 #include <code.h>
 #include <symbol_table.h>
+#include <loop_vectorizer.h>
 
 namespace FJP {
 
@@ -32,6 +33,13 @@ namespace FJP {
         /// Number of variables stored onto the stack upon a function call.
         static constexpr int FRAME_INIT_VAR_COUNT = 4;
 
+        /// Maximum number of slots of the data segment (global arrays).
+        static constexpr int MAX_DATA_SIZE = 1 << 26;
+
+        /// Maximum number of slots of a dense jump table per case of a switch statement.
+        /// Sparser switch statements are dispatched by a binary search.
+        static constexpr int JUMP_TABLE_DENSITY = 2;
+
     private:
         /// The instance of the class.
         static Parser *instance;
@@ -56,6 +64,13 @@ namespace FJP {
         /// Their address is not yet known.
         std::map<std::string, std::list<int>> undefinedLabels;
 
+        /// Address of the most recently defined label (-1 if there is none).
+        /// Loops containing a label are not vectorized.
+        int lastLabelAddress;
+
+        /// Replaces simple loops over arrays with vector instructions.
+        FJP::LoopVectorizer vectorizer;
+
     private:
         /// Constructor - creates an instance of the class.
         Parser();
@@ -88,6 +103,12 @@ namespace FJP {
         /// \param expectSemicolon flag saying if there should a semicolon at the end of the assignment
         bool processAssignment(bool expectSemicolon = true);
 
+        /// Processes a compound assignment (+=, -=, *=, ++, --) of a variable whose identifier
+        /// has just been processed (recursive descent). The variable gets updated in place.
+        /// \param variable the variable being assigned
+        /// \return false if the current token is not a compound assignment operator
+        bool processCompoundAssignment(const FJP::Symbol &variable);
+
         /// Processes an 'expression' (recursive descent).
         void processExpression();
 
@@ -100,8 +121,11 @@ namespace FJP {
         /// Processes an 'if' statement (recursive descent).
         bool processIf();
 
-        /// Processes a 'condition' (recursive descent).
-        void processCondition();
+        /// Processes a 'condition' (recursive descent) and generates a conditional jump
+        /// based on its result. The target of the jump is to be set by the caller.
+        /// \param jumpIfTrue jump if the condition is satisfied (otherwise if it is not)
+        /// \return the address of the jump instruction
+        int processCondition(bool jumpIfTrue = false);
 
         /// Processes a 'while' loop (recursive descent).
         bool processWhile();
@@ -124,10 +148,17 @@ namespace FJP {
         /// Processes a 'ternary operator' (recursive descent).
         void processTernaryOperator();
 
-        /// Processes a 'case' in a switch statement (recursive descent).
+        /// Processes the cases of a switch statement (recursive descent).
         /// \param variable the main variable used in the switch statement
         /// \param breaks list of all break statements within the switch statement
-        void processCases(Symbol &variable, std::list<int> &breaks);
+        /// \param cases the case values mapped onto the addresses of their bodies (the first case wins)
+        void processCases(Symbol &variable, std::list<int> &breaks, std::map<int, int> &cases);
+
+        /// Builds the jump table dispatching a switch statement.
+        /// \param cases the case values mapped onto the addresses of their bodies
+        /// \param defaultTarget address to jump to if no case matches
+        /// \return the index of the jump table within the generated code
+        int addJumpTable(const std::map<int, int> &cases, int defaultTarget);
 
         /// Processes a 'label' (recursive descent).
         /// \param label name of the label (used in goto)
@@ -148,6 +179,53 @@ namespace FJP {
         /// Processes a 'write' operation (recursive descent).
         bool processWrite();
 
+        /// Generates a binary operation of the two values on the top of the stack. If the second
+        /// operand is a constant (a single LIT instruction), the LIT gets replaced by an instruction
+        /// with an immediate operand (ADDI, SUBI, MULI).
+        /// \param type type of the operation
+        /// \param start address of the first instruction of the second operand
+        void generateOperation(FJP::OPRType type, int start);
+
+        /// Generates an in-place update of a variable (ADDV, SUBV, MULV) by the value on the top of the stack.
+        /// If the value is a constant (a single LIT instruction), the LIT gets replaced by the immediate
+        /// form of the update (ADDVI, SUBVI, MULVI).
+        /// \param op OP code of the stack form of the update
+        /// \param variable the variable being updated
+        /// \param start address of the first instruction of the value
+        void generateUpdate(FJP::OP_CODE op, const FJP::Symbol &variable, int start);
+
+        /// Turns the code of an assignment of the form x := x + <operand> (also -, *) into an in-place
+        /// update of the variable. The operand has to be calculated by straight-line code.
+        /// \param variable the variable being assigned
+        /// \param start address of the first instruction of the expression
+        /// \return true if the code has been replaced by the update (the value is not to be stored)
+        bool generateInPlaceAssignment(const FJP::Symbol &variable, int start);
+
+        /// Checks if the instructions calculate a single value without using anything placed below it on the stack.
+        /// \param start address of the first instruction
+        /// \param end address right after the last instruction
+        /// \return true if the instructions leave exactly one value on the top of the stack
+        bool isSingleValue(int start, int end) const;
+
+        /// Generates a compare-and-branch instruction comparing the two values on the top of the stack.
+        /// If the second operand is a constant (a single LIT instruction), the LIT gets replaced
+        /// by the instruction, which then compares against an immediate operand (JEQI ... JGEI).
+        /// \param comparison type of the comparison (OPR_EQ ... OPR_GRT_EQ)
+        /// \param jumpIfTrue jump if the comparison holds (otherwise if it does not)
+        /// \param start address of the first instruction of the second operand
+        /// \return the address of the instruction (its target is to be set by the caller)
+        int generateBranch(int comparison, bool jumpIfTrue, int start);
+
+        /// Generates instructions loading an element of an array onto the top of the stack.
+        /// The index of the element is expected to be on the top of the stack.
+        /// \param array the array being accessed
+        void generateArrayLoad(const FJP::Symbol &array);
+
+        /// Generates an instruction storing the value on the top of the stack into an element of
+        /// an array. The value is expected to be right above the index of the element.
+        /// \param array the array being accessed
+        void generateArrayStore(const FJP::Symbol &array);
+
     public:
         /// Return the instance of the class.
         /// \return the instance of the class
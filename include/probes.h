@@ -0,0 +1,76 @@
+#pragma once
+
+/// Static tracepoints (USDT probes) placed at the main events of the compiler and the
+/// virtual machine. Each probe compiles into a single nop instruction plus an entry in
+/// the .note.stapsdt section of the binary, in the very same format the systemtap sdt.h
+/// header uses. This way, standard Linux tracers (bpftrace, perf, SystemTap) can attach
+/// to a release build of fjp without rebuilding it or turning on the debug mode, e.g.
+///
+///     bpftrace -e 'usdt:./fjp:fjp:vm_call { @[arg0] = count(); }'
+///
+/// When no tracer is attached, the cost of a probe is the nop itself. All the arguments
+/// of the probes are of the int type. The provider of all the probes is "fjp".
+///
+/// If the platform provides <sys/sdt.h>, it is used directly. Otherwise, the notes are
+/// generated by an inline implementation of the format for x86-64 and AArch64 ELF targets.
+/// On any other platform, the probes expand to nothing.
+
+#if defined(__has_include)
+# if __has_include(<sys/sdt.h>)
+#  include <sys/sdt.h>
+#  define FJP_PROBES_SDT
+# endif
+#endif
+
+#if defined(FJP_PROBES_SDT)
+
+# define FJP_PROBE0(name) DTRACE_PROBE(fjp, name)
+# define FJP_PROBE1(name, arg1) DTRACE_PROBE1(fjp, name, arg1)
+# define FJP_PROBE2(name, arg1, arg2) DTRACE_PROBE2(fjp, name, arg1, arg2)
+
+#elif defined(__ELF__) && defined(__GNUC__) && (defined(__x86_64__) || defined(__aarch64__))
+
+/// Emits the nop (the probe site) along with the note describing it. The note holds the address
+/// of the probe, the address of the .stapsdt.base section (so the tracer can adjust the address
+/// if the binary gets prelinked), the address of a semaphore (none), the name of the provider,
+/// the name of the probe, and a description of the arguments ("-4@<operand>" = 4-byte signed value).
+# define FJP_PROBE_ASM(name, args)                                               \
+    "990: nop\n"                                                               \
+    ".pushsection .note.stapsdt,\"?\",\"note\"\n"                              \
+    ".balign 4\n"                                                              \
+    ".4byte 992f-991f, 994f-993f, 3\n"                                         \
+    "991: .asciz \"stapsdt\"\n"                                                \
+    "992: .balign 4\n"                                                         \
+    "993: .8byte 990b\n"                                                       \
+    ".8byte _.stapsdt.base\n"                                                  \
+    ".8byte 0\n"                                                               \
+    ".asciz \"fjp\"\n"                                                         \
+    ".asciz \"" #name "\"\n"                                                   \
+    ".asciz \"" args "\"\n"                                                    \
+    "994: .balign 4\n"                                                         \
+    ".popsection\n"                                                            \
+    ".ifndef _.stapsdt.base\n"                                                 \
+    ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"    \
+    ".weak _.stapsdt.base\n"                                                   \
+    ".hidden _.stapsdt.base\n"                                                 \
+    "_.stapsdt.base: .space 1\n"                                               \
+    ".size _.stapsdt.base, 1\n"                                                \
+    ".popsection\n"                                                            \
+    ".endif\n"
+
+# define FJP_PROBE0(name) \
+    __asm__ __volatile__ (FJP_PROBE_ASM(name, ""))
+
+# define FJP_PROBE1(name, arg1) \
+    __asm__ __volatile__ (FJP_PROBE_ASM(name, "-4@%0") :: "nor"(static_cast<int>(arg1)))
+
+# define FJP_PROBE2(name, arg1, arg2) \
+    __asm__ __volatile__ (FJP_PROBE_ASM(name, "-4@%0 -4@%1") :: "nor"(static_cast<int>(arg1)), "nor"(static_cast<int>(arg2)))
+
+#else
+
+# define FJP_PROBE0(name) do {} while (0)
+# define FJP_PROBE1(name, arg1) do { (void)(arg1); } while (0)
+# define FJP_PROBE2(name, arg1, arg2) do { (void)(arg1); (void)(arg2); } while (0)
+
+#endif
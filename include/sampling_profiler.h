@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include <code.h>
+
+namespace FJP {
+
+    /// This class implements a statistical sampling profiler. Instead of
+    /// counting every instruction, an interval timer periodically interrupts
+    /// the virtual machine (SIGPROF) and the signal handler takes a snapshot
+    /// of the instruction pointer along with the chain of function frames.
+    /// The handler never touches the registers of the virtual machine. Instead,
+    /// the virtual machine publishes copies of them (atomic) as it dispatches
+    /// instructions. The samples are stored into a preallocated buffer without any
+    /// locking and they are processed once the execution of the program has finished.
+    class SamplingProfiler {
+    private:
+        /// Output file containing the flat profile (samples per function).
+        static constexpr const char *OUTPUT_FILE = "profile_samples.txt";
+
+        /// Output file containing the sampled call paths as collapsed stacks.
+        static constexpr const char *OUTPUT_FOLDED_FILE = "profile_samples.folded";
+
+        /// Profiler error code (used when terminating the application).
+        static constexpr int ERR_CODE = 3;
+
+        /// Sampling interval in microseconds (CPU time).
+        static constexpr int SAMPLE_INTERVAL_US = 1000;
+
+        /// Maximum number of samples that can be stored.
+        static constexpr int MAX_SAMPLES = 1 << 16;
+
+        /// Maximum number of frames stored within one sample.
+        static constexpr int MAX_FRAMES = 64;
+
+        /// Definition of a sample. The first address is the instruction
+        /// pointer, the following ones are the return addresses of the frames.
+        struct Sample {
+            int depth;                 ///< number of valid addresses
+            int addresses[MAX_FRAMES]; ///< instruction pointer followed by the return addresses
+        };
+
+        /// Chain of frames published for the signal handler. The first
+        /// address is unused (it is taken by the instruction pointer).
+        struct Frames {
+            std::atomic<int> depth;                 ///< number of valid addresses
+            std::atomic<int> addresses[MAX_FRAMES]; ///< addresses of the calls that created the frames
+        };
+
+        // The signal handler may only access lock-free atomic objects.
+        static_assert(std::atomic<int>::is_always_lock_free, "the sampling profiler requires lock-free atomic integers");
+
+    private:
+        /// The instance of the class.
+        static SamplingProfiler *instance;
+
+        /// Preallocated buffer of samples (written from within the signal handler).
+        std::vector<Sample> samples;
+
+        /// Index of the next free sample in the buffer.
+        std::atomic<int> sampleCount;
+
+        /// Number of samples dropped because the buffer was full.
+        std::atomic<int> droppedCount;
+
+        /// Copy of the instruction pointer published by the virtual machine.
+        std::atomic<int> publishedEIP;
+
+        /// Two chains of frames. The virtual machine fills up the inactive one and then
+        /// makes it active, so the signal handler never reads a chain that is being written.
+        Frames frames[2];
+
+        /// Index of the chain of frames the signal handler reads.
+        std::atomic<int> activeFrames;
+
+        /// Base pointer the active chain of frames has been published for
+        /// (accessed only by the virtual machine).
+        int publishedEBP;
+
+        /// The stack of the virtual machine being sampled (accessed only by the virtual machine).
+        const int *stackMemory;
+        int stackSize;
+
+    private:
+        /// Constructor - creates an instance of the class
+        SamplingProfiler();
+
+        /// Delete copy constructor of the class
+        SamplingProfiler(SamplingProfiler &) = delete;
+
+        /// Delete assign operator of the class
+        void operator=(SamplingProfiler const &) = delete;
+
+        /// Signal handler (SIGPROF) - takes a sample of the virtual machine.
+        /// \param signal number of the signal
+        static void handleSignal(int signal);
+
+        /// Stores the published instruction pointer and the frame chain into the buffer.
+        void takeSample();
+
+        /// Walks the frames of the virtual machine and publishes their chain.
+        /// \param ebp base pointer of the virtual machine
+        void publishFrames(int ebp);
+
+    public:
+        /// Returns the instance of the class.
+        /// \return the instance of the class
+        static SamplingProfiler *getInstance();
+
+        /// Starts sampling the virtual machine.
+        /// \param stack the stack of the virtual machine
+        /// \param size size of the stack
+        void start(const int *stack, int size);
+
+        /// Publishes the registers of the virtual machine for the signal handler. It is
+        /// called before every instruction. The chain of frames is walked only if the base
+        /// pointer has changed (a call or a return), so most of the time it is a single store.
+        /// \param eip instruction pointer of the virtual machine
+        /// \param ebp base pointer of the virtual machine
+        void update(int eip, int ebp) {
+            publishedEIP.store(eip, std::memory_order_relaxed);
+            if (ebp != publishedEBP) {
+                publishFrames(ebp);
+            }
+        }
+
+        /// Stops sampling the virtual machine.
+        void stop();
+
+        /// Processes the samples and stores the profile into the output files.
+        /// \param program the program that has been executed
+        void report(const FJP::GeneratedCode &program);
+    };
+}
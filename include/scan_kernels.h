@@ -0,0 +1,56 @@
+#pragma once
+
+namespace FJP {
+
+    /// This class holds the kernels the lexer uses to skip white characters and comments.
+    /// Just like the vector kernels, they are selected once at runtime according to the features
+    /// of the CPU (AVX2, SSE2), and they fall back to a portable scalar implementation. The SIMD
+    /// kernels look at 32 or 16 characters at a time and count the new lines among them, so the
+    /// lexer keeps track of the line numbers without going through the characters one by one.
+    class ScanKernels {
+    private:
+        /// The instance of the class.
+        static ScanKernels *instance;
+
+        /// Name of the selected implementation ("avx2", "sse2", "scalar").
+        const char *name;
+
+        long (*skipSpacesKernel)(const char *text, long index, long length, int &lineNumber);
+        long (*findCommentDelimiterKernel)(const char *text, long index, long length, int &lineNumber);
+
+    private:
+        /// Constructor - creates an instance of the class (selects the kernels)
+        ScanKernels();
+
+        /// Deleted copy constructor of the class
+        ScanKernels(ScanKernels &) = delete;
+
+        /// Deleted assign operator of the class
+        void operator=(ScanKernels const &) = delete;
+
+    public:
+        /// Returns the instance of the ScanKernels class.
+        /// \return the instance of the class
+        static ScanKernels *getInstance();
+
+        /// Returns the name of the selected implementation.
+        /// \return "avx2", "sse2", or "scalar"
+        const char *getName() const;
+
+        /// Skips white characters (the same ones isspace recognizes).
+        /// \param text the source code (followed by '\0')
+        /// \param index index of the first character to be looked at
+        /// \param length length of the source code
+        /// \param lineNumber number of the current line (increased by each new line skipped)
+        /// \return index of the first character that is not white
+        long skipSpaces(const char *text, long index, long length, int &lineNumber) const;
+
+        /// Finds the next start ("/*") or end ("*/") of a comment.
+        /// \param text the source code (followed by '\0')
+        /// \param index index of the first character to be looked at
+        /// \param length length of the source code
+        /// \param lineNumber number of the current line (increased by each new line skipped)
+        /// \return index of the first character of the sequence (-1 if there is none)
+        long findCommentDelimiter(const char *text, long index, long length, int &lineNumber) const;
+    };
+}
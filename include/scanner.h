@@ -0,0 +1,110 @@
+#pragma once
+
+#include <string_view>
+#include <unordered_map>
+
+#include <token.h>
+#include <scan_kernels.h>
+
+namespace FJP {
+
+    /// Lexical error found by the scanner. It is reported by the lexer once the parser gets
+    /// to it, so the errors are reported in the same order whether the text is scanned on
+    /// demand or split into chunks scanned ahead on several threads.
+    struct LexicalError {
+        const char *methodName; ///< name of the method the error has been found in (nullptr if it is not printed)
+        const char *message;    ///< the error message
+        int lineNumber;         ///< number of the line the error is on (within the scanned text)
+        std::string_view text;  ///< text printed out before the error message (e.g. an unknown character)
+    };
+
+    /// This class converts a text (the whole input file or a chunk of it) into tokens.
+    /// The text is followed either by '\0' or by a white character, which does not belong
+    /// to any token, so it can be scanned without checking the end at every character.
+    /// The tokens point into the text, and their line numbers are counted from the start of it.
+    class Scanner {
+    private:
+        /// Characters used to indicate the start of a comment.
+        static constexpr const char *COMMENT_START = "/*";
+
+        /// Characters used to indicate the end of a comment (see ScanKernels::findCommentDelimiter).
+        static constexpr const char *COMMENT_END   = "*/";
+
+        /// Maximum allowed length of an identifier.
+        static constexpr int MAX_IDENTIFIER_LEN = 16;
+
+        /// Kernels skipping white characters and comments.
+        const FJP::ScanKernels *scanKernels;
+
+        /// The text being scanned.
+        std::string_view content;
+
+        /// Current index (pointer) within the text
+        /// (which character is currently being processed)
+        long currentCharIndex;
+
+        /// Current line within the text, so we can keep
+        /// track of which token is on which line.
+        int currentLineNumber;
+
+        /// IDs of the identifiers found in the text mapped by their names.
+        std::unordered_map<std::string_view, int> identifierIds;
+
+        /// The lexical error that has stopped the scanning.
+        FJP::LexicalError error;
+
+    private:
+        /// Records a lexical error.
+        /// \param methodName name of the method the error has been found in
+        /// \param message the error message
+        /// \return false, so the error can be returned right away
+        bool fail(const char *methodName, const char *message);
+
+        /// Parses an operator or a delimiter. The longest operator is always
+        /// taken (e.g. ':=' rather than ':' followed by '=').
+        /// \return the token (UNKNOWN if the character does not start any operator)
+        FJP::Token parseOperator();
+
+        /// Skips all white characters in the text.
+        void skipWhiteCharacters();
+
+    public:
+        /// Constructor - creates an instance of the class
+        Scanner();
+
+        /// Starts scanning a text (forgetting the identifiers found before).
+        /// \param source the text (followed by '\0' or by a white character)
+        void init(std::string_view source);
+
+        /// Parses a next token. The kind of the token is decided
+        /// by its first character, so each character is looked at only once.
+        /// \param token next token that was parsed from the text
+        /// \param commentSkipped flag indicating that the comment preceding the token has already been skipped
+        /// \return false if there is a lexical error (see getError)
+        bool parseNextToken(FJP::Token &token, bool commentSkipped = false);
+
+        /// Skips white characters and a comment in the text (a comment directly following
+        /// another one is not skipped, it is parsed as tokens).
+        /// \return false if there is an unclosed comment (see getError)
+        bool skipComments();
+
+        /// Returns true/false depending on whether the whole
+        /// text has been processed or not (the lexer asks before every token, hence the inline definition).
+        /// \return true/false - depending on whether it's the end of the text.
+        bool isEndOfFile() const {
+            return currentCharIndex >= static_cast<long>(content.length());
+        }
+
+        /// Returns the number of the current line (the number of new lines processed so far).
+        /// \return number of the current line
+        int getLineNumber() const;
+
+        /// Returns the IDs of the identifiers found in the text so far mapped by their names.
+        /// \return IDs of the identifiers
+        const std::unordered_map<std::string_view, int> &getIdentifierIds() const;
+
+        /// Returns the lexical error that has stopped the scanning.
+        /// \return the error
+        const FJP::LexicalError &getError() const;
+    };
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <string_view>
+
+namespace FJP {
+
+    /// This class provides the content of a source file to the lexer. A regular file is mapped
+    /// into the memory read-only and scanned in place, whereas anything that cannot be mapped
+    /// (a pipe, /dev/stdin) is read into a buffer instead. Either way, the content is followed
+    /// by '\0', so it can be scanned without checking the end of the file at every character.
+    class SourceFile {
+    private:
+        /// The file mapped into the memory (nullptr if it is not mapped).
+        void *mapping;
+
+        /// Size of the mapping in bytes (the file itself plus the terminating '\0').
+        size_t mappingSize;
+
+        /// Content of the file if it cannot be mapped.
+        std::string buffer;
+
+        /// Content of the file (either within the mapping or the buffer).
+        std::string_view content;
+
+    private:
+        /// Deleted copy constructor of the class
+        SourceFile(SourceFile &) = delete;
+
+        /// Deleted assign operator of the class
+        void operator=(SourceFile const &) = delete;
+
+        /// Maps the file into the memory.
+        /// \param filename path to the file
+        /// \return false if the file is not a regular file or it cannot be mapped
+        bool map(const std::string &filename);
+
+    public:
+        /// Constructor - creates an instance of the class
+        SourceFile();
+
+        /// Destructor - unmaps the file
+        ~SourceFile();
+
+        /// Opens the file (releasing the one opened before).
+        /// \param filename path to the file
+        /// \return false if the file cannot be opened
+        bool open(const std::string &filename);
+
+        /// Releases the content of the file.
+        void close();
+
+        /// Returns the content of the file. It is followed by '\0'.
+        /// \return the content of the file
+        std::string_view getContent() const;
+    };
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include <code.h>
+
+namespace FJP {
+
+    /// This class computes how much of the stack a program needs before it is executed.
+    /// It walks the control flow of every function (starting at its INC instruction),
+    /// tracks the depth of the stack relative to the base of the frame, and combines the
+    /// results along the call graph given by the targets of the CAL instructions.
+    /// For a program without recursion, the result is the exact maximum of the stack pointer.
+    /// For a recursive program, it is the requirement without any recursive call plus
+    /// the cost of one level of recursion.
+    class StackAnalyzer {
+    private:
+        /// Results of the analysis of a single function.
+        struct FunctionInfo {
+            int peak;                                  ///< maximum depth of the stack within the frame
+            std::vector<std::pair<int, int>> calls;    ///< called functions along with the depth at the call
+            int component;                             ///< strongly connected component of the call graph
+            bool recursive;                            ///< the function is part of a cycle of the call graph
+        };
+
+    private:
+        /// Program being analyzed.
+        const FJP::GeneratedCode &program;
+
+        /// Results of the analysis of all reachable functions mapped by their first address.
+        std::map<int, FunctionInfo> functions;
+
+        /// Set to false if the depth of the stack cannot be determined statically.
+        bool valid;
+
+    private:
+        /// Walks the control flow of a function and records its peak and calls.
+        /// \param address the first address of the function (INC)
+        void analyzeFunction(int address);
+
+        /// Splits the call graph into strongly connected components (Tarjan's algorithm),
+        /// so recursive functions can be told apart from the rest.
+        void findRecursion();
+
+        /// Computes the stack requirement of a function with no recursive call taking place.
+        /// \param address the first address of the function
+        /// \param cache already computed requirements
+        /// \return the maximum depth of the stack relative to the stack pointer of the caller
+        int computeRequirement(int address, std::map<int, int> &cache);
+
+    public:
+        /// Constructor - creates an instance of the class
+        /// \param code program to be analyzed
+        explicit StackAnalyzer(const FJP::GeneratedCode &code);
+
+        /// Performs the analysis.
+        /// \return the stack bound of the program
+        FJP::StackBound analyze();
+    };
+}
@@ -2,6 +2,7 @@
 
 #include <list>
 #include <string>
+#include <string_view>
 #include <unordered_set>
 #include <iostream>
 
@@ -31,6 +32,7 @@ namespace FJP {
         int level;                  ///< level (depth) of the symbol
         int address;                ///< address of the symbol within the stack
         int size;                   ///< size of the symbol (used in case of an array - number of elements)
+        bool inDataSegment = false; ///< the array is stored in the data segment (the address is within the data segment)
 
         /// Overloaded '==' operator. This method is used
         /// for comparing two different symbols. They're
@@ -80,14 +82,14 @@ namespace FJP {
         /// table currently holds.
         /// \param name the name of the symbol we're looking for
         /// \return true/false depending on whether the symbol is found or not.
-        bool existsSymbol(const std::string &name) const;
+        bool existsSymbol(std::string_view name) const;
 
         /// Finds a symbol by its name within the symbol table. It takes into
         /// account all frames that are currently held in the symbol table.
         /// \param name the name of the symbol we're looking for
         /// \return instance of Symbol regardless of the symbol having been found or not.
         ///         If the symbol has not been found, its type is set to SYMBOL_NOT_FOUND
-        FJP::Symbol findSymbol(const std::string &name) const;
+        FJP::Symbol findSymbol(std::string_view name) const;
 
         /// Adds a symbol into the frame on the top of the stack (current function/depth/level).
         /// \param symbol instance of Symbol that will be added into the current frame
@@ -107,6 +109,12 @@ namespace FJP {
         /// \param name the name of the symbol that is supposed to be already stored in the symbol table
         /// \param size the size of the newly created array
         void makeArray(const std::string &name, int size);
+
+        /// Moves an array into the data segment. The symbol is given by its name,
+        /// hence it needs to be found first.
+        /// \param name the name of the array that is supposed to be already stored in the symbol table
+        /// \param address the address of the array within the data segment
+        void moveToDataSegment(const std::string &name, int address);
     };
 
     /// Prints out the contents of the symbol table
@@ -1,10 +1,9 @@
 #pragma once
 
 #include <string>
-#include <vector>
 #include <utility>
 #include <iostream>
-#include <unordered_set>
+#include <string_view>
 
 namespace FJP {
 
@@ -66,22 +65,29 @@ namespace FJP {
         BREAK,                 // 'break'
         HASH_MARK,             // '#'
         END,                   // 'END'
+        PLUS_ASSIGN,           // '+='
+        MINUS_ASSIGN,          // '-='
+        MUL_ASSIGN,            // '*='
+        INCREMENT,             // '++'
+        DECREMENT,             // '--'
         UNKNOWN
     };
 
     /// Definition of a token which is being passed from the lexer to the parser.
+    /// The token does not own any memory - its value points into the source code,
+    /// so it is only valid for as long as the lexer keeps the input file open.
     struct Token {
-        TokenType tokenType; ///< type of the token
-        std::string value;   ///< value of the token e.g. a number
-        int lineNumber;      ///< number of the line in the source code
+        TokenType tokenType;    ///< type of the token
+        std::string_view value; ///< value of the token e.g. a number (text within the source code)
+        int lineNumber;         ///< number of the line in the source code
+        int number = 0;         ///< value of a number (already converted into an int)
+        int identifierId = -1;  ///< ID of an identifier (the same for all occurrences of the same name)
     };
 
     /// List of literal string values mapped onto their corresponding token values.
-    /// This std::vector will be sorted out upon the lexer instantiation. The reason
-    /// for sorting these values is to prevent mistreating tokens which happen
-    /// to be a prefix of another token. For example, ':' and ':='. Therefore,
-    /// the list will be sorted in a descending order by the token string value.
-    static std::vector<std::pair<std::string, TokenType>> keywords = {
+    /// It is a compile-time constant, so the lexer can build a perfect hash table
+    /// of the alphabetic keywords out of it while the compiler itself is being compiled.
+    inline constexpr std::pair<std::string_view, TokenType> keywords[] = {
         {"instanceof",TokenType::INSTANCEOF            },
         {"function",  TokenType::FUNCTION              },
         {"repeat",    TokenType::REPEAT                },
@@ -115,6 +121,11 @@ namespace FJP {
         {"==",        TokenType::EQUALS                },
         {"&&",        TokenType::LOGICAL_AND           },
         {"||",        TokenType::LOGICAL_OR            },
+        {"+=",        TokenType::PLUS_ASSIGN           },
+        {"-=",        TokenType::MINUS_ASSIGN          },
+        {"*=",        TokenType::MUL_ASSIGN            },
+        {"++",        TokenType::INCREMENT             },
+        {"--",        TokenType::DECREMENT             },
         {"=",         TokenType::CONST_INIT            },
         {"(",         TokenType::LEFT_PARENTHESIS      },
         {")",         TokenType::RIGHT_PARENTHESIS     },
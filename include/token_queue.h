@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+#include <token.h>
+
+namespace FJP {
+
+    /// This class implements a bounded queue passing the tokens from the thread lexing the input
+    /// file over to the parser. There is exactly one thread pushing the tokens into it and one
+    /// thread popping them, so it does without any locking. Each of them moves only its own index
+    /// forward, and it keeps a copy of the other one, so the cache line shared by the threads
+    /// is only read once the copy runs out. A thread that cannot go on yields to the other one.
+    class TokenQueue {
+    private:
+        /// Number of the tokens the queue can hold (a power of two).
+        static constexpr size_t CAPACITY = 4096;
+
+        /// Size of a cache line (the indexes are kept apart, so the threads do not share them).
+        static constexpr size_t CACHE_LINE_SIZE = 64;
+
+        /// The tokens (the token number i is stored at the index i % CAPACITY).
+        std::array<Token, CAPACITY> tokens;
+
+        /// Number of the tokens popped so far (written by the consumer).
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head;
+
+        /// Number of the tokens pushed so far as last seen by the consumer.
+        size_t consumerTail;
+
+        /// Number of the tokens pushed so far (written by the producer).
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail;
+
+        /// Number of the tokens popped so far as last seen by the producer.
+        size_t producerHead;
+
+        /// Flag indicating that no more tokens are going to be pushed.
+        alignas(CACHE_LINE_SIZE) std::atomic<bool> closed;
+
+        /// Flag indicating that the consumer is not going to pop any more tokens.
+        std::atomic<bool> cancelled;
+
+    private:
+        /// Deleted copy constructor of the class
+        TokenQueue(TokenQueue &) = delete;
+
+        /// Deleted assign operator of the class
+        void operator=(TokenQueue const &) = delete;
+
+        /// Waits until there is room for another token (called by the producer).
+        /// \return false if the consumer has cancelled the queue
+        bool waitForRoom();
+
+    public:
+        /// Constructor - creates an instance of the class
+        TokenQueue();
+
+        /// Empties the queue, so it can be used again (neither of the threads may be using it).
+        void reset();
+
+        /// Pushes a token into the queue, waiting for room if it is full (called by the producer).
+        /// It is called for every token, hence the inline definition.
+        /// \param token the token
+        /// \return false if the consumer has cancelled the queue (the token is dropped)
+        bool push(const FJP::Token &token) {
+            const size_t position = tail.load(std::memory_order_relaxed);
+            if (position - producerHead == CAPACITY && !waitForRoom()) {
+                return false;
+            }
+            tokens[position % CAPACITY] = token;
+            tail.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Tells the consumer that no more tokens are going to be pushed (called by the producer).
+        void close();
+
+        /// Waits until there is a token to be popped (called by the consumer).
+        /// \return false if the queue has been closed and all tokens have been popped
+        bool waitForToken();
+
+        /// Pops the next token, waiting for it if the queue is empty (called by the consumer).
+        /// The parser asks for every token, hence the inline definition.
+        /// \param token the token
+        /// \return false if the queue has been closed and all tokens have been popped
+        bool pop(FJP::Token &token) {
+            const size_t position = head.load(std::memory_order_relaxed);
+            if (position == consumerTail && !waitForToken()) {
+                return false;
+            }
+            token = tokens[position % CAPACITY];
+            head.store(position + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Tells the producer that no more tokens are going to be popped (called by the consumer).
+        void cancel();
+    };
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <string_view>
+
+#include <token.h>
+
+namespace FJP {
+
+    /// This class writes the tokens out into a file as the lexer is parsing them. The records are
+    /// formatted into a buffer which is reused over and over again and written out into the file
+    /// whenever it fills up, so the size of the file does not affect the memory used.
+    /// There are two formats of the file:
+    /// - JSON (tokens.json, see README.md) meant to be read by people,
+    /// - a binary dump meant to be mapped into the memory by other tools. It starts with a header
+    ///   followed by the source code itself (padded to 8 bytes) and an array of fixed-size records,
+    ///   each of them pointing at the value of the token within the source code.
+    class TokenWriter {
+    public:
+        /// Format of the output file.
+        enum Format {
+            JSON,  ///< array of JSON objects (tokens.json)
+            BINARY ///< header, source code, and an array of records
+        };
+
+        /// Version of the binary format (increased whenever the layout of the file changes).
+        static constexpr uint32_t VERSION = 1;
+
+        /// Value stored in the header to detect a file written on a machine with a different byte order.
+        static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+        /// Header of the binary dump.
+        struct Header {
+            char magic[4];       ///< "FJPT"
+            uint32_t version;    ///< version of the format
+            uint32_t byteOrder;  ///< BYTE_ORDER_MARK as stored by the machine that wrote the file
+            uint32_t recordSize; ///< size of a single record in bytes
+            uint64_t sourceSize; ///< size of the source code following the header in bytes
+            uint64_t tokenCount; ///< number of the records following the source code
+        };
+
+        /// Record of a single token within the binary dump.
+        struct Record {
+            uint32_t offset;      ///< offset of the value of the token within the source code
+            uint16_t length;      ///< length of the value of the token
+            uint16_t type;        ///< type of the token (TokenType)
+            int32_t lineNumber;   ///< number of the line in the source code
+            int32_t number;       ///< value of a number
+            int32_t identifierId; ///< ID of an identifier (-1 if the token is not an identifier)
+        };
+
+    private:
+        /// Size the buffer is written out at.
+        static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+        /// Format of the output file.
+        Format format;
+
+        /// The output file.
+        std::ofstream file;
+
+        /// Records which have not been written out into the file yet.
+        std::vector<char> buffer;
+
+        /// The source code the tokens point into.
+        std::string_view source;
+
+        /// Number of the tokens written so far.
+        uint64_t tokenCount;
+
+        /// Names of all types of tokens (so they are not looked up for every token).
+        std::array<std::string, TokenType::UNKNOWN + 1> typeNames;
+
+    private:
+        /// Deleted copy constructor of the class
+        TokenWriter(TokenWriter &) = delete;
+
+        /// Deleted assign operator of the class
+        void operator=(TokenWriter const &) = delete;
+
+        /// Appends text to the buffer.
+        /// \param text the text
+        void append(std::string_view text);
+
+        /// Appends a number to the buffer (as text).
+        /// \param value the number
+        void appendNumber(long value);
+
+        /// Writes the buffer out into the file.
+        void flush();
+
+        /// Formats a token as a JSON object.
+        /// \param token the token
+        void writeJSON(const FJP::Token &token);
+
+        /// Formats a token as a binary record.
+        /// \param token the token
+        void writeBinary(const FJP::Token &token);
+
+    public:
+        /// Constructor - creates an instance of the class
+        TokenWriter();
+
+        /// Destructor - finishes the file
+        ~TokenWriter();
+
+        /// Creates the output file (finishing the one opened before).
+        /// \param filename path to the output file
+        /// \param outputFormat format of the file
+        /// \param sourceCode the source code the tokens point into
+        /// \return false if the file cannot be created
+        bool open(const std::string &filename, Format outputFormat, std::string_view sourceCode);
+
+        /// Returns true/false depending on whether a file is open.
+        /// \return true if the tokens are being written out into a file
+        bool isOpen() const;
+
+        /// Writes a token into the file.
+        /// \param token the token (its value has to point into the source code)
+        void write(const FJP::Token &token);
+
+        /// Finishes the file, so it contains all tokens written into it.
+        void close();
+    };
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+
+namespace FJP {
+
+    /// This class holds the kernels executing the vector instructions over contiguous
+    /// blocks of elements. The kernels are selected once at runtime according to the
+    /// features of the CPU (AVX2, SSE4.1). If none of them is available, or the compiler
+    /// does not support them, a portable scalar implementation is used instead.
+    /// The arithmetic kernels report an overflow exactly the way the OPR instruction does,
+    /// so the virtual machine can fall back to the original loop to terminate the program.
+    class VectorKernels {
+    private:
+        /// The instance of the class.
+        static VectorKernels *instance;
+
+        /// Name of the selected implementation ("avx2", "sse4.1", "scalar").
+        const char *name;
+
+        int64_t (*sumKernel)(const int *values, int count, uint64_t &absoluteSum);
+        bool (*addKernel)(int *destination, const int *x, const int *y, int count);
+        bool (*mulKernel)(int *destination, const int *x, const int *y, int count);
+        int (*minKernel)(const int *values, int count, int initial);
+        int (*maxKernel)(const int *values, int count, int initial);
+        void (*compareKernel)(const int *x, const int *y, int count, int &greater, int &equal);
+        void (*compareValueKernel)(const int *x, int y, int count, int &greater, int &equal);
+
+    private:
+        /// Constructor - creates an instance of the class (selects the kernels)
+        VectorKernels();
+
+        /// Deleted copy constructor of the class
+        VectorKernels(VectorKernels &) = delete;
+
+        /// Deleted assign operator of the class
+        void operator=(VectorKernels const &) = delete;
+
+    public:
+        /// Returns the instance of the VectorKernels class.
+        /// \return the instance of the class
+        static VectorKernels *getInstance();
+
+        /// Returns the name of the selected implementation.
+        /// \return "avx2", "sse4.1", or "scalar"
+        const char *getName() const;
+
+        /// Adds up the elements of an array.
+        /// \param values the elements
+        /// \param count number of the elements
+        /// \param absoluteSum sum of the absolute values of the elements (used to rule out an overflow)
+        /// \return the sum of the elements
+        int64_t sum(const int *values, int count, uint64_t &absoluteSum) const;
+
+        /// Adds up two arrays element-wise. Nothing is written if any of the additions overflows.
+        /// \param destination the result (it may be the same as one of the sources)
+        /// \param x the first array
+        /// \param y the second array
+        /// \param count number of the elements
+        /// \return false if any of the additions overflows
+        bool add(int *destination, const int *x, const int *y, int count) const;
+
+        /// Multiplies two arrays element-wise. Nothing is written if any of the multiplications overflows.
+        /// \param destination the result (it may be the same as one of the sources)
+        /// \param x the first array
+        /// \param y the second array
+        /// \param count number of the elements
+        /// \return false if any of the multiplications overflows
+        bool mul(int *destination, const int *x, const int *y, int count) const;
+
+        /// Finds the minimum of an array and an initial value.
+        /// \param values the elements
+        /// \param count number of the elements
+        /// \param initial the initial value
+        /// \return the minimum
+        int min(const int *values, int count, int initial) const;
+
+        /// Finds the maximum of an array and an initial value.
+        /// \param values the elements
+        /// \param count number of the elements
+        /// \param initial the initial value
+        /// \return the maximum
+        int max(const int *values, int count, int initial) const;
+
+        /// Compares two arrays element-wise.
+        /// \param x the first array
+        /// \param y the second array
+        /// \param count number of the elements
+        /// \param greater number of elements for which x > y
+        /// \param equal number of elements for which x == y
+        void compare(const int *x, const int *y, int count, int &greater, int &equal) const;
+
+        /// Compares the elements of an array with a value.
+        /// \param x the array
+        /// \param y the value
+        /// \param count number of the elements
+        /// \param greater number of elements for which x > y
+        /// \param equal number of elements for which x == y
+        void compare(const int *x, int y, int count, int &greater, int &equal) const;
+    };
+}
@@ -2,10 +2,12 @@
 
 #include <fstream>
 #include <functional>
+#include <vector>
 
 #include <ivm.h>
 #include <isa.h>
 #include <code.h>
+#include <vector_kernels.h>
 
 namespace FJP {
 
@@ -14,16 +16,22 @@ namespace FJP {
     /// the operations. Also, if enabled, it generates an output file containing
     /// stack trace information of the program as it is being executed.
     class VirtualMachine : public IVM {
-    private:
-        static constexpr int STACK_SIZE = 1024; ///< size of the virtual stack (1 KB)
+    public:
+        static constexpr int STACK_SIZE = 1024; ///< maximum size of the virtual stack (1 KB)
+        static constexpr int CALL_SIZE = 4;     ///< number of slots written by the CAL instruction
         static constexpr int ERROR_CODE = 3;    ///< error code of the VM (runtime exception)
 
+    private:
         static constexpr const char *OUTPUT_FILE = "stacktrace.txt"; ///< name of the output file
 
     private:
         static VirtualMachine *instance;  ///< the instance of the VirtualMachine class
 
-        int stackMemory[STACK_SIZE];      ///< internal stack used to perform operations as defined in the program
+        std::vector<int> stackStorage;    ///< memory of the stack (sized up by the stack requirement of the program)
+        int *stackMemory;                 ///< internal stack used to perform operations as defined in the program
+        int stackSize;                    ///< number of slots of the stack
+        bool stackBoundProven;            ///< the program is known to fit in the stack (no need to check its growth)
+        std::vector<int> dataMemory;      ///< data segment holding the global arrays (sized independently of the stack)
         int returnAddresses[STACK_SIZE];  ///< list of return addresses
         int returnAddressCount;           ///< number of return addresses stored in the list
         int ESP;                          ///< stack pointer
@@ -33,7 +41,17 @@ namespace FJP {
         bool debug;                       ///< flag pass in from the main function - create the stack trace output file or not
         FJP::Instruction instruction;     ///< current instruction
         FJP::GeneratedCode *program;      ///< program to be executed (input data of the virtual machine)
+        FJP::PackedCode packedCode;       ///< packed instructions of a program generated by the parser
+        const FJP::PackedInstruction *instructions; ///< packed instructions of the program (possibly within a memory-mapped bytecode file)
+        const FJP::Instruction *wideInstructions;   ///< instructions that do not fit into the packed form
         std::ofstream outputFile;         ///< output file (stream) - stack trace
+        std::vector<FJP::IProfiler *> profilers; ///< profilers attached to the virtual machine
+        FJP::SamplingProfiler *samplingProfiler; ///< sampling profiler (nullptr if sampling is off)
+        FJP::LiveStats *liveStats;               ///< live statistics (nullptr if they are off)
+        const FJP::VectorKernels *vectorKernels; ///< kernels executing the vector instructions
+        bool boundsChecking;                     ///< check the indexes of the LDX and STX instructions against the sizes of the arrays
+        std::vector<int> arrayBounds;            ///< sizes of the arrays accessed by the LDX and STX instructions indexed by their addresses
+        bool frameChecking;                      ///< check the accesses to the stack (a program loaded from a bytecode file is not trusted)
 
     private:
         /// Constructor - creates an instance of the class
@@ -49,20 +67,48 @@ namespace FJP {
         /// clears out the stack, and so on.
         void init();
 
+        /// Allocates the stack based on the stack requirement computed at compile time. If the
+        /// requirement is proven and it fits within STACK_SIZE, exactly that many slots are
+        /// allocated and the growth of the stack is not checked at runtime. Otherwise, the full
+        /// size is allocated, the checks stay on, and the user gets warned if the program cannot fit.
+        void allocateStack();
+
         /// Fetches the next instruction to be executed.
         void fetch();
 
         /// Executes the current instruction.
+        /// \tparam CHECK_STACK check if the stack overflows when it grows
+        template <bool CHECK_STACK>
         void execute();
 
+        /// Executes the program while notifying all attached profilers
+        /// about every instruction that is about to be executed. If live statistics
+        /// are on, they are published at back-edges, calls, returns, and I/O operations.
+        void executeProfiled();
+
         /// Calculates the address where a variable is actually stored
         /// within the stack (it might be stored in a different frame/depth/level)
         int base(int l, int base);
 
+        /// Calculates the address of a variable within the stack. If the frame checking
+        /// is on, the program gets terminated if the variable lies outside of the stack.
+        /// \param l level/depth of the variable
+        /// \param m address of the variable within its frame
+        /// \return address of the variable within the stack
+        int frameAddress(int l, int m);
+
+        /// Makes sure the current instruction finds all of its operands on the stack and that
+        /// a return (or a call) leaves the registers within the stack and the program. It is used
+        /// only if the frame checking is on, so a corrupted bytecode file cannot make the
+        /// virtual machine access memory outside of the stack.
+        void checkInstruction();
+
         /// Executes the LIT instruction.
         /// The LIT instruction pushes a constant value on the top of the stack
         /// \param l unused
         /// \param m the constant to be pushed onto the stack
+        /// \tparam CHECK_STACK check if the stack overflows
+        template <bool CHECK_STACK>
         void execute_LIT(int l, int m);
 
         /// Executes the OPR instruction.
@@ -89,6 +135,8 @@ namespace FJP {
         /// The LOD instruction loads a value from a certain address to the top of the stack.
         /// \param l depth/level of the symbol (address)
         /// \param m address of the symbol
+        /// \tparam CHECK_STACK check if the stack overflows
+        template <bool CHECK_STACK>
         void execute_LOD(int l, int m);
 
         /// Executes the STO instruction.
@@ -110,6 +158,8 @@ namespace FJP {
         /// 12 positions (slots) on the stack.
         /// \param l unused
         /// \param m number by which the stack pointer will be increased
+        /// \tparam CHECK_STACK check if the stack overflows
+        template <bool CHECK_STACK>
         void execute_INC(int l, int m);
 
         /// Executes the JMP instruction.
@@ -126,6 +176,81 @@ namespace FJP {
         /// \param m target address
         void execute_JPC(int l, int m);
 
+        /// Executes a compare-and-branch instruction (JEQ, JNE, JLT, JLE, JGT, JGE).
+        /// The instruction pops two values (x is below y) and jumps if the comparison holds.
+        /// \param op OP code of the instruction
+        /// \param m the target address
+        void execute_JCC(FJP::OP_CODE op, int m);
+
+        /// Executes a compare-and-branch instruction with an immediate operand (JEQI ... JGEI).
+        /// The instruction pops a value (x) and jumps if the comparison with y holds.
+        /// \param op OP code of the instruction
+        /// \param l the immediate operand (y)
+        /// \param m the target address
+        void execute_JCCI(FJP::OP_CODE op, int l, int m);
+
+        /// Executes the ADDI instruction.
+        /// The ADDI instruction adds up the value on the top of the stack and an immediate value.
+        /// Just like the OPR instruction, it terminates the program if the addition overflows.
+        /// \param l unused
+        /// \param m the immediate value
+        void execute_ADDI(int l, int m);
+
+        /// Executes the SUBI instruction.
+        /// The SUBI instruction subtracts an immediate value from the value on the top of the stack.
+        /// \param l unused
+        /// \param m the immediate value
+        void execute_SUBI(int l, int m);
+
+        /// Executes the MULI instruction.
+        /// The MULI instruction multiplies the value on the top of the stack by an immediate value.
+        /// Just like the OPR instruction, it terminates the program if the multiplication overflows.
+        /// \param l unused
+        /// \param m the immediate value
+        void execute_MULI(int l, int m);
+
+        /// Executes the CMPI instruction.
+        /// The CMPI instruction replaces the value on the top of the stack with the result (1/0)
+        /// of its comparison with an immediate value.
+        /// \param l type of the comparison (OPR_EQ ... OPR_GRT_EQ)
+        /// \param m the immediate value
+        void execute_CMPI(int l, int m);
+
+        /// Executes an in-place update of a variable (ADDV, SUBV, MULV).
+        /// The instruction pops a value (y) and updates the variable by it (x := x op y).
+        /// \param op OP code of the instruction
+        /// \param l level/depth of the variable
+        /// \param m address of the variable
+        void execute_UPD(FJP::OP_CODE op, int l, int m);
+
+        /// Executes an in-place update of a variable by a constant (ADDVI, SUBVI, MULVI).
+        /// The variable and the constant are described by an entry of the table of updates.
+        /// \param op OP code of the instruction
+        /// \param m index of the update
+        void execute_UPDI(FJP::OP_CODE op, int m);
+
+        /// Updates a variable by a value the same way the OPR instruction would calculate
+        /// x := x op y. The program gets terminated if the addition or multiplication overflows.
+        /// \param op OP code of the stack form of the update (ADDV, SUBV, MULV)
+        /// \param variable the variable
+        /// \param value the value
+        void updateVariable(FJP::OP_CODE op, int &variable, int value);
+
+        /// Compares two values.
+        /// \param comparison type of the comparison (OPR_EQ ... OPR_GRT_EQ)
+        /// \param x first value
+        /// \param y second value
+        /// \return true if the comparison holds
+        bool compare(int comparison, int x, int y) const;
+
+        /// Executes the JTB instruction.
+        /// The JTB instruction pops a value off the stack and jumps to the target assigned
+        /// to the value by a jump table (or to the default target if there is none).
+        /// A dense table is indexed directly, and a sparse one is searched by bisection.
+        /// \param l unused
+        /// \param m index of the jump table within the generated code
+        void execute_JTB(int l, int m);
+
         /// Executes the SIO instruction.
         /// The SIO instruction executes a system I/O operation based on the its m value.
         /// m = 0 -> prints the value on the top of the stack out to the screen
@@ -133,6 +258,8 @@ namespace FJP {
         /// m = 2 -> halts the system (the program terminates)
         /// \param l unused
         /// \param m type of the i/O operation
+        /// \tparam CHECK_STACK check if the stack overflows
+        template <bool CHECK_STACK>
         void execute_SIO(int l, int m);
 
         /// Executes the LDA instruction.
@@ -151,6 +278,91 @@ namespace FJP {
         /// \param m unused
         void execute_STA(int l, int m);
 
+        /// Executes the LDD instruction.
+        /// The LDD instruction replaces the index on the top of the stack
+        /// with the corresponding element of an array stored in the data segment.
+        /// \param l size of the array (the index is checked against it)
+        /// \param m address of the array within the data segment
+        void execute_LDD(int l, int m);
+
+        /// Executes the STD instruction.
+        /// The STD instruction stores the value on the top of the stack into an element of
+        /// an array stored in the data segment. The index is expected to be right below the value.
+        /// \param l size of the array (the index is checked against it)
+        /// \param m address of the array within the data segment
+        void execute_STD(int l, int m);
+
+        /// Executes the LDX instruction.
+        /// The LDX instruction replaces the index on the top of the stack with the element
+        /// of an array stored within a frame.
+        /// \param l level/depth of the array
+        /// \param m base address of the array
+        void execute_LDX(int l, int m);
+
+        /// Executes the STX instruction.
+        /// The STX instruction stores the value on the top of the stack into an element of
+        /// an array stored within a frame. The index is expected to be right below the value.
+        /// \param l level/depth of the array
+        /// \param m base address of the array
+        void execute_STX(int l, int m);
+
+        /// Calculates the address of an element of an array stored within a frame (LDX, STX)
+        /// and terminates the program if it does not exist. The element has to lie within the
+        /// stack, and if the bounds checking is on, the index has to lie within the array as well.
+        /// \param l level/depth of the array
+        /// \param m base address of the array
+        /// \param index index of the element
+        /// \return address of the element
+        int elementAddress(int l, int m, int index);
+
+        /// Executes the CPY instruction.
+        /// The CPY instruction copies a block of values from the constant pool into a frame.
+        /// The block starts with the number of values and the target address within the frame.
+        /// \param l level/depth of the target frame
+        /// \param m address of the block within the constant pool
+        void execute_CPY(int l, int m);
+
+        /// Executes the CPD instruction.
+        /// The CPD instruction copies a block of values from the constant pool into the data segment.
+        /// The block starts with the number of values and the target address within the data segment.
+        /// \param l unused
+        /// \param m address of the block within the constant pool
+        void execute_CPD(int l, int m);
+
+        /// Executes a vector instruction (VADD, VMUL, VSUM, VMIN, VMAX, VCMP, VFILL).
+        /// A vector instruction processes a whole loop at once, and it is followed by a JMP over
+        /// the loop. If the instruction cannot produce the very same result as the loop (the counter
+        /// goes beyond the bounds of an array, an arithmetic operation overflows), it changes
+        /// nothing and skips the JMP, so the loop gets executed instead.
+        /// \param op OP code of the instruction
+        /// \param m index of the loop within the generated code
+        void execute_VECTOR(FJP::OP_CODE op, int m);
+
+        /// Returns a variable used by a vector instruction.
+        /// \param variable the variable (relative to the current frame)
+        /// \return reference to the slot of the stack holding the variable
+        int &vectorVariable(const FJP::VectorValue &variable);
+
+        /// Returns the current value of an operand of a vector instruction.
+        /// \param value the constant or the variable
+        /// \return the value
+        int vectorValue(const FJP::VectorValue &value);
+
+        /// Returns the elements of an array used by a vector instruction.
+        /// \param array the array
+        /// \param first index of the first element
+        /// \return pointer to the first element
+        int *vectorElements(const FJP::VectorArray &array, int first);
+
+        /// Determines the range of elements processed by a vector instruction and makes sure
+        /// it lies within all arrays used by the instruction.
+        /// \param loop the loop being processed
+        /// \param arrays the arrays used by the instruction
+        /// \param first index of the first element
+        /// \param count number of the elements
+        /// \return false if the range is outside of any of the arrays
+        bool vectorRange(const FJP::VectorLoop &loop, std::initializer_list<FJP::VectorArray> arrays, int &first, int &count);
+
         /// Executes the DEC instruction.
         /// The DEC instruction does the opposite to the INC instruction.
         /// It decrements the ESP register by a value passed in the m parameter.
@@ -175,5 +387,21 @@ namespace FJP {
         /// \param program_code the instance of a program_code to be executed
         /// \param debug_mode flag if want to create an output file - stacktrace.txt
         void execute(FJP::GeneratedCode &program_code, bool debug_mode = false) override;
+
+        /// Attaches a profiler to the virtual machine.
+        /// \param profiler the profiler to be attached
+        void addProfiler(FJP::IProfiler *profiler) override;
+
+        /// Sets a sampling profiler of the virtual machine.
+        /// \param profiler the sampling profiler (nullptr turns sampling off)
+        void setSamplingProfiler(FJP::SamplingProfiler *profiler) override;
+
+        /// Sets the object publishing live statistics of the virtual machine.
+        /// \param stats live statistics (nullptr turns them off)
+        void setLiveStats(FJP::LiveStats *stats) override;
+
+        /// Turns on/off checking the indexes of arrays stored within frames against their sizes.
+        /// \param enabled check the bounds of the arrays
+        void setBoundsChecking(bool enabled) override;
     };
 }
\ No newline at end of file
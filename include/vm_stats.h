@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace FJP {
+
+    /// Prefix of the name of the shared memory segment. The full name
+    /// is made up of the prefix followed by the PID of the process (e.g. /fjp.1234).
+    static constexpr const char *VM_STATS_SHM_PREFIX = "/fjp.";
+
+    /// Magic number identifying a valid shared memory segment ("FJPS").
+    static constexpr uint32_t VM_STATS_MAGIC = 0x53504A46;
+
+    /// Version of the layout of the VMStats structure.
+    static constexpr uint32_t VM_STATS_VERSION = 1;
+
+    /// Statistics of the virtual machine published through a shared memory segment,
+    /// so they can be watched live by another process (fjp-top). There is only one
+    /// writer (the virtual machine). The sequence number works as a seqlock - it's odd
+    /// while the values are being updated, so a reader can detect a torn snapshot and retry.
+    struct VMStats {
+        uint32_t magic;                            ///< VM_STATS_MAGIC
+        uint32_t version;                          ///< VM_STATS_VERSION
+        int64_t pid;                               ///< PID of the process running the virtual machine
+        std::atomic<uint64_t> sequence;            ///< seqlock sequence number
+        std::atomic<uint64_t> instructions;        ///< number of instructions executed so far
+        std::atomic<int64_t> currentESP;           ///< current value of the stack pointer
+        std::atomic<int64_t> peakESP;              ///< highest value of the stack pointer so far
+        std::atomic<int64_t> callDepth;            ///< number of active function calls
+        std::atomic<uint64_t> reads;               ///< number of SIO read operations
+        std::atomic<uint64_t> writes;              ///< number of SIO write operations
+        std::atomic<int64_t> startTime;            ///< start of the execution (CLOCK_MONOTONIC, ns)
+        std::atomic<int64_t> endTime;              ///< end of the execution (0 while still running)
+    };
+}
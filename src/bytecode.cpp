@@ -0,0 +1,622 @@
+#include <fstream>
+#include <cstring>
+#include <cstddef>
+#include <type_traits>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# define MMAP_SUPPORTED
+#endif
+
+#include <bytecode.h>
+#include <errors.h>
+#include <stack_analyzer.h>
+
+namespace {
+
+    /// Magic number the bytecode file starts with.
+    constexpr char MAGIC[4] = {'P', 'L', '0', 'B'};
+
+    /// Offset basis of the 64-bit FNV-1a hash.
+    constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+    /// Prime of the 64-bit FNV-1a hash.
+    constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+    /// Error code used when the bytecode file cannot be stored or loaded.
+    constexpr int ERR_CODE = 1;
+
+    /// Writes the side tables of the code out as a sequence of 32-bit integers.
+    class MetadataWriter {
+    public:
+        std::vector<int32_t> words;
+
+        void write(int value) {
+            words.push_back(value);
+        }
+
+        void write(const std::string &text) {
+            write(static_cast<int>(text.size()));
+            for (size_t i = 0; i < text.size(); i += sizeof(int32_t)) {
+                int32_t word = 0;
+                std::memcpy(&word, text.data() + i, std::min(sizeof(int32_t), text.size() - i));
+                words.push_back(word);
+            }
+        }
+
+        void write(const FJP::VectorValue &value) {
+            write(value.isVariable);
+            write(value.value);
+            write(value.level);
+            write(value.address);
+        }
+
+        void write(const FJP::VectorArray &array) {
+            write(array.inDataSegment);
+            write(array.level);
+            write(array.address);
+            write(array.size);
+        }
+    };
+
+    /// Reads the side tables of the code back. Reading past the end means the file is corrupted.
+    class MetadataReader {
+    private:
+        const unsigned char *data;
+        size_t count;
+        size_t position;
+        bool failed;
+
+    public:
+        MetadataReader(const unsigned char *data, size_t count) : data(data), count(count), position(0), failed(false) {
+        }
+
+        int read() {
+            if (position >= count) {
+                failed = true;
+                return 0;
+            }
+            int32_t word;
+            std::memcpy(&word, data + position * sizeof(int32_t), sizeof(int32_t));
+            position++;
+            return word;
+        }
+
+        /// Reads the number of items that follow (each of them takes up at least one integer).
+        int readCount() {
+            int value = read();
+            if (value < 0 || static_cast<size_t>(value) > count - position) {
+                failed = true;
+                return 0;
+            }
+            return value;
+        }
+
+        std::string readString() {
+            int length = read();
+            size_t wordCount = (static_cast<size_t>(length) + sizeof(int32_t) - 1) / sizeof(int32_t);
+            if (length < 0 || wordCount > count - position) {
+                failed = true;
+                return "";
+            }
+            std::string text(reinterpret_cast<const char *>(data + position * sizeof(int32_t)), length);
+            position += wordCount;
+            return text;
+        }
+
+        FJP::VectorValue readValue() {
+            FJP::VectorValue value{};
+            value.isVariable = read() != 0;
+            value.value = read();
+            value.level = read();
+            value.address = read();
+            return value;
+        }
+
+        FJP::VectorArray readArray() {
+            FJP::VectorArray array{};
+            array.inDataSegment = read() != 0;
+            array.level = read();
+            array.address = read();
+            array.size = read();
+            return array;
+        }
+
+        /// Returns true if all integers have been read, and none of them has been missing.
+        bool isComplete() const {
+            return !failed && position == count;
+        }
+    };
+
+    /// Returns true if the range of values lies within a block of the given size.
+    bool fitsInto(int64_t first, int64_t count, int64_t size) {
+        return first >= 0 && count >= 0 && first + count <= size;
+    }
+
+    /// Returns true if an array of a vector loop stored in the data segment lies within it.
+    bool isValidArray(const FJP::VectorArray &array, int dataSize) {
+        return !array.inDataSegment || fitsInto(array.address, array.size, dataSize);
+    }
+
+    /// Makes sure all references of a loaded program (jump targets, indexes into the side tables,
+    /// blocks of the constant pool, data segment, sizes of arrays, functions) lie within the program,
+    /// and that the execution cannot run past the last instruction. The accesses to the frames are
+    /// not known until runtime, so the virtual machine checks them for a loaded program.
+    /// \param code the code loaded from the file
+    /// \return true if all references are valid
+    bool hasValidReferences(const FJP::GeneratedCode &code) {
+        int size = code.getSize();
+        int dataSize = code.getDataSize();
+        const std::vector<int> &pool = code.getConstantPool();
+        int poolSize = static_cast<int>(pool.size());
+        if (dataSize < 0) {
+            return false;
+        }
+
+        for (int i = 0; i < size; i++) {
+            FJP::Instruction instruction = code[i];
+            switch (instruction.op) {
+                case FJP::OP_CODE::JMP:
+                case FJP::OP_CODE::JPC:
+                case FJP::OP_CODE::CAL:
+                case FJP::OP_CODE::JEQ:
+                case FJP::OP_CODE::JNE:
+                case FJP::OP_CODE::JLT:
+                case FJP::OP_CODE::JLE:
+                case FJP::OP_CODE::JGT:
+                case FJP::OP_CODE::JGE:
+                case FJP::OP_CODE::JEQI:
+                case FJP::OP_CODE::JNEI:
+                case FJP::OP_CODE::JLTI:
+                case FJP::OP_CODE::JLEI:
+                case FJP::OP_CODE::JGTI:
+                case FJP::OP_CODE::JGEI:
+                    if (!fitsInto(instruction.m, 1, size)) {
+                        return false;
+                    }
+                    break;
+                case FJP::OP_CODE::JTB:
+                    if (!fitsInto(instruction.m, 1, static_cast<int64_t>(code.getJumpTables().size()))) {
+                        return false;
+                    }
+                    break;
+                case FJP::OP_CODE::ADDVI:
+                case FJP::OP_CODE::SUBVI:
+                case FJP::OP_CODE::MULVI:
+                    if (!fitsInto(instruction.m, 1, static_cast<int64_t>(code.getVariableUpdates().size()))) {
+                        return false;
+                    }
+                    break;
+                case FJP::OP_CODE::VADD:
+                case FJP::OP_CODE::VMUL:
+                case FJP::OP_CODE::VSUM:
+                case FJP::OP_CODE::VMIN:
+                case FJP::OP_CODE::VMAX:
+                case FJP::OP_CODE::VCMP:
+                case FJP::OP_CODE::VFILL:
+                    // The instruction is followed by a JMP over the loop, which it may skip.
+                    if (!fitsInto(instruction.m, 1, static_cast<int64_t>(code.getVectorLoops().size())) ||
+                        i + 2 >= size || code[i + 1].op != FJP::OP_CODE::JMP) {
+                        return false;
+                    }
+                    break;
+                case FJP::OP_CODE::CPY:
+                case FJP::OP_CODE::CPD:
+                    // A block of the constant pool (number of values, target address, values).
+                    if (!fitsInto(instruction.m, 2, poolSize) || !fitsInto(instruction.m + 2, pool[instruction.m], poolSize)) {
+                        return false;
+                    }
+                    if (instruction.op == FJP::OP_CODE::CPD && !fitsInto(pool[instruction.m + 1], pool[instruction.m], dataSize)) {
+                        return false;
+                    }
+                    break;
+                case FJP::OP_CODE::LDD:
+                case FJP::OP_CODE::STD:
+                    // The array (base address, size) has to lie within the data segment.
+                    if (!fitsInto(instruction.m, instruction.l, dataSize)) {
+                        return false;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        // The last instruction must not let the execution continue past the end of the program.
+        if (size > 0) {
+            FJP::Instruction last = code[size - 1];
+            bool isReturn = last.op == FJP::OP_CODE::OPR && last.m == FJP::OPRType::OPR_RET;
+            bool isHalt = last.op == FJP::OP_CODE::SIO && last.m == FJP::SIO_TYPE::SIO_HALT;
+            if (!isReturn && !isHalt && last.op != FJP::OP_CODE::JMP && last.op != FJP::OP_CODE::JTB) {
+                return false;
+            }
+        }
+
+        for (const auto &table : code.getJumpTables()) {
+            if (!table.dense && table.values.size() != table.targets.size()) {
+                return false;
+            }
+            for (int target : table.targets) {
+                if (!fitsInto(target, 1, size)) {
+                    return false;
+                }
+            }
+            if (!fitsInto(table.defaultTarget, 1, size)) {
+                return false;
+            }
+        }
+        for (const auto &loop : code.getVectorLoops()) {
+            if (!isValidArray(loop.destination, dataSize) || !isValidArray(loop.first, dataSize) || !isValidArray(loop.second, dataSize)) {
+                return false;
+            }
+        }
+        for (const auto &arraySize : code.getArraySizes()) {
+            if (!fitsInto(arraySize.first, 1, size)) {
+                return false;
+            }
+        }
+        for (const auto &function : code.getFunctions()) {
+            if (!fitsInto(function.first, 1, size) || function.second.endAddress < function.first || function.second.endAddress > size) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+FJP::BytecodeFile::BytecodeFile() : mapping(nullptr), mappingSize(0) {
+}
+
+FJP::BytecodeFile::~BytecodeFile() {
+    close();
+}
+
+uint64_t FJP::BytecodeFile::checksum(const unsigned char *data, size_t size) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+void FJP::BytecodeFile::store(const FJP::GeneratedCode &code, const std::string &filename) {
+    if (!write(code, filename)) {
+        FJP::exitProgramWithError(FJP::IOErrors::ERROR_01, ERR_CODE);
+    }
+}
+
+bool FJP::BytecodeFile::write(const FJP::GeneratedCode &code, const std::string &filename) {
+    MetadataWriter metadata;
+
+    // Data segment and the stack requirement.
+    metadata.write(code.getDataSize());
+    const FJP::StackBound &bound = code.getStackBound();
+    metadata.write(bound.known);
+    metadata.write(bound.recursive);
+    metadata.write(bound.maxDepth);
+    metadata.write(bound.levelCost);
+
+    // Constant pool.
+    const std::vector<int> &pool = code.getConstantPool();
+    metadata.write(static_cast<int>(pool.size()));
+    for (int value : pool) {
+        metadata.write(value);
+    }
+
+    // Loops replaced by vector instructions.
+    metadata.write(static_cast<int>(code.getVectorLoops().size()));
+    for (const auto &loop : code.getVectorLoops()) {
+        metadata.write(loop.foreachLoop);
+        metadata.write(loop.counter);
+        metadata.write(loop.bound);
+        metadata.write(loop.inclusive);
+        metadata.write(loop.iterator);
+        metadata.write(loop.target);
+        metadata.write(loop.destination);
+        metadata.write(loop.first);
+        metadata.write(loop.second);
+        metadata.write(loop.secondIsArray);
+        metadata.write(loop.operand);
+        metadata.write(loop.comparison);
+        metadata.write(loop.normalize);
+    }
+
+    // Jump tables of switch statements.
+    metadata.write(static_cast<int>(code.getJumpTables().size()));
+    for (const auto &table : code.getJumpTables()) {
+        metadata.write(table.dense);
+        metadata.write(table.low);
+        metadata.write(static_cast<int>(table.values.size()));
+        for (int value : table.values) {
+            metadata.write(value);
+        }
+        metadata.write(static_cast<int>(table.targets.size()));
+        for (int target : table.targets) {
+            metadata.write(target);
+        }
+        metadata.write(table.defaultTarget);
+    }
+
+    // In-place updates of variables by constants.
+    metadata.write(static_cast<int>(code.getVariableUpdates().size()));
+    for (const auto &update : code.getVariableUpdates()) {
+        metadata.write(update.level);
+        metadata.write(update.address);
+        metadata.write(update.value);
+    }
+
+    // Sizes of the arrays accessed by the LDX and STX instructions.
+    metadata.write(static_cast<int>(code.getArraySizes().size()));
+    for (const auto &size : code.getArraySizes()) {
+        metadata.write(size.first);
+        metadata.write(size.second);
+    }
+
+    // Line table and functions (used by the profilers).
+    metadata.write(static_cast<int>(code.getLineTable().size()));
+    for (const auto &entry : code.getLineTable()) {
+        metadata.write(entry.address);
+        metadata.write(entry.lineNumber);
+    }
+    metadata.write(static_cast<int>(code.getFunctions().size()));
+    for (const auto &function : code.getFunctions()) {
+        metadata.write(function.first);
+        metadata.write(function.second.endAddress);
+        metadata.write(function.second.name);
+    }
+
+    // The packed instructions are followed by the wide ones and the metadata, all of them covered by the checksum.
+    const FJP::PackedCode packed = code.pack();
+    const size_t packedSize = packed.instructions.size() * sizeof(FJP::PackedInstruction);
+    const size_t wideSize = packed.wideInstructions.size() * sizeof(FJP::Instruction);
+    std::vector<unsigned char> body(packedSize + wideSize + metadata.words.size() * sizeof(int32_t));
+    if (packedSize > 0) {
+        std::memcpy(body.data(), packed.instructions.data(), packedSize);
+    }
+    if (wideSize > 0) {
+        std::memcpy(body.data() + packedSize, packed.wideInstructions.data(), wideSize);
+    }
+    if (!metadata.words.empty()) {
+        std::memcpy(body.data() + packedSize + wideSize, metadata.words.data(), metadata.words.size() * sizeof(int32_t));
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.instructionSize = sizeof(FJP::Instruction);
+    header.instructionCount = static_cast<uint32_t>(packed.instructions.size());
+    header.wideCount = static_cast<uint32_t>(packed.wideInstructions.size());
+    header.metadataSize = static_cast<uint32_t>(metadata.words.size());
+    header.checksum = checksum(body.data(), body.size());
+
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(body.data()), static_cast<std::streamsize>(body.size()));
+    file.close();
+    return static_cast<bool>(file);
+}
+
+const unsigned char *FJP::BytecodeFile::open(const std::string &filename, size_t &size) {
+    close();
+
+#ifdef MMAP_SUPPORTED
+    int descriptor = ::open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return nullptr;
+    }
+    struct stat status {};
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+        void *address = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (address != MAP_FAILED) {
+            mapping = address;
+            mappingSize = static_cast<size_t>(status.st_size);
+        }
+    }
+    ::close(descriptor);
+    if (mapping != nullptr) {
+        size = mappingSize;
+        return static_cast<const unsigned char *>(mapping);
+    }
+#endif
+
+    // The file cannot be mapped, so it is read into an aligned buffer instead.
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return nullptr;
+    }
+    size = static_cast<size_t>(file.tellg());
+    buffer.assign((size + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(buffer.data()), static_cast<std::streamsize>(size));
+    return reinterpret_cast<const unsigned char *>(buffer.data());
+}
+
+void FJP::BytecodeFile::close() {
+#ifdef MMAP_SUPPORTED
+    if (mapping != nullptr) {
+        munmap(mapping, mappingSize);
+    }
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    buffer.clear();
+}
+
+FJP::GeneratedCode FJP::BytecodeFile::load(const std::string &filename) {
+    FJP::GeneratedCode code;
+    const char *error = read(filename, code);
+    if (error != nullptr) {
+        FJP::exitProgramWithError(error, ERR_CODE);
+    }
+    return code;
+}
+
+bool FJP::BytecodeFile::tryLoad(const std::string &filename, FJP::GeneratedCode &code) {
+    FJP::GeneratedCode loaded;
+    if (read(filename, loaded) != nullptr) {
+        close();
+        return false;
+    }
+    code = loaded;
+    return true;
+}
+
+const char *FJP::BytecodeFile::read(const std::string &filename, FJP::GeneratedCode &code) {
+    size_t size = 0;
+    const unsigned char *data = open(filename, size);
+    if (data == nullptr) {
+        return FJP::IOErrors::ERROR_00;
+    }
+
+    // Make sure the file has been written by the same version of the compiler on the same kind of machine.
+    Header header{};
+    if (size < sizeof(header)) {
+        return FJP::IOErrors::ERROR_03;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        return FJP::IOErrors::ERROR_03;
+    }
+    if (header.version != VERSION || header.byteOrder != BYTE_ORDER_MARK || header.instructionSize != sizeof(FJP::Instruction)) {
+        return FJP::IOErrors::ERROR_04;
+    }
+
+    // Make sure the file is complete and has not been modified.
+    uint64_t packedSize = static_cast<uint64_t>(header.instructionCount) * sizeof(FJP::PackedInstruction);
+    uint64_t instructionsSize = packedSize + static_cast<uint64_t>(header.wideCount) * sizeof(FJP::Instruction);
+    uint64_t expectedSize = sizeof(header) + instructionsSize + static_cast<uint64_t>(header.metadataSize) * sizeof(int32_t);
+    if (expectedSize != size || checksum(data + sizeof(header), size - sizeof(header)) != header.checksum) {
+        return FJP::IOErrors::ERROR_05;
+    }
+
+    // The packed instructions are executed right from the file, so each reference
+    // to a wide instruction has to point into the table following them.
+    FJP::PackedCodeView instructions{reinterpret_cast<const FJP::PackedInstruction *>(data + sizeof(header)),
+                                     reinterpret_cast<const FJP::Instruction *>(data + sizeof(header) + packedSize),
+                                     static_cast<int>(header.instructionCount)};
+    // Every OP code is checked before the instructions are unpacked, so none of them holds an invalid value.
+    for (int i = 0; i < instructions.size; i++) {
+        FJP::PackedInstruction instruction = instructions.instructions[i];
+        uint32_t op = instruction & 0xFF;
+        if (op == FJP::PACKED_WIDE ? (instruction >> 32) >= header.wideCount : !FJP::is_op_code(op)) {
+            return FJP::IOErrors::ERROR_05;
+        }
+    }
+    for (uint32_t i = 0; i < header.wideCount; i++) {
+        std::underlying_type_t<FJP::OP_CODE> op;
+        std::memcpy(&op, data + sizeof(header) + packedSize + i * sizeof(FJP::Instruction) + offsetof(FJP::Instruction, op), sizeof(op));
+        if (!FJP::is_op_code(static_cast<uint32_t>(op))) {
+            return FJP::IOErrors::ERROR_05;
+        }
+    }
+    code.mapInstructions(instructions);
+
+    // The rest of the code is read in the same order it has been stored.
+    MetadataReader metadata(data + sizeof(header) + instructionsSize, header.metadataSize);
+    code.allocateData(metadata.read());
+    FJP::StackBound bound{};
+    bound.known = metadata.read() != 0;
+    bound.recursive = metadata.read() != 0;
+    bound.maxDepth = metadata.read();
+    bound.levelCost = metadata.read();
+    code.setStackBound(bound);
+
+    // The constant pool consists of blocks (number of values, target address, values).
+    int poolSize = metadata.readCount();
+    while (poolSize > 0) {
+        int count = metadata.readCount();
+        if (count + 2 > poolSize) {
+            return FJP::IOErrors::ERROR_05;
+        }
+        int address = metadata.read();
+        std::vector<int> values(count);
+        for (int &value : values) {
+            value = metadata.read();
+        }
+        code.addConstants(address, values);
+        poolSize -= count + 2;
+    }
+
+    int loopCount = metadata.readCount();
+    for (int i = 0; i < loopCount; i++) {
+        FJP::VectorLoop loop{};
+        loop.foreachLoop = metadata.read() != 0;
+        loop.counter = metadata.readValue();
+        loop.bound = metadata.readValue();
+        loop.inclusive = metadata.read() != 0;
+        loop.iterator = metadata.readValue();
+        loop.target = metadata.readValue();
+        loop.destination = metadata.readArray();
+        loop.first = metadata.readArray();
+        loop.second = metadata.readArray();
+        loop.secondIsArray = metadata.read() != 0;
+        loop.operand = metadata.readValue();
+        loop.comparison = metadata.read();
+        loop.normalize = metadata.read() != 0;
+        code.addVectorLoop(loop);
+    }
+
+    int tableCount = metadata.readCount();
+    for (int i = 0; i < tableCount; i++) {
+        FJP::JumpTable table{};
+        table.dense = metadata.read() != 0;
+        table.low = metadata.read();
+        table.values.resize(metadata.readCount());
+        for (int &value : table.values) {
+            value = metadata.read();
+        }
+        table.targets.resize(metadata.readCount());
+        for (int &target : table.targets) {
+            target = metadata.read();
+        }
+        table.defaultTarget = metadata.read();
+        code.addJumpTable(table);
+    }
+
+    int updateCount = metadata.readCount();
+    for (int i = 0; i < updateCount; i++) {
+        FJP::VariableUpdate update{};
+        update.level = metadata.read();
+        update.address = metadata.read();
+        update.value = metadata.read();
+        code.addVariableUpdate(update);
+    }
+
+    int arrayCount = metadata.readCount();
+    for (int i = 0; i < arrayCount; i++) {
+        int address = metadata.read();
+        code.setArraySize(address, metadata.read());
+    }
+
+    std::vector<FJP::LineTableEntry> lineTable(metadata.readCount());
+    for (auto &entry : lineTable) {
+        entry.address = metadata.read();
+        entry.lineNumber = metadata.read();
+    }
+    code.setLineTable(lineTable);
+
+    int functionCount = metadata.readCount();
+    for (int i = 0; i < functionCount; i++) {
+        int address = metadata.read();
+        int endAddress = metadata.read();
+        code.addFunction(address, endAddress, metadata.readString());
+    }
+
+    if (!metadata.isComplete() || !hasValidReferences(code)) {
+        return FJP::IOErrors::ERROR_05;
+    }
+
+    // A proven stack bound lets the virtual machine skip checking the stack, so the stored
+    // one is not trusted. It is computed again the same way the parser computes it.
+    code.setStackBound(FJP::StackAnalyzer(code).analyze());
+    return nullptr;
+}
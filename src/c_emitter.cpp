@@ -0,0 +1,567 @@
+#include <fstream>
+
+#include <c_emitter.h>
+#include <vm.h>
+#include <errors.h>
+
+FJP::CEmitter::CEmitter(const FJP::GeneratedCode &code, bool checkBounds) : program(code),
+                                                                            boundsChecking(checkBounds),
+                                                                            stackBoundProven(false),
+                                                                            stackSize(0),
+                                                                            usesDataSegment(false) {
+}
+
+void FJP::CEmitter::emit(const std::string &filename) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        FJP::exitProgramWithError(FJP::IOErrors::ERROR_01, ERR_CODE);
+    }
+
+    allocateStack();
+    findLabels();
+
+    emitPrologue(file);
+    for (int address = 0; address < program.getSize(); address++) {
+        emitInstruction(file, address);
+    }
+    emitEpilogue(file);
+}
+
+void FJP::CEmitter::allocateStack() {
+    const FJP::StackBound &bound = program.getStackBound();
+
+    // The very same way the virtual machine sizes up its stack (see VirtualMachine::allocateStack).
+    stackBoundProven = bound.known && !bound.recursive && bound.maxDepth <= FJP::VirtualMachine::STACK_SIZE;
+    if (stackBoundProven) {
+        stackSize = bound.maxDepth + 1;
+    } else {
+        stackSize = FJP::VirtualMachine::STACK_SIZE + FJP::VirtualMachine::CALL_SIZE + 1;
+    }
+}
+
+void FJP::CEmitter::findLabels() {
+    labels.clear();
+    returnAddresses.clear();
+    usesDataSegment = false;
+    for (int address = 0; address < program.getSize(); address++) {
+        const FJP::Instruction &instruction = program[address];
+        switch (instruction.op) {
+            case CAL:
+                labels.insert(instruction.m);
+                labels.insert(address + 1);
+                returnAddresses.insert(address + 1);
+                break;
+            case JMP:
+            case JPC:
+            case JEQ:
+            case JNE:
+            case JLT:
+            case JLE:
+            case JGT:
+            case JGE:
+            case JEQI:
+            case JNEI:
+            case JLTI:
+            case JLEI:
+            case JGTI:
+            case JGEI:
+                labels.insert(instruction.m);
+                break;
+            case JTB: {
+                const FJP::JumpTable &table = program.getJumpTable(instruction.m);
+                labels.insert(table.targets.begin(), table.targets.end());
+                labels.insert(table.defaultTarget);
+                break;
+            }
+            // The loop replaced by a vector instruction starts right after the JMP over it.
+            case VADD:
+            case VMUL:
+            case VSUM:
+            case VMIN:
+            case VMAX:
+            case VCMP:
+            case VFILL:
+                labels.insert(address + 2);
+                break;
+            case LDD:
+            case STD:
+            case CPD:
+                usesDataSegment = true;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+std::string FJP::CEmitter::base(int l) {
+    if (l == 0) {
+        return "EBP";
+    }
+    return "fjp_base(" + std::to_string(l) + ", EBP)";
+}
+
+std::string FJP::CEmitter::label(int address) {
+    return "L" + std::to_string(address);
+}
+
+const char *FJP::CEmitter::comparisonOperator(int comparison) {
+    switch (comparison) {
+        case OPR_EQ:
+            return "==";
+        case OPR_NEQ:
+            return "!=";
+        case OPR_LESS:
+            return "<";
+        case OPR_LESS_EQ:
+            return "<=";
+        case OPR_GRT:
+            return ">";
+        case OPR_GRT_EQ:
+            return ">=";
+    }
+    return "==";
+}
+
+void FJP::CEmitter::emitPushCheck(std::ostream &out) const {
+    if (!stackBoundProven) {
+        out << "    if (ESP == " << FJP::VirtualMachine::STACK_SIZE << ") fjp_error(FJP_ERROR_STACK);\n";
+    }
+}
+
+void FJP::CEmitter::emitPrologue(std::ostream &out) const {
+    out << "/* Generated by the FJP compiler (fjp --emit-c). */\n"
+           "\n"
+           "#include <ctype.h>\n"
+           "#include <limits.h>\n"
+           "#include <stdio.h>\n"
+           "#include <stdlib.h>\n"
+           "#include <string.h>\n"
+           "\n";
+
+    // The runtime errors are reported with the same messages and the same exit code as the virtual machine.
+    out << "#define FJP_ERROR_STACK \"" << FJP::RuntimeErrors::ERROR_00 << "\"\n"
+        << "#define FJP_ERROR_DIVISION \"" << FJP::RuntimeErrors::ERROR_01 << "\"\n"
+        << "#define FJP_ERROR_OVERFLOW \"" << FJP::RuntimeErrors::ERROR_02 << "\"\n"
+        << "#define FJP_ERROR_INDEX \"" << FJP::RuntimeErrors::ERROR_03 << "\"\n"
+        << "#define FJP_ERROR_CODE " << FJP::VirtualMachine::ERROR_CODE << "\n"
+        << "\n";
+
+    // The stack, the data segment (global arrays), and the constant pool (array initializers).
+    // The data segment is left out if no instruction accesses it, so the output compiles without warnings.
+    const std::vector<int> &pool = program.getConstantPool();
+    out << "static int stack[" << stackSize << "];\n";
+    if (usesDataSegment && program.getDataSize() > 0) {
+        out << "static int data[" << program.getDataSize() << "];\n";
+    }
+    if (!pool.empty()) {
+        out << "static const int pool[" << pool.size() << "] = {";
+        for (size_t i = 0; i < pool.size(); i++) {
+            out << (i % 16 == 0 ? "\n    " : " ") << pool[i] << (i + 1 < pool.size() ? "," : "");
+        }
+        out << "\n};\n";
+    }
+
+    out << R"(static int fjp_input_failed;
+
+static void fjp_error(const char *message) {
+    printf("%s\n", message);
+    exit(FJP_ERROR_CODE);
+}
+
+/* Calculates the base of the frame l levels down the static links. */
+static inline int fjp_base(int l, int base) {
+    while (l > 0) {
+        base = stack[base + 1];
+        l--;
+    }
+    return base;
+}
+
+/* The arithmetic wraps around, and the overflow is detected the same way the virtual machine does. */
+static inline int fjp_add(int x, int y) {
+    int result = (int)((unsigned)x + (unsigned)y);
+    if ((x < 0 && y < 0 && result > 0) || (x > 0 && y > 0 && result < 0)) {
+        fjp_error(FJP_ERROR_OVERFLOW);
+    }
+    return result;
+}
+
+static inline int fjp_sub(int x, int y) {
+    return (int)((unsigned)x - (unsigned)y);
+}
+
+static inline int fjp_mul(int x, int y) {
+    int result = (int)((unsigned)x * (unsigned)y);
+    if ((x < 0 && y < 0 && result > 0) || (x > 0 && y > 0 && result < 0)) {
+        fjp_error(FJP_ERROR_OVERFLOW);
+    }
+    return result;
+}
+
+static inline int fjp_div(int x, int y) {
+    if (y == 0) {
+        fjp_error(FJP_ERROR_DIVISION);
+    }
+    return x / y;
+}
+
+/* Calculates the address of an element of an array stored within a frame (LDX, STX). */
+static inline int fjp_element(int base, int m, int index, int ESP) {
+    long long address = (long long)base + m + index;
+    if (address > ESP || address < 0) {
+        int sum = (int)((unsigned)index + (unsigned)m);
+        if ((index < 0 && m < 0 && sum > 0) || (index > 0 && m > 0 && sum < 0)) {
+            fjp_error(FJP_ERROR_OVERFLOW);
+        }
+        fjp_error(FJP_ERROR_STACK);
+    }
+    return (int)address;
+}
+
+/* Reads a number the way std::cin >> int does. If there is no number, 0 is stored, and if it does
+   not fit in an int, INT_MAX or INT_MIN is. Once the input fails or ends, nothing is stored any more. */
+static inline void fjp_read(int *value) {
+    int c;
+    int negative = 0;
+    int digits = 0;
+    long long number = 0;
+
+    if (fjp_input_failed) {
+        return;
+    }
+    fflush(stdout);
+    do {
+        c = getchar();
+    } while (c != EOF && isspace(c));
+    if (c == EOF) {
+        fjp_input_failed = 1;
+        return;
+    }
+    if (c == '+' || c == '-') {
+        negative = (c == '-');
+        c = getchar();
+    }
+    for (; c != EOF && isdigit(c); c = getchar()) {
+        if (number <= (long long)INT_MAX + 1) {
+            number = number * 10 + (c - '0');
+        }
+        digits++;
+    }
+    if (c == EOF) {
+        fjp_input_failed = 1;
+    } else {
+        ungetc(c, stdin);
+    }
+    if (digits == 0) {
+        fjp_input_failed = 1;
+        *value = 0;
+    } else if (negative && -number < INT_MIN) {
+        fjp_input_failed = 1;
+        *value = INT_MIN;
+    } else if (!negative && number > INT_MAX) {
+        fjp_input_failed = 1;
+        *value = INT_MAX;
+    } else {
+        *value = (int)(negative ? -number : number);
+    }
+}
+
+int main(void) {
+    int ESP = 0;
+    int EBP = 1;
+    int EIP = 0;
+
+)";
+
+    // Let the user know up front the program is going to fail.
+    const FJP::StackBound &bound = program.getStackBound();
+    if (!stackBoundProven && bound.known && bound.maxDepth > FJP::VirtualMachine::STACK_SIZE) {
+        out << "    fputs(\"warning: the program needs " << bound.maxDepth << " slots of the stack";
+        if (bound.recursive) {
+            out << " (+" << bound.levelCost << " per level of recursion)";
+        }
+        out << ", but the stack has only " << FJP::VirtualMachine::STACK_SIZE << "\\n\", stderr);\n\n";
+    }
+}
+
+void FJP::CEmitter::emitInstruction(std::ostream &out, int address) const {
+    const FJP::Instruction &instruction = program[address];
+    int l = instruction.l;
+    int m = instruction.m;
+
+    if (labels.count(address)) {
+        out << label(address) << ":\n";
+    }
+    out << "    /* " << address << ": " << instruction << " */\n";
+
+    switch (instruction.op) {
+        case LIT:
+            emitPushCheck(out);
+            out << "    stack[++ESP] = " << m << ";\n";
+            break;
+        case OPR:
+            emitOperation(out, m);
+            break;
+        case LOD:
+            emitPushCheck(out);
+            out << "    ESP++;\n"
+                << "    stack[ESP] = stack[" << base(l) << " + " << m << "];\n";
+            break;
+        case STO:
+            out << "    stack[" << base(l) << " + " << m << "] = stack[ESP];\n"
+                << "    ESP--;\n";
+            break;
+        case CAL:
+            out << "    stack[ESP + 1] = 0;\n"
+                << "    stack[ESP + 2] = " << base(l) << ";\n"
+                << "    stack[ESP + 3] = EBP;\n"
+                << "    stack[ESP + 4] = " << address + 1 << ";\n"
+                << "    EBP = ESP + 1;\n"
+                << "    goto " << label(m) << ";\n";
+            break;
+        case INC:
+            if (!stackBoundProven) {
+                out << "    if (" << m << " + ESP > " << FJP::VirtualMachine::STACK_SIZE << ") fjp_error(FJP_ERROR_STACK);\n";
+            }
+            out << "    ESP += " << m << ";\n";
+            break;
+        case JMP:
+            out << "    goto " << label(m) << ";\n";
+            break;
+        case JPC:
+            out << "    ESP--;\n"
+                << "    if (stack[ESP + 1] == 0) goto " << label(m) << ";\n";
+            break;
+        case JEQ:
+        case JNE:
+        case JLT:
+        case JLE:
+        case JGT:
+        case JGE:
+            out << "    ESP -= 2;\n"
+                << "    if (stack[ESP + 1] " << comparisonOperator(FJP::branch_comparison(instruction.op))
+                << " stack[ESP + 2]) goto " << label(m) << ";\n";
+            break;
+        case JEQI:
+        case JNEI:
+        case JLTI:
+        case JLEI:
+        case JGTI:
+        case JGEI:
+            out << "    ESP--;\n"
+                << "    if (stack[ESP + 1] " << comparisonOperator(FJP::branch_comparison(instruction.op))
+                << " " << l << ") goto " << label(m) << ";\n";
+            break;
+        case ADDI:
+            out << "    stack[ESP] = fjp_add(stack[ESP], " << m << ");\n";
+            break;
+        case SUBI:
+            out << "    stack[ESP] = fjp_sub(stack[ESP], " << m << ");\n";
+            break;
+        case MULI:
+            out << "    stack[ESP] = fjp_mul(stack[ESP], " << m << ");\n";
+            break;
+        case CMPI:
+            out << "    stack[ESP] = stack[ESP] " << comparisonOperator(l) << " " << m << ";\n";
+            break;
+        case ADDV:
+        case SUBV:
+        case MULV: {
+            const char *function = instruction.op == ADDV ? "fjp_add" : (instruction.op == SUBV ? "fjp_sub" : "fjp_mul");
+            std::string variable = "stack[" + base(l) + " + " + std::to_string(m) + "]";
+            out << "    ESP--;\n"
+                << "    " << variable << " = " << function << "(" << variable << ", stack[ESP + 1]);\n";
+            break;
+        }
+        case ADDVI:
+        case SUBVI:
+        case MULVI: {
+            // The constant of the update is known at compile time, so it gets inlined.
+            const FJP::VariableUpdate &update = program.getVariableUpdate(m);
+            const char *function = instruction.op == ADDVI ? "fjp_add" : (instruction.op == SUBVI ? "fjp_sub" : "fjp_mul");
+            std::string variable = "stack[" + base(update.level) + " + " + std::to_string(update.address) + "]";
+            out << "    " << variable << " = " << function << "(" << variable << ", " << update.value << ");\n";
+            break;
+        }
+        case JTB: {
+            const FJP::JumpTable &table = program.getJumpTable(m);
+            out << "    ESP--;\n"
+                << "    switch (stack[ESP + 1]) {\n";
+            for (size_t i = 0; i < table.targets.size(); i++) {
+                if (table.dense && table.targets[i] == table.defaultTarget) {
+                    continue;
+                }
+                long long value = table.dense ? static_cast<long long>(table.low) + static_cast<long long>(i) : table.values[i];
+                out << "        case " << value << ": goto " << label(table.targets[i]) << ";\n";
+            }
+            out << "        default: goto " << label(table.defaultTarget) << ";\n"
+                << "    }\n";
+            break;
+        }
+        case SIO:
+            switch (m) {
+                case SIO_WRITE:
+                    out << "    printf(\"%d\\n\", stack[ESP]);\n"
+                        << "    ESP--;\n";
+                    break;
+                case SIO_READ:
+                    emitPushCheck(out);
+                    out << "    ESP++;\n"
+                        << "    fjp_read(&stack[ESP]);\n";
+                    break;
+                case SIO_HALT:
+                    out << "    goto end;\n";
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case LDA:
+            out << "    {\n"
+                << "        int address = " << base(l) << " + stack[ESP];\n"
+                << "        if (address > ESP || address < 0) fjp_error(FJP_ERROR_STACK);\n"
+                << "        stack[ESP] = stack[address];\n"
+                << "    }\n";
+            break;
+        case STA:
+            out << "    if (ESP < 2) fjp_error(FJP_ERROR_STACK);\n"
+                << "    {\n"
+                << "        int address = " << base(l) << " + stack[ESP - 1];\n"
+                << "        if (address > ESP || address < 0) fjp_error(FJP_ERROR_STACK);\n"
+                << "        stack[address] = stack[ESP];\n"
+                << "        ESP -= 2;\n"
+                << "    }\n";
+            break;
+        case LDD:
+            out << "    if (stack[ESP] < 0 || stack[ESP] >= " << l << ") fjp_error(FJP_ERROR_INDEX);\n"
+                << "    stack[ESP] = data[" << m << " + stack[ESP]];\n";
+            break;
+        case STD:
+            out << "    if (stack[ESP - 1] < 0 || stack[ESP - 1] >= " << l << ") fjp_error(FJP_ERROR_INDEX);\n"
+                << "    data[" << m << " + stack[ESP - 1]] = stack[ESP];\n"
+                << "    ESP -= 2;\n";
+            break;
+        case LDX:
+        case STX: {
+            // The index lies on the top of the stack (LDX) or right below the value (STX).
+            std::string index = instruction.op == LDX ? "stack[ESP]" : "stack[ESP - 1]";
+            int size = program.getArraySize(address);
+            if (instruction.op == STX) {
+                out << "    if (ESP < 2) fjp_error(FJP_ERROR_STACK);\n";
+            }
+            if (boundsChecking) {
+                out << "    if (" << index << " < 0";
+                if (size >= 0) {
+                    out << " || " << index << " >= " << size;
+                }
+                out << ") fjp_error(FJP_ERROR_INDEX);\n";
+            }
+            std::string element = "stack[fjp_element(" + base(l) + ", " + std::to_string(m) + ", " + index + ", ESP)]";
+            if (instruction.op == LDX) {
+                out << "    stack[ESP] = " << element << ";\n";
+            } else {
+                out << "    " << element << " = stack[ESP];\n"
+                    << "    ESP -= 2;\n";
+            }
+            break;
+        }
+        case CPY: {
+            // The block of the constant pool is known at compile time, so is its target address within the frame.
+            const std::vector<int> &pool = program.getConstantPool();
+            int count = pool[m];
+            out << "    {\n"
+                << "        int address = " << base(l) << " + " << pool[m + 1] << ";\n"
+                << "        if (address < 0 || address + " << count - 1 << " > ESP) fjp_error(FJP_ERROR_STACK);\n"
+                << "        memcpy(&stack[address], &pool[" << m + 2 << "], " << count << " * sizeof(int));\n"
+                << "    }\n";
+            break;
+        }
+        case CPD: {
+            const std::vector<int> &pool = program.getConstantPool();
+            out << "    memcpy(&data[" << pool[m + 1] << "], &pool[" << m + 2 << "], " << pool[m] << " * sizeof(int));\n";
+            break;
+        }
+        // The C compiler optimizes the original loop on its own, so it is always executed
+        // (the vector instruction is allowed to fall through to it anyway).
+        case VADD:
+        case VMUL:
+        case VSUM:
+        case VMIN:
+        case VMAX:
+        case VCMP:
+        case VFILL:
+            out << "    goto " << label(address + 2) << ";\n";
+            break;
+    }
+}
+
+void FJP::CEmitter::emitOperation(std::ostream &out, int m) const {
+    switch (m) {
+        case OPR_RET:
+            // The main block of the program returns to the base pointer 0, which terminates the program.
+            out << "    ESP = EBP - 1;\n"
+                << "    EIP = stack[ESP + 4];\n"
+                << "    EBP = stack[ESP + 3];\n"
+                << "    if (EBP == 0) goto end;\n"
+                << "    goto dispatch;\n";
+            break;
+        case OPR_INVERT_VALUE:
+            out << "    stack[ESP] = fjp_sub(0, stack[ESP]);\n";
+            break;
+        case OPR_PLUS:
+            out << "    ESP--;\n"
+                << "    stack[ESP] = fjp_add(stack[ESP], stack[ESP + 1]);\n";
+            break;
+        case OPR_MINUS:
+            out << "    ESP--;\n"
+                << "    stack[ESP] = fjp_sub(stack[ESP], stack[ESP + 1]);\n";
+            break;
+        case OPR_MUL:
+            out << "    ESP--;\n"
+                << "    stack[ESP] = fjp_mul(stack[ESP], stack[ESP + 1]);\n";
+            break;
+        case OPR_DIV:
+            out << "    ESP--;\n"
+                << "    stack[ESP] = fjp_div(stack[ESP], stack[ESP + 1]);\n";
+            break;
+        case OPR_ODD:
+            out << "    stack[ESP] = stack[ESP] % 2;\n";
+            break;
+        case OPR_MOD:
+            out << "    ESP--;\n"
+                << "    stack[ESP] = stack[ESP] % stack[ESP + 1];\n";
+            break;
+        case OPR_EQ:
+        case OPR_NEQ:
+        case OPR_LESS:
+        case OPR_LESS_EQ:
+        case OPR_GRT:
+        case OPR_GRT_EQ:
+            out << "    ESP--;\n"
+                << "    stack[ESP] = stack[ESP] " << comparisonOperator(m) << " stack[ESP + 1];\n";
+            break;
+        default:
+            break;
+    }
+}
+
+void FJP::CEmitter::emitEpilogue(std::ostream &out) const {
+    // A jump may target the address right after the last instruction.
+    if (labels.count(program.getSize())) {
+        out << label(program.getSize()) << ":\n";
+    }
+    out << "    goto end;\n"
+           "\n"
+           "dispatch:\n"
+           "    switch (EIP) {\n";
+    for (int address : returnAddresses) {
+        out << "        case " << address << ": goto " << label(address) << ";\n";
+    }
+    out << "        default: break;\n"
+           "    }\n"
+           "\n"
+           "end:\n"
+           "    return 0;\n"
+           "}\n";
+}
@@ -0,0 +1,123 @@
+#include <fstream>
+#include <iomanip>
+#include <set>
+
+#include <call_profiler.h>
+#include <errors.h>
+
+FJP::CallProfiler::CallProfiler() : currentNode(0) {
+    // The root of the call tree is the main block of the program (address 0).
+    nodes.push_back({-1, 0, 1, 0, {}});
+}
+
+void FJP::CallProfiler::instructionExecuted(int address) {
+    // Just so the compiler doesn't complain about an unused value.
+    (void)address;
+
+    nodes[currentNode].exclusive++;
+}
+
+void FJP::CallProfiler::functionCalled(int address) {
+    // Find the call path extended by the function or create it
+    // if the function has not been called from this path yet.
+    auto child = nodes[currentNode].children.find(address);
+    int childNode;
+    if (child == nodes[currentNode].children.end()) {
+        childNode = static_cast<int>(nodes.size());
+        nodes[currentNode].children[address] = childNode;
+        nodes.push_back({currentNode, address, 0, 0, {}});
+    } else {
+        childNode = child->second;
+    }
+    nodes[childNode].calls++;
+    currentNode = childNode;
+}
+
+void FJP::CallProfiler::functionReturned() {
+    // The main block returns as well (the end of the program),
+    // so make sure we never leave the root of the call tree.
+    if (nodes[currentNode].parent >= 0) {
+        currentNode = nodes[currentNode].parent;
+    }
+}
+
+std::string FJP::CallProfiler::getCallPath(int node, const FJP::GeneratedCode &program) const {
+    std::string path = program.getFunctionName(nodes[node].function);
+    for (int parent = nodes[node].parent; parent >= 0; parent = nodes[parent].parent) {
+        path = program.getFunctionName(nodes[parent].function) + ";" + path;
+    }
+    return path;
+}
+
+bool FJP::CallProfiler::isRecursiveCall(int node) const {
+    for (int parent = nodes[node].parent; parent >= 0; parent = nodes[parent].parent) {
+        if (nodes[parent].function == nodes[node].function) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FJP::CallProfiler::report(const FJP::GeneratedCode &program) {
+    // Child nodes are always created after their parents, so going through
+    // the nodes backwards we can sum up the inclusive counts in a single pass.
+    std::vector<uint64_t> inclusive(nodes.size(), 0);
+    for (int node = static_cast<int>(nodes.size()) - 1; node >= 0; node--) {
+        inclusive[node] += nodes[node].exclusive;
+        if (nodes[node].parent >= 0) {
+            inclusive[nodes[node].parent] += inclusive[node];
+        }
+    }
+
+    // Aggregate the counts per function. The inclusive count of a recursive call is already
+    // included in the inclusive count of the outermost call, so it must not be counted twice.
+    struct FunctionStats {
+        uint64_t calls;
+        uint64_t exclusive;
+        uint64_t inclusive;
+    };
+    std::map<int, FunctionStats> functions;
+    for (size_t node = 0; node < nodes.size(); node++) {
+        auto &stats = functions[nodes[node].function];
+        stats.calls += nodes[node].calls;
+        stats.exclusive += nodes[node].exclusive;
+        if (!isRecursiveCall(static_cast<int>(node))) {
+            stats.inclusive += inclusive[node];
+        }
+    }
+
+    // Collapsed stacks - one line per call path with the number of instructions
+    // executed directly in it. This is the input format of flamegraph.pl and alike.
+    std::ofstream foldedFile(OUTPUT_FOLDED_FILE);
+    if (!foldedFile.is_open()) {
+        FJP::exitProgramWithError(FJP::IOErrors::ERROR_01, ERR_CODE);
+    }
+    for (size_t node = 0; node < nodes.size(); node++) {
+        if (nodes[node].exclusive > 0) {
+            foldedFile << getCallPath(static_cast<int>(node), program) << " " << nodes[node].exclusive << "\n";
+        }
+    }
+    foldedFile.close();
+
+    // Summary of the profile - the counts per function and per call path.
+    std::ofstream file(OUTPUT_FILE);
+    if (!file.is_open()) {
+        FJP::exitProgramWithError(FJP::IOErrors::ERROR_01, ERR_CODE);
+    }
+    file << "total instructions executed: " << inclusive[0] << "\n\n";
+    file << std::setw(12) << "calls" << std::setw(14) << "exclusive" << std::setw(14) << "inclusive" << "  function\n";
+    for (const auto &function : functions) {
+        file << std::setw(12) << function.second.calls
+             << std::setw(14) << function.second.exclusive
+             << std::setw(14) << function.second.inclusive
+             << "  " << program.getFunctionName(function.first) << "\n";
+    }
+    file << "\n" << std::setw(12) << "calls" << std::setw(14) << "exclusive" << std::setw(14) << "inclusive" << "  call path\n";
+    for (size_t node = 0; node < nodes.size(); node++) {
+        file << std::setw(12) << nodes[node].calls
+             << std::setw(14) << nodes[node].exclusive
+             << std::setw(14) << inclusive[node]
+             << "  " << getCallPath(static_cast<int>(node), program) << "\n";
+    }
+    file.close();
+}
@@ -1,9 +1,14 @@
+#include <algorithm>
+
 #include <code.h>
 
-FJP::GeneratedCode::GeneratedCode() {
+FJP::GeneratedCode::GeneratedCode() : mappedCode{nullptr, nullptr, 0}, stackBound{false, false, 0, 0}, dataSize(0) {
 }
 
 int FJP::GeneratedCode::getSize() const {
+    if (mappedCode.instructions != nullptr) {
+        return mappedCode.size;
+    }
     return static_cast<int>(code.size());
 }
 
@@ -11,6 +16,304 @@ FJP::Instruction &FJP::GeneratedCode::operator[](size_t index) {
     return code[index];
 }
 
+FJP::Instruction FJP::GeneratedCode::operator[](size_t index) const {
+    if (mappedCode.instructions != nullptr) {
+        return FJP::unpack_instruction(mappedCode.instructions[index], mappedCode.wideInstructions);
+    }
+    return code[index];
+}
+
+FJP::PackedCode FJP::GeneratedCode::pack() const {
+    FJP::PackedCode packed;
+    int size = getSize();
+    packed.instructions.reserve(size);
+    for (int i = 0; i < size; i++) {
+        FJP::Instruction instruction = (*this)[i];
+        if (FJP::fits_packed(instruction)) {
+            packed.instructions.push_back(FJP::pack_instruction(instruction));
+        } else {
+            packed.instructions.push_back(FJP::pack_wide_instruction(static_cast<int>(packed.wideInstructions.size())));
+            packed.wideInstructions.push_back(instruction);
+        }
+    }
+    return packed;
+}
+
+const FJP::PackedCodeView *FJP::GeneratedCode::getMappedInstructions() const {
+    if (mappedCode.instructions != nullptr) {
+        return &mappedCode;
+    }
+    return nullptr;
+}
+
+void FJP::GeneratedCode::mapInstructions(const FJP::PackedCodeView &instructions) {
+    code.clear();
+    mappedCode = instructions;
+}
+
 void FJP::GeneratedCode::addInstruction(FJP::Instruction instruction) {
     code.push_back(instruction);
-}
\ No newline at end of file
+}
+
+void FJP::GeneratedCode::moveTargets(int position, int address, int count) {
+    for (size_t i = position; i < code.size(); i++) {
+        switch (code[i].op) {
+            case FJP::OP_CODE::JMP:
+            case FJP::OP_CODE::JPC:
+            case FJP::OP_CODE::CAL:
+            case FJP::OP_CODE::JEQ:
+            case FJP::OP_CODE::JNE:
+            case FJP::OP_CODE::JLT:
+            case FJP::OP_CODE::JLE:
+            case FJP::OP_CODE::JGT:
+            case FJP::OP_CODE::JGE:
+            case FJP::OP_CODE::JEQI:
+            case FJP::OP_CODE::JNEI:
+            case FJP::OP_CODE::JLTI:
+            case FJP::OP_CODE::JLEI:
+            case FJP::OP_CODE::JGTI:
+            case FJP::OP_CODE::JGEI:
+                if (code[i].m >= address) {
+                    code[i].m += count;
+                }
+                break;
+            default:
+                break;
+        }
+
+        // The targets of the JTB instruction are kept in its jump table.
+        if (code[i].op == FJP::OP_CODE::JTB) {
+            FJP::JumpTable &table = jumpTables[code[i].m];
+            for (auto &target : table.targets) {
+                if (target >= address) {
+                    target += count;
+                }
+            }
+            if (table.defaultTarget >= address) {
+                table.defaultTarget += count;
+            }
+        }
+    }
+}
+
+void FJP::GeneratedCode::insertInstructions(int address, const std::vector<FJP::Instruction> &instructions) {
+    int count = static_cast<int>(instructions.size());
+
+    // Move the jumps (and calls) of the instructions that are about to be moved along.
+    moveTargets(address, address, count);
+    code.insert(code.begin() + address, instructions.begin(), instructions.end());
+
+    // The inserted instructions belong to the line of the instruction that used to be at the address.
+    auto entry = std::upper_bound(lineTable.begin(), lineTable.end(), address, [](int addr, const LineTableEntry &item) {
+        return addr < item.address;
+    });
+    for (; entry != lineTable.end(); ++entry) {
+        entry->address += count;
+    }
+    moveArraySizes(address, count);
+    moveFunctions(address, count);
+}
+
+void FJP::GeneratedCode::removeInstruction(int address) {
+    code.erase(code.begin() + address);
+
+    // Move the jumps (and calls) of the instructions that have been moved back.
+    moveTargets(address, address + 1, -1);
+
+    // If the range of the removed instruction becomes empty, the following one takes its place.
+    auto entry = std::upper_bound(lineTable.begin(), lineTable.end(), address, [](int addr, const LineTableEntry &item) {
+        return addr < item.address;
+    });
+    for (auto moved = entry; moved != lineTable.end(); ++moved) {
+        moved->address--;
+    }
+    if (entry != lineTable.begin() && entry != lineTable.end() && std::prev(entry)->address == entry->address) {
+        lineTable.erase(std::prev(entry));
+    }
+    moveArraySizes(address, -1);
+    moveFunctions(address, -1);
+}
+
+void FJP::GeneratedCode::setLineNumber(int lineNumber) {
+    int address = getSize();
+
+    // If no instruction has been added since the last entry was created,
+    // the entry would describe an empty range, so we just overwrite it.
+    if (!lineTable.empty() && lineTable.back().address == address) {
+        lineTable.back().lineNumber = lineNumber;
+
+        // Merge the entry with the previous one if they now refer to the same line.
+        if (lineTable.size() > 1 && lineTable[lineTable.size() - 2].lineNumber == lineNumber) {
+            lineTable.pop_back();
+        }
+        return;
+    }
+
+    // Start a new range only if the line has actually changed.
+    if (lineTable.empty() || lineTable.back().lineNumber != lineNumber) {
+        lineTable.push_back({address, lineNumber});
+    }
+}
+
+int FJP::GeneratedCode::getLineNumber(int address) const {
+    // Find the first range starting after the address. The
+    // instruction then belongs to the range right before it.
+    auto entry = std::upper_bound(lineTable.begin(), lineTable.end(), address, [](int addr, const LineTableEntry &item) {
+        return addr < item.address;
+    });
+    if (entry == lineTable.begin()) {
+        return -1;
+    }
+    return std::prev(entry)->lineNumber;
+}
+
+const std::vector<FJP::LineTableEntry> &FJP::GeneratedCode::getLineTable() const {
+    return lineTable;
+}
+
+void FJP::GeneratedCode::setLineTable(const std::vector<FJP::LineTableEntry> &table) {
+    lineTable = table;
+}
+
+void FJP::GeneratedCode::addFunction(int address, int endAddress, const std::string &name) {
+    functions[address] = {name, endAddress};
+}
+
+std::string FJP::GeneratedCode::getFunctionName(int address) const {
+    auto function = functions.find(address);
+    if (function != functions.end()) {
+        return function->second.name;
+    }
+    // The main block of the program is not a function declared by the user.
+    return address == 0 ? "main" : "unknown";
+}
+
+int FJP::GeneratedCode::findFunction(int address) const {
+    // Go through the functions starting at or before the address backwards.
+    // The first one whose range contains the address is the innermost one.
+    auto function = functions.upper_bound(address);
+    while (function != functions.begin()) {
+        --function;
+        if (address < function->second.endAddress) {
+            return function->first;
+        }
+    }
+    return 0;
+}
+
+const std::map<int, FJP::FunctionEntry> &FJP::GeneratedCode::getFunctions() const {
+    return functions;
+}
+
+int FJP::GeneratedCode::allocateData(int size) {
+    int address = dataSize;
+    dataSize += size;
+    return address;
+}
+
+int FJP::GeneratedCode::getDataSize() const {
+    return dataSize;
+}
+
+int FJP::GeneratedCode::addConstants(int address, const std::vector<int> &values) {
+    int poolAddress = static_cast<int>(constantPool.size());
+    constantPool.push_back(static_cast<int>(values.size()));
+    constantPool.push_back(address);
+    constantPool.insert(constantPool.end(), values.begin(), values.end());
+    return poolAddress;
+}
+
+const std::vector<int> &FJP::GeneratedCode::getConstantPool() const {
+    return constantPool;
+}
+
+int FJP::GeneratedCode::addVectorLoop(const FJP::VectorLoop &loop) {
+    vectorLoops.push_back(loop);
+    return static_cast<int>(vectorLoops.size()) - 1;
+}
+
+const FJP::VectorLoop &FJP::GeneratedCode::getVectorLoop(int index) const {
+    return vectorLoops[index];
+}
+
+const std::vector<FJP::VectorLoop> &FJP::GeneratedCode::getVectorLoops() const {
+    return vectorLoops;
+}
+
+int FJP::GeneratedCode::addJumpTable(const FJP::JumpTable &table) {
+    jumpTables.push_back(table);
+    return static_cast<int>(jumpTables.size()) - 1;
+}
+
+const FJP::JumpTable &FJP::GeneratedCode::getJumpTable(int index) const {
+    return jumpTables[index];
+}
+
+const std::vector<FJP::JumpTable> &FJP::GeneratedCode::getJumpTables() const {
+    return jumpTables;
+}
+
+int FJP::GeneratedCode::addVariableUpdate(const FJP::VariableUpdate &update) {
+    variableUpdates.push_back(update);
+    return static_cast<int>(variableUpdates.size()) - 1;
+}
+
+const FJP::VariableUpdate &FJP::GeneratedCode::getVariableUpdate(int index) const {
+    return variableUpdates[index];
+}
+
+const std::vector<FJP::VariableUpdate> &FJP::GeneratedCode::getVariableUpdates() const {
+    return variableUpdates;
+}
+
+void FJP::GeneratedCode::setArraySize(int address, int size) {
+    arraySizes[address] = size;
+}
+
+int FJP::GeneratedCode::getArraySize(int address) const {
+    auto size = arraySizes.find(address);
+    if (size == arraySizes.end()) {
+        return -1;
+    }
+    return size->second;
+}
+
+const std::map<int, int> &FJP::GeneratedCode::getArraySizes() const {
+    return arraySizes;
+}
+
+void FJP::GeneratedCode::moveArraySizes(int address, int count) {
+    // The sizes of the removed instructions (if any) are dropped.
+    int firstMoved = address + std::max(-count, 0);
+    auto first = arraySizes.lower_bound(address);
+    auto moved = arraySizes.erase(first, arraySizes.lower_bound(firstMoved));
+
+    // Only the sizes after the address are moved. They are taken out of the map first,
+    // so their new addresses do not collide with the ones that have not been moved yet.
+    std::vector<std::pair<int, int>> sizes(moved, arraySizes.end());
+    arraySizes.erase(moved, arraySizes.end());
+    for (const auto &size : sizes) {
+        arraySizes.emplace_hint(arraySizes.end(), size.first + count, size.second);
+    }
+}
+
+void FJP::GeneratedCode::moveFunctions(int address, int count) {
+    // The functions are recorded once they have been generated, so the
+    // ones placed before the address end before it and stay where they are.
+    // A function starting at a removed instruction starts at the following one.
+    auto moved = count > 0 ? functions.lower_bound(address) : functions.upper_bound(address);
+    std::vector<std::pair<int, FunctionEntry>> entries(moved, functions.end());
+    functions.erase(moved, functions.end());
+    for (auto &entry : entries) {
+        entry.second.endAddress += count;
+        functions.emplace_hint(functions.end(), entry.first + count, std::move(entry.second));
+    }
+}
+
+void FJP::GeneratedCode::setStackBound(const FJP::StackBound &bound) {
+    stackBound = bound;
+}
+
+const FJP::StackBound &FJP::GeneratedCode::getStackBound() const {
+    return stackBound;
+}
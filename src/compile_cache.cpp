@@ -0,0 +1,145 @@
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+#include <random>
+#include <algorithm>
+
+#include <compile_cache.h>
+
+FJP::CompileCache::CompileCache() : directory(defaultDirectory()) {
+}
+
+std::filesystem::path FJP::CompileCache::defaultDirectory() {
+    if (const char *path = std::getenv("FJP_CACHE_DIR")) {
+        return path;
+    }
+    if (const char *path = std::getenv("XDG_CACHE_HOME")) {
+        return std::filesystem::path(path) / "fjp";
+    }
+    if (const char *path = std::getenv("HOME")) {
+        return std::filesystem::path(path) / ".cache" / "fjp";
+    }
+    return {};
+}
+
+std::string FJP::CompileCache::compilerIdentity() {
+    std::error_code error;
+    std::filesystem::path executable = std::filesystem::read_symlink("/proc/self/exe", error);
+    if (!error) {
+        uintmax_t size = std::filesystem::file_size(executable, error);
+        auto time = std::filesystem::last_write_time(executable, error);
+        if (!error) {
+            return executable.string() + ":" + std::to_string(size) + ":" + std::to_string(time.time_since_epoch().count());
+        }
+    }
+
+    // The executable cannot be found, so the time this file has been compiled at is used instead.
+    return __DATE__ " " __TIME__;
+}
+
+std::filesystem::path FJP::CompileCache::entryPath() const {
+    return directory / (key + EXTENSION);
+}
+
+bool FJP::CompileCache::load(const std::string &sourceFile, FJP::BytecodeFile &file, FJP::GeneratedCode &code) {
+    key.clear();
+    if (directory.empty()) {
+        return false;
+    }
+
+    // The key is the hash of the compiler and the source code (no option affects the generated code).
+    std::ifstream source(sourceFile, std::ios::binary);
+    if (!source.is_open()) {
+        return false;
+    }
+    std::ostringstream content;
+    content << compilerIdentity() << '\0' << source.rdbuf();
+    const std::string data = content.str();
+    std::ostringstream hash;
+    hash << std::hex << std::setw(16) << std::setfill('0')
+         << FJP::BytecodeFile::checksum(reinterpret_cast<const unsigned char *>(data.data()), data.size());
+    key = hash.str();
+
+    std::filesystem::path path = entryPath();
+    if (!file.tryLoad(path.string(), code)) {
+        return false;
+    }
+
+    // Mark the entry as the most recently used one.
+    std::error_code error;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), error);
+    return true;
+}
+
+void FJP::CompileCache::store(const FJP::GeneratedCode &code) {
+    if (directory.empty() || key.empty()) {
+        return;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        return;
+    }
+
+    // Other processes may be storing the same entry at the same time, so each of them writes its own
+    // temporary file, and the last one to rename it wins (the entries are the same anyway).
+    std::random_device random;
+    std::filesystem::path temporary = directory / (key + ".tmp." + std::to_string(random()));
+    if (!FJP::BytecodeFile::write(code, temporary.string())) {
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+    std::filesystem::rename(temporary, entryPath(), error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        return;
+    }
+    evict();
+}
+
+void FJP::CompileCache::evict() {
+    struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type time;
+        uintmax_t size;
+    };
+    std::vector<Entry> entries;
+    uintmax_t totalSize = 0;
+    auto now = std::filesystem::file_time_type::clock::now();
+
+    // Other processes may be removing the same files, so all errors are ignored.
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+        std::error_code entryError;
+        const std::filesystem::path &path = it->path();
+        auto time = std::filesystem::last_write_time(path, entryError);
+        if (entryError) {
+            continue;
+        }
+        if (path.extension() == EXTENSION) {
+            uintmax_t size = std::filesystem::file_size(path, entryError);
+            if (!entryError) {
+                entries.push_back({path, time, size});
+                totalSize += size;
+            }
+        } else if (path.filename().string().find(".tmp.") != std::string::npos &&
+                   now - time > std::chrono::seconds(ABANDONED_AGE)) {
+            std::filesystem::remove(path, entryError);
+        }
+    }
+
+    // Remove the least recently used entries first.
+    std::sort(entries.begin(), entries.end(), [](const Entry &x, const Entry &y) {
+        return x.time < y.time;
+    });
+    for (const auto &entry : entries) {
+        if (totalSize <= MAX_SIZE) {
+            break;
+        }
+        std::error_code entryError;
+        std::filesystem::remove(entry.path, entryError);
+        totalSize -= entry.size;
+    }
+}
@@ -24,13 +24,140 @@ std::string FJP::op_code_to_str(OP_CODE op) {
             return "LDA";
         case STA:
             return "STA";
+        case LDD:
+            return "LDD";
+        case STD:
+            return "STD";
+        case CPY:
+            return "CPY";
+        case CPD:
+            return "CPD";
+        case VADD:
+            return "VADD";
+        case VMUL:
+            return "VMUL";
+        case VSUM:
+            return "VSUM";
+        case VMIN:
+            return "VMIN";
+        case VMAX:
+            return "VMAX";
+        case VCMP:
+            return "VCMP";
+        case VFILL:
+            return "VFILL";
+        case JTB:
+            return "JTB";
+        case JEQ:
+            return "JEQ";
+        case JNE:
+            return "JNE";
+        case JLT:
+            return "JLT";
+        case JLE:
+            return "JLE";
+        case JGT:
+            return "JGT";
+        case JGE:
+            return "JGE";
+        case JEQI:
+            return "JEQI";
+        case JNEI:
+            return "JNEI";
+        case JLTI:
+            return "JLTI";
+        case JLEI:
+            return "JLEI";
+        case JGTI:
+            return "JGTI";
+        case JGEI:
+            return "JGEI";
+        case ADDI:
+            return "ADDI";
+        case SUBI:
+            return "SUBI";
+        case MULI:
+            return "MULI";
+        case CMPI:
+            return "CMPI";
+        case ADDV:
+            return "ADDV";
+        case SUBV:
+            return "SUBV";
+        case MULV:
+            return "MULV";
+        case ADDVI:
+            return "ADDVI";
+        case SUBVI:
+            return "SUBVI";
+        case MULVI:
+            return "MULVI";
+        case LDX:
+            return "LDX";
+        case STX:
+            return "STX";
     }
     return "unknown";
 }
 
+FJP::OP_CODE FJP::branch_on(int comparison, bool immediate) {
+    // The branches are ordered the same way as the comparisons.
+    return static_cast<OP_CODE>((immediate ? JEQI : JEQ) + (comparison - OPR_EQ));
+}
+
+int FJP::branch_comparison(OP_CODE op) {
+    if (op >= JEQ && op <= JGE) {
+        return OPR_EQ + (op - JEQ);
+    }
+    if (op >= JEQI && op <= JGEI) {
+        return OPR_EQ + (op - JEQI);
+    }
+    return -1;
+}
+
+bool FJP::is_immediate_branch(OP_CODE op) {
+    return op >= JEQI && op <= JGEI;
+}
+
+int FJP::negate_comparison(int comparison) {
+    switch (comparison) {
+        case OPR_EQ:
+            return OPR_NEQ;
+        case OPR_NEQ:
+            return OPR_EQ;
+        case OPR_LESS:
+            return OPR_GRT_EQ;
+        case OPR_LESS_EQ:
+            return OPR_GRT;
+        case OPR_GRT:
+            return OPR_LESS_EQ;
+        case OPR_GRT_EQ:
+            return OPR_LESS;
+    }
+    return comparison;
+}
+
 std::ostream &FJP::operator<<(std::ostream &out, const Instruction &instruction) {
     out << op_code_to_str(instruction.op) << " "
         << instruction.l << " "
         << instruction.m;
     return out;
 }
+
+bool FJP::is_op_code(uint32_t value) {
+    return value >= FJP::OP_CODE::LIT && value <= FJP::OP_CODE::STX;
+}
+
+bool FJP::fits_packed(const Instruction &instruction) {
+    constexpr int limit = 1 << (PACKED_L_BITS - 1);
+    return instruction.l >= -limit && instruction.l < limit;
+}
+
+FJP::PackedInstruction FJP::pack_instruction(const Instruction &instruction) {
+    uint32_t low = static_cast<uint32_t>(instruction.op) | (static_cast<uint32_t>(instruction.l) << (32 - PACKED_L_BITS));
+    return (static_cast<uint64_t>(static_cast<uint32_t>(instruction.m)) << 32) | low;
+}
+
+FJP::PackedInstruction FJP::pack_wide_instruction(int index) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(index)) << 32) | PACKED_WIDE;
+}
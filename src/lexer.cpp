@@ -1,19 +1,12 @@
+#include <cstdlib>
 #include <algorithm>
-#include <fstream>
-#include <sstream>
+#include <string_view>
 
 #include <lexer.h>
+#include <probes.h>
 #include <errors.h>
 #include <logger.h>
 
-// Helper function used to validate whether
-// a character could be a part of an identifier or not.
-static int is_part_of_identifier(int c);
-
-// Helper function used to validate whether
-// a character could be a start of an identifier or not.
-static int is_start_of_identifier(int c);
-
 FJP::Lexer *FJP::Lexer::instance = nullptr;
 
 FJP::Lexer* FJP::Lexer::getInstance() {
@@ -23,273 +16,388 @@ FJP::Lexer* FJP::Lexer::getInstance() {
     return instance;
 }
 
-FJP::Lexer::Lexer() : currentCharIndex(0), currentLineNumber(0) {
-    // Sort all the program keywords by their length. This is done
-    // because we want to parse longer keywords first. For example,
-    // we don't want to parse ':=' as ':' and '=' but we want to
-    // parse it as ':='.
-    sort(keywords.begin(), keywords.end(), [&](const auto &keyword_A, const auto &keyword_B) {
-        return keyword_A.first.length() > keyword_B.first.length();
-    });
-
-    // Create a list of all alphabetic keywords such as 'goto', 'for', etc.
-    for (const auto &keyword : keywords) {
-        if (std::all_of(std::begin(keyword.first), std::end(keyword.first), [](char c) { return std::isalpha(c); })) {
-            alphabetic_keywords.insert(keyword.first);
-        }
-    }
+FJP::Lexer::Lexer() : chunkIndex(0), chunkTokenIndex(0), chunkLineOffset(0), pipelined(false), producerFailed(false),
+                      tokenCount(0), tokenPosition(0) {
 }
 
-void FJP::Lexer::init(std::string filename, bool debug) {
+void FJP::Lexer::init(std::string filename, bool debug, const std::string &tokenDumpFile) {
+    FJP_PROBE0(lexer_init_start);
+
     // Initialize variables.
-    currentLineNumber = 0;
-    currentCharIndex = 0;
-    tokens.clear();
+    stopPipeline();
+    releaseChunks();
+    tokenCount = 0;
+    tokenPosition = 0;
+    identifierIds.clear();
 
     // Terminate the application if the input file cannot be open.
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+    // The file is scanned right from the memory it is mapped into.
+    if (!sourceFile.open(filename)) {
         FJP::exitProgramWithError(FJP::IOErrors::ERROR_00, ERR_CODE);
     }
+    fileContent = sourceFile.getContent();
+    scanner.init(fileContent);
+
+    // If the debug is on, create the output file (tokens.json), and the binary dump
+    // if it has been requested. The tokens are written into them as they are being parsed.
+    closeOutputFile();
+    if (debug && !outputJSONFile.open(OUTPUT_FILE, FJP::TokenWriter::JSON, fileContent)) {
+        FJP::exitProgramWithError(FJP::IOErrors::ERROR_01, ERR_CODE);
+    }
+    if (!tokenDumpFile.empty() && !outputDumpFile.open(tokenDumpFile, FJP::TokenWriter::BINARY, fileContent)) {
+        FJP::exitProgramWithError(FJP::IOErrors::ERROR_01, ERR_CODE);
+    }
+    static bool registered = false;
+    if (!registered && (outputJSONFile.isOpen() || outputDumpFile.isOpen())) {
+        std::atexit(closeOutputFileAtExit);
+        registered = true;
+    }
 
-    // Read the content of the input file (source code).
-    fileContent = std::string((std::istreambuf_iterator<char>(file)),(std::istreambuf_iterator<char>()));
+    // A large file is split into chunks lexed on several threads at once
+    // (unless it is too large for the compact form of the tokens).
+    // Otherwise, the lexing overlaps with the parsing if there is more than one thread.
+    size_t count = std::min<size_t>(threadCount(), fileContent.size() / MIN_CHUNK_SIZE);
+    if (count > 1 && fileContent.size() < MAX_SPLIT_SIZE) {
+        splitIntoChunks(count);
+    } else if (threadCount() > 1 && static_cast<long>(fileContent.size()) >= MIN_PIPELINE_SIZE) {
+        startPipeline();
+    }
 
-    // Parse the input file and sets the token iterator
-    // to the first token, so it can be consumed by the parser.
-    processAllTokens(debug);
-    currentTokenIt = tokens.begin();
+    FJP_PROBE1(lexer_init_end, fileContent.size());
 }
 
 FJP::Token FJP::Lexer::getNextToken() {
-    // If the parse requests another token while it's
-    // already an end of file, it's an error
-    if (currentTokenIt == tokens.end()) {
-        FJP::exitProgramWithError(FJP::CompilationErrors::ERROR_00, ERR_CODE);
+    // Parse another token if the parser has consumed all of them.
+    if (tokenPosition == tokenCount) {
+        // If the parse requests another token while it's
+        // already an end of file, it's an error
+        if (isEndOfFile()) {
+            FJP::exitProgramWithError(FJP::CompilationErrors::ERROR_00, ERR_CODE);
+        }
+        produceToken();
     }
 
     // Return the current token to the parser move on to the next token.
-    Token token = *currentTokenIt;
-    ++currentTokenIt;
-    return token;
+    return tokenRing[tokenPosition++ % HISTORY_SIZE];
 }
 
 void FJP::Lexer::returnToPreviousToken() {
-    // We're already at the very for token.
-    if (currentTokenIt == tokens.begin()) {
+    // We're already at the very for token (or the previous one is no longer kept in the ring).
+    if (tokenPosition == 0 || tokenCount - tokenPosition >= HISTORY_SIZE) {
         FJP::exitProgramWithError(FJP::CompilationErrors::ERROR_05, ERR_CODE);
     }
 
     // Move back one step within the stream of tokens.
-    --currentTokenIt;
+    --tokenPosition;
 }
 
-void FJP::Lexer::processAllTokens(bool debug) {
-    Token token;
-
-    std::stringstream ss;
-    std::ofstream outputJSONFile;
+void FJP::Lexer::finish() {
+    // Parse the rest of the input file (the tokens are not needed anymore).
+    while (!isEndOfFile()) {
+        produceToken();
+    }
+    stopPipeline();
+    closeOutputFile();
+}
 
-    // If the debug is on, create the output file (tokens.json)
-    if (debug) {
-        outputJSONFile = std::ofstream(OUTPUT_FILE);
+void FJP::Lexer::produceToken() {
+    Token &token = tokenRing[tokenCount % HISTORY_SIZE];
+    if (pipelined) {
+        // The end of file has been ruled out, so the queue is only closed early due to an error.
+        if (!tokenQueue.pop(token)) {
+            reportError(scanner.getError(), 0);
+        }
+    } else if (chunks.empty()) {
+        if (!scanner.parseNextToken(token)) {
+            reportError(scanner.getError(), 0);
+        }
+    } else {
+        // Take the next token of the current chunk, and adjust it to the whole file.
+        Chunk &chunk = *chunks[chunkIndex];
+        if (chunkTokenIndex == chunk.tokens.size()) {
+            reportError(chunk.scanner.getError(), chunkLineOffset);
+        }
+        const ChunkToken &chunkToken = chunk.tokens[chunkTokenIndex++];
+        const auto type = static_cast<FJP::TokenType>(chunkToken.tokenType);
+        token = {
+                type,                                                       // type of the token
+                chunk.text.substr(chunkToken.offset, chunkToken.length),    // value of the token
+                chunkToken.lineNumber + chunkLineOffset,                    // number of the line the token is on
+                type == NUMBER ? chunkToken.value : 0,                      // value of a number
+                type == IDENTIFIER ? chunkIdentifierIds[chunkToken.value] : -1 // ID of the identifier
+        };
 
-        // If there's an error while opening the output file, terminate the application.
-        if (!outputJSONFile.is_open()) {
-            FJP::exitProgramWithError(FJP::IOErrors::ERROR_01, ERR_CODE);
+        // Move on to the next chunk once all tokens of this one have been taken (unless there's an error).
+        if (chunkTokenIndex == chunk.tokens.size() && !chunk.failed) {
+            enterChunk(chunkIndex + 1);
         }
     }
+    tokenCount++;
 
-    // Parse the entire input file token by token.
-    ss << "[";
-    if (fileContent.size() > 0) {
-        while (!isEndOfFile()) {
-            token = parseNextToken();
-            tokens.push_back(token);
-            ss << token << ",\n";
-        }
-        ss.seekp(-2, std::ios_base::end);
+    // If the debug flag is on, store the token into the output file (JSON format),
+    // and into the binary dump if it has been requested.
+    if (outputJSONFile.isOpen()) {
+        outputJSONFile.write(token);
+    }
+    if (outputDumpFile.isOpen()) {
+        outputDumpFile.write(token);
     }
-    ss << "]";
+}
+
+void FJP::Lexer::closeOutputFile() {
+    outputJSONFile.close();
+    outputDumpFile.close();
+}
 
-    // If the debug flag is on, store all tokens into the output file.
-    // The format of the output file is JSON.
-    if (debug) {
-        outputJSONFile << ss.str();
-        outputJSONFile.close();
+void FJP::Lexer::closeOutputFileAtExit() {
+    if (instance != nullptr) {
+        instance->closeOutputFile();
     }
 }
 
-bool FJP::Lexer::isEndOfFile() const {
-    return currentCharIndex >= static_cast<long>(fileContent.length());
+bool FJP::Lexer::isEndOfFile() {
+    if (pipelined) {
+        // The error flag is written before the queue is closed.
+        return !tokenQueue.waitForToken() && !producerFailed;
+    }
+    if (chunks.empty()) {
+        return scanner.isEndOfFile();
+    }
+    return chunkIndex == chunks.size();
 }
 
-FJP::Token FJP::Lexer::parseNextToken() {
-    std::string tokenValue;
+void FJP::Lexer::reportError(const FJP::LexicalError &error, int lineOffset) {
+    // Print out the text belonging to the error (e.g. an unknown character) first.
+    std::cout << error.text;
+    if (error.methodName == nullptr) {
+        FJP::exitProgramWithError(error.message, ERR_CODE);
+    }
+    FJP::exitProgramWithError(error.methodName, error.message, ERR_CODE, error.lineNumber + lineOffset);
+}
 
-    // Skip all comments if there are any.
-    skipComments();
+unsigned FJP::Lexer::threadCount() {
+    if (const char *value = std::getenv(THREADS_VARIABLE)) {
+        return static_cast<unsigned>(std::max(1, std::atoi(value)));
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
 
-    // Go through all the keywords in descending order (by their length)
-    for (auto &keyword : keywords) {
-        // Check if the current keyword would fit into the file (it doesn't exceed the file length)
-        if (currentCharIndex + keyword.first.length() > fileContent.length())
+std::vector<long> FJP::Lexer::findChunkBoundaries(size_t count) const {
+    const char *text = fileContent.data();
+    const long length = static_cast<long>(fileContent.length());
+    const FJP::ScanKernels *scanKernels = FJP::ScanKernels::getInstance();
+
+    // Find all comments (the outermost ones) by jumping from one delimiter to another.
+    // Outside a comment, "*/" is made up of two operators, so only "/*" counts there. The lexer
+    // skips just one comment between two tokens, so a "/*" taken for the start of a comment here
+    // may actually be parsed as tokens (and a comment may start within it). A chunk is lexed exactly
+    // the way the whole file would be, though, so such a comment shows up as an unclosed one at the
+    // end of the chunk, and the boundary is dropped then (see enterChunk).
+    std::vector<std::pair<long, long>> comments;
+    int lineNumber = 0; // not needed here
+    int depth = 0;
+    long index = 0;
+    while (true) {
+        long delimiter = scanKernels->findCommentDelimiter(text, index, length, lineNumber);
+        if (delimiter < 0) {
+            break;
+        }
+        bool start = text[delimiter] == '/';
+        if (depth == 0 && !start) {
+            index = delimiter + 1;
             continue;
+        }
+        if (depth == 0) {
+            comments.push_back({delimiter, length});
+        }
+        depth += start ? 1 : -1;
+        index = delimiter + 2;
+        if (depth == 0) {
+            comments.back().second = index;
+        }
+    }
+
+    // Look for a token preceded by a white character right after each of the evenly spaced positions.
+    // Every token is then parsed by exactly one chunk, and the white characters following the last
+    // token of a chunk all belong to the chunk, so they are counted in the line number of the token.
+    auto isWhite = [](char c) {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    };
+    std::vector<long> boundaries;
+    auto comment = comments.begin();
+    for (size_t i = 1; i < count; i++) {
+        long position = std::max(static_cast<long>(length / count * i), boundaries.empty() ? 1 : boundaries.back() + 1);
+        while (position < length) {
+            while (comment != comments.end() && comment->second <= position) {
+                ++comment;
+            }
+            if (comment != comments.end() && comment->first <= position) {
+                position = comment->second;
+            } else if (isWhite(text[position - 1]) && !isWhite(text[position])) {
+                break;
+            } else {
+                position++;
+            }
+        }
+        if (position >= length) {
+            break;
+        }
+        boundaries.push_back(position);
+    }
+    return boundaries;
+}
 
-        // Check if it's indeed the keyword.
-        tokenValue = fileContent.substr(currentCharIndex, keyword.first.length());
-        if (tokenValue == keyword.first) {
+void FJP::Lexer::splitIntoChunks(size_t count) {
+    std::vector<long> boundaries = findChunkBoundaries(count);
+    boundaries.push_back(static_cast<long>(fileContent.length()));
+
+    long start = 0;
+    for (long end : boundaries) {
+        auto chunk = std::make_unique<Chunk>();
+        chunk->text = fileContent.substr(start, end - start);
+        chunk->last = end == static_cast<long>(fileContent.length());
+        chunk->failed = false;
+        chunk->unclosedComment = false;
+        chunks.push_back(std::move(chunk));
+        start = end;
+    }
+    for (auto &chunk : chunks) {
+        chunk->worker = std::thread(lexChunk, chunk.get());
+    }
+    chunkLineOffset = 0;
+    enterChunk(0);
+}
 
-            // Move on by the keyword length in the input file.
-            currentCharIndex += static_cast<long>(tokenValue.length());
+void FJP::Lexer::lexChunk(Chunk *chunk) {
+    // Reserve room for a token every two characters (the vector grows if there are more of them).
+    chunk->tokens.reserve(chunk->text.size() / 2);
+    chunk->scanner.init(chunk->text);
 
-            // Check if the keyword is not just a prefix of a custom
-            // identifier such as a variable or an array.
-            if (alphabetic_keywords.count(tokenValue)) {
-                if (currentCharIndex < static_cast<long>(fileContent.length()) && is_part_of_identifier(fileContent[currentCharIndex])) {
-                    currentCharIndex -= static_cast<long>(tokenValue.length());
-                    continue;
-                }
+    Token token;
+    if (chunk->last) {
+        // The last chunk is parsed exactly the way the whole file would be.
+        while (!chunk->scanner.isEndOfFile()) {
+            if (!chunk->scanner.parseNextToken(token)) {
+                chunk->failed = true;
+                return;
             }
-
-            // If a keyword has been found, skip all the white spaces
-            // and return the token.
-            skipWhiteCharacters();
-            return {
-                    keyword.second,   // type of the token
-                    tokenValue,       // value of the token
-                    currentLineNumber // number of the line the token is on
-            };
+            addChunkToken(chunk, token);
         }
+        return;
     }
 
-    // If it's not a keyword, check if it's a number
-    if (isdigit(fileContent[currentCharIndex])) {
-        // If it is a digit, get all the following digits as well
-        // until you find a non-digit character.
-        std::string number = getValue(&isdigit);
-
-        // Check if the digit is not too long (it fits into the datatype).
-        if (atoi(number.c_str()) < 0) {
-            FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_02, ERR_CODE, currentLineNumber);
+    // Any other chunk ends with a white character, so it is done once there's nothing but a comment left.
+    while (true) {
+        if (!chunk->scanner.skipComments()) {
+            chunk->unclosedComment = true;
+            return;
+        }
+        if (chunk->scanner.isEndOfFile()) {
+            return;
+        }
+        if (!chunk->scanner.parseNextToken(token, true)) {
+            chunk->failed = true;
+            return;
         }
+        addChunkToken(chunk, token);
+    }
+}
 
-        // Skip all the white spaces and return the token.
-        skipWhiteCharacters();
-        return {
-                NUMBER,           // type of the token
-                number,           // value of the token
-                currentLineNumber // number of the line the token is on
+void FJP::Lexer::addChunkToken(Chunk *chunk, const FJP::Token &token) {
+    ChunkToken chunkToken{};
+    chunkToken.offset = static_cast<uint32_t>(token.value.data() - chunk->text.data());
+    chunkToken.length = static_cast<uint32_t>(token.value.length());
+    chunkToken.tokenType = static_cast<uint32_t>(token.tokenType);
+    chunkToken.lineNumber = token.lineNumber;
+    chunkToken.value = token.tokenType == IDENTIFIER ? token.identifierId : token.number;
+    chunk->tokens.push_back(chunkToken);
+}
 
-        };
+void FJP::Lexer::enterChunk(size_t index) {
+    // The previous chunk is not needed anymore (the tokens of the ring point into the file itself).
+    if (index > 0) {
+        Chunk &previous = *chunks[index - 1];
+        chunkLineOffset += previous.scanner.getLineNumber();
+        previous.tokens = {};
+    }
+    chunkIndex = index;
+    chunkTokenIndex = 0;
+    if (index == chunks.size()) {
+        return;
     }
 
-    // It's not a keyword nor a number, it has to be an identifier.
-    if (is_start_of_identifier(fileContent[currentCharIndex])) {
-        // Consume all characters that belong to the identifier.
-        std::string identifier = getValue(&is_part_of_identifier);
+    Chunk &chunk = *chunks[index];
+    chunk.worker.join();
 
-        // Check if the identifier doesn't exceed the maximum length.
-        if (identifier.length() > MAX_IDENTIFIER_LEN) {
-            FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_03, ERR_CODE, currentLineNumber);
+    // The chunk has not been split off at the start of a token after all (see findChunkBoundaries),
+    // so the rest of the file is lexed as a whole instead.
+    if (chunk.unclosedComment) {
+        for (size_t i = index + 1; i < chunks.size(); i++) {
+            chunks[i]->worker.join();
         }
-
-        // Skip all the white spaces and return the token.
-        skipWhiteCharacters();
-        return {
-                IDENTIFIER,       // type of the token
-                identifier,       // value of the token
-                currentLineNumber // number of the line the token is on
-        };
+        chunks.resize(index + 1);
+        chunk.text = fileContent.substr(chunk.text.data() - fileContent.data());
+        chunk.last = true;
+        chunk.unclosedComment = false;
+        chunk.tokens.clear();
+        lexChunk(&chunk);
     }
 
-    std::cout << fileContent[currentCharIndex];
-
-    // If the program gets to this point, it's an unknown character.
-    FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_04, ERR_CODE, currentLineNumber);
-
-    // Just so the compiler doesn't complain about a missing return value.
-    return {};
-}
-
-std::string FJP::Lexer::getValue(int (validation_fce)(int)) {
-    std::string value;
+    // The identifiers of the chunk get their IDs in the order they first occur in, as if
+    // the whole file was parsed at once.
+    const auto &ids = chunk.scanner.getIdentifierIds();
+    std::vector<std::string_view> names(ids.size());
+    for (const auto &[name, id] : ids) {
+        names[id] = name;
+    }
+    chunkIdentifierIds.resize(names.size());
+    for (size_t id = 0; id < names.size(); id++) {
+        chunkIdentifierIds[id] = identifierIds.try_emplace(names[id], static_cast<int>(identifierIds.size())).first->second;
+    }
 
-    // Keep consuming the characters as long as the validation
-    // function is satisfied.
-    while (!isEndOfFile() && validation_fce(fileContent[currentCharIndex])) {
-        value += fileContent[currentCharIndex];
-        currentCharIndex++;
+    // Skip a chunk with no tokens at all (just comments and white characters).
+    if (chunk.tokens.empty() && !chunk.failed) {
+        enterChunk(index + 1);
     }
-    return value;
 }
 
-static int is_part_of_identifier(int c) {
-    // The "body" of an identifier (not the first character)
-    // can consist of a digit, alphabetic character or an underscore.
-    return isdigit(c) || isalpha(c) || c == '_';
+void FJP::Lexer::releaseChunks() {
+    for (auto &chunk : chunks) {
+        if (chunk->worker.joinable()) {
+            chunk->worker.join();
+        }
+    }
+    chunks.clear();
+    chunkIndex = 0;
+    chunkTokenIndex = 0;
+    chunkLineOffset = 0;
 }
 
-static int is_start_of_identifier(int c) {
-    // An identifier can only start with an alphabetic character or an underscore.
-    return isalpha(c) || c == '_';
+void FJP::Lexer::startPipeline() {
+    tokenQueue.reset();
+    producerFailed = false;
+    pipelined = true;
+    producer = std::thread(&Lexer::lexIntoQueue, this);
 }
 
-void FJP::Lexer::skipWhiteCharacters() {
-    // Skip all white spaces.
-    while (isspace(fileContent[currentCharIndex])) {
-        // Keep counting the lines as you skip the white spaces.
-        if (fileContent[currentCharIndex] == '\n') {
-            currentLineNumber++;
+void FJP::Lexer::lexIntoQueue() {
+    Token token;
+    while (!scanner.isEndOfFile()) {
+        if (!scanner.parseNextToken(token)) {
+            producerFailed = true;
+            break;
+        }
+        if (!tokenQueue.push(token)) {
+            break;
         }
-        currentCharIndex++;
     }
+    tokenQueue.close();
 }
 
-void FJP::Lexer::skipComments() {
-    // First off, skip all possible white characters.
-    skipWhiteCharacters();
-
-    std::string commentStart(COMMENT_START);
-    std::string commentEnd(COMMENT_END);
-
-    // Make sure we're not at the end of the file (that there's still enough room for a comment).
-    if (currentCharIndex + commentStart.length() >= fileContent.length())
-        return;
-
-    // Check if the next two characters make up the start sequence of a comment.
-    std::string characterPair = fileContent.substr(currentCharIndex, commentStart.length());
-    if (characterPair != commentStart)
-        return;
-
-    // Keep counting open comments.
-    int openComments = 1;
-
-    currentCharIndex += static_cast<long>(commentStart.length());
-    while (openComments > 0) {
-        // Skip all white spaces.
-        skipWhiteCharacters();
-
-        // If we reach the end of the file and there's still an unclosed comment, it's an error.
-        if (currentCharIndex + commentStart.length() > fileContent.length()) {
-            FJP::exitProgramWithError(FJP::CompilationErrors::ERROR_01, ERR_CODE);
-        }
-
-        // Parse the next two characters.
-        characterPair = fileContent.substr(currentCharIndex, commentStart.length());
-
-        // Check if it's an opening of another comment,
-        // closing sequence, or neither.
-        if (characterPair == commentStart) {
-            openComments++;
-            currentCharIndex += static_cast<long>(commentStart.length());
-        } else if (characterPair == commentEnd) {
-            openComments--;
-            currentCharIndex += static_cast<long>(commentStart.length());
-        } else {
-            currentCharIndex++;
-        }
+void FJP::Lexer::stopPipeline() {
+    if (producer.joinable()) {
+        tokenQueue.cancel();
+        producer.join();
     }
-    // Skip all white spaces.
-    skipWhiteCharacters();
-}
\ No newline at end of file
+    pipelined = false;
+}
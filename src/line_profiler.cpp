@@ -0,0 +1,72 @@
+#include <fstream>
+#include <iomanip>
+
+#include <line_profiler.h>
+#include <errors.h>
+
+FJP::LineProfiler::LineProfiler(std::string filename) : sourceFile(std::move(filename)) {
+}
+
+void FJP::LineProfiler::instructionExecuted(int address) {
+    // Grow the table lazily, so we don't need to know the size of the program up front.
+    if (static_cast<size_t>(address) >= executionCounts.size()) {
+        executionCounts.resize(address + 1, 0);
+    }
+    executionCounts[address]++;
+}
+
+void FJP::LineProfiler::functionCalled(int address) {
+    // Just so the compiler doesn't complain about an unused value.
+    (void)address;
+}
+
+void FJP::LineProfiler::functionReturned() {
+}
+
+void FJP::LineProfiler::report(const FJP::GeneratedCode &program) {
+    // Read up the source code line by line.
+    std::ifstream source(sourceFile);
+    if (!source.is_open()) {
+        FJP::exitProgramWithError(FJP::IOErrors::ERROR_00, ERR_CODE);
+    }
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(source, line);) {
+        lines.push_back(line);
+    }
+
+    // Sum up the execution counts of all instructions generated from the same line.
+    std::vector<uint64_t> lineCounts(lines.size(), 0);
+    uint64_t total = 0;
+    const auto &lineTable = program.getLineTable();
+    for (size_t i = 0; i < lineTable.size(); i++) {
+        size_t end = (i + 1 < lineTable.size()) ? static_cast<size_t>(lineTable[i + 1].address) : executionCounts.size();
+        int lineNumber = lineTable[i].lineNumber;
+        for (size_t address = lineTable[i].address; address < end && address < executionCounts.size(); address++) {
+            if (lineNumber >= 0 && static_cast<size_t>(lineNumber) < lineCounts.size()) {
+                lineCounts[lineNumber] += executionCounts[address];
+            }
+            total += executionCounts[address];
+        }
+    }
+
+    std::ofstream file(OUTPUT_FILE);
+    if (!file.is_open()) {
+        FJP::exitProgramWithError(FJP::IOErrors::ERROR_01, ERR_CODE);
+    }
+
+    // Print out the source code where each line is prefixed with the number
+    // of instructions it was responsible for and its share of the total.
+    file << "total instructions executed: " << total << "\n\n";
+    file << std::setw(12) << "count" << std::setw(8) << "%" << std::setw(7) << "line" << "  source\n";
+    for (size_t i = 0; i < lines.size(); i++) {
+        if (lineCounts[i] > 0) {
+            double percentage = total > 0 ? 100.0 * static_cast<double>(lineCounts[i]) / static_cast<double>(total) : 0.0;
+            file << std::setw(12) << lineCounts[i]
+                 << std::setw(8) << std::fixed << std::setprecision(2) << percentage;
+        } else {
+            file << std::setw(20) << "";
+        }
+        file << std::setw(7) << (i + 1) << "  " << lines[i] << "\n";
+    }
+    file.close();
+}
@@ -0,0 +1,270 @@
+#include <new>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+# include <csignal>
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# define LIVE_STATS_SUPPORTED
+#endif
+
+#include <live_stats.h>
+#include <errors.h>
+
+namespace {
+
+    /// Error code used when the shared memory segment cannot be created.
+    constexpr int ERR_CODE = 3;
+
+#ifdef LIVE_STATS_SUPPORTED
+    /// Returns the current value of the monotonic clock in nanoseconds.
+    int64_t now() {
+        struct timespec time {};
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+    }
+#endif
+
+    /// Simple fixed-size buffer used to format the stack dump
+    /// (no allocations, no stdio, so it does not mix with the output of the program).
+    class DumpBuffer {
+    private:
+        char buffer[4096];
+        size_t length = 0;
+
+    public:
+        void append(const char *text) {
+            while (*text != '\0') {
+                if (length == sizeof(buffer)) {
+                    flush();
+                }
+                buffer[length++] = *text++;
+            }
+        }
+
+        void append(long value) {
+            char digits[24];
+            int count = 0;
+            unsigned long magnitude = value < 0 ? 0UL - static_cast<unsigned long>(value) : static_cast<unsigned long>(value);
+            do {
+                digits[count++] = static_cast<char>('0' + magnitude % 10);
+                magnitude /= 10;
+            } while (magnitude != 0);
+            if (value < 0) {
+                digits[count++] = '-';
+            }
+            char text[24];
+            for (int i = 0; i < count; i++) {
+                text[i] = digits[count - 1 - i];
+            }
+            text[count] = '\0';
+            append(text);
+        }
+
+        void flush() {
+#ifdef LIVE_STATS_SUPPORTED
+            size_t written = 0;
+            while (written < length) {
+                ssize_t result = write(STDERR_FILENO, buffer + written, length - written);
+                if (result <= 0) {
+                    break;
+                }
+                written += static_cast<size_t>(result);
+            }
+#endif
+            length = 0;
+        }
+    };
+}
+
+FJP::LiveStats *FJP::LiveStats::instance = nullptr;
+
+FJP::LiveStats* FJP::LiveStats::getInstance() {
+    if (instance == nullptr) {
+        instance = new LiveStats;
+    }
+    return instance;
+}
+
+FJP::LiveStats::LiveStats() : stats(nullptr), program(nullptr), stackMemory(nullptr), stackSize(0), dumpRequested(0) {
+}
+
+void FJP::LiveStats::start(const FJP::GeneratedCode &code, const int *stack, int size) {
+    program = &code;
+    stackMemory = stack;
+    stackSize = size;
+    dumpRequested = 0;
+
+    functionNames.clear();
+    functionNames.emplace_back(0, code.getFunctionName(0));
+    for (const auto &function : code.getFunctions()) {
+        functionNames.emplace_back(function.first, function.second.name);
+    }
+
+#ifdef LIVE_STATS_SUPPORTED
+    // Create the shared memory segment. If there is a leftover one
+    // from a previous process with the same PID, just reuse it.
+    name = std::string(FJP::VM_STATS_SHM_PREFIX) + std::to_string(getpid());
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) {
+        FJP::exitProgramWithError(FJP::IOErrors::ERROR_02, ERR_CODE);
+    }
+    if (ftruncate(fd, sizeof(FJP::VMStats)) != 0) {
+        close(fd);
+        shm_unlink(name.c_str());
+        FJP::exitProgramWithError(FJP::IOErrors::ERROR_02, ERR_CODE);
+    }
+    void *memory = mmap(nullptr, sizeof(FJP::VMStats), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        FJP::exitProgramWithError(FJP::IOErrors::ERROR_02, ERR_CODE);
+    }
+
+    // Construct the statistics (all zeros) within the shared memory.
+    stats = new (memory) FJP::VMStats();
+    stats->pid = getpid();
+    stats->startTime = now();
+    stats->version = FJP::VM_STATS_VERSION;
+
+    // The magic number goes last, so the reader never sees a half-initialized segment.
+    std::atomic_thread_fence(std::memory_order_release);
+    stats->magic = FJP::VM_STATS_MAGIC;
+
+    // Install the handler dumping the stack. SA_RESTART makes sure
+    // reading the input of the program is not interrupted by the signal.
+    struct sigaction action {};
+    action.sa_handler = &LiveStats::handleSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR1, &action, nullptr);
+
+    // Make sure the segment is removed even if the program gets terminated by a runtime error.
+    static bool cleanupRegistered = false;
+    if (!cleanupRegistered) {
+        std::atexit([]() { instance->stop(); });
+        cleanupRegistered = true;
+    }
+
+    std::cerr << "live statistics: " << name << " (pid " << getpid() << ")\n";
+#endif
+}
+
+void FJP::LiveStats::publish(uint64_t instructions, int eip, int ebp, int esp, int peakESP, int callDepth, uint64_t reads, uint64_t writes) {
+    if (stats == nullptr) {
+        return;
+    }
+
+    // The stack dump is written by the virtual machine itself, so it never races with the execution.
+    if (dumpRequested.load(std::memory_order_relaxed) != 0) {
+        dumpRequested.store(0, std::memory_order_relaxed);
+        dumpStack(eip, ebp, esp);
+    }
+
+    // Odd sequence number = the values are being updated.
+    uint64_t sequence = stats->sequence.load(std::memory_order_relaxed);
+    stats->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    stats->instructions.store(instructions, std::memory_order_relaxed);
+    stats->currentESP.store(esp, std::memory_order_relaxed);
+    stats->peakESP.store(peakESP, std::memory_order_relaxed);
+    // Returning from the main block makes the depth drop below zero.
+    stats->callDepth.store(callDepth < 0 ? 0 : callDepth, std::memory_order_relaxed);
+    stats->reads.store(reads, std::memory_order_relaxed);
+    stats->writes.store(writes, std::memory_order_relaxed);
+
+    stats->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void FJP::LiveStats::stop() {
+#ifdef LIVE_STATS_SUPPORTED
+    signal(SIGUSR1, SIG_DFL);
+    if (stats != nullptr) {
+        // Let the reader know the program has finished. A reader that has already
+        // mapped the segment keeps it until it unmaps it, even after it is unlinked.
+        stats->endTime.store(now(), std::memory_order_release);
+        munmap(stats, sizeof(FJP::VMStats));
+        shm_unlink(name.c_str());
+        stats = nullptr;
+    }
+#endif
+}
+
+void FJP::LiveStats::handleSignal(int signal) {
+    // Just so the compiler doesn't complain about an unused value.
+    (void)signal;
+
+    if (instance != nullptr) {
+        instance->dumpRequested.store(1, std::memory_order_relaxed);
+    }
+}
+
+const char *FJP::LiveStats::getFunctionName(int address) const {
+    for (const auto &function : functionNames) {
+        if (function.first == address) {
+            return function.second.c_str();
+        }
+    }
+    return "unknown";
+}
+
+void FJP::LiveStats::dumpStack(int eip, int ebp, int esp) const {
+    DumpBuffer output;
+    int top = esp;
+    int base = ebp;
+
+    output.append("--- stack dump (EIP=");
+    output.append(static_cast<long>(eip));
+    output.append(" EBP=");
+    output.append(static_cast<long>(base));
+    output.append(" ESP=");
+    output.append(static_cast<long>(top));
+    output.append(") ---\n");
+
+    // Walk the frames through their dynamic links (base + 2). The function of a frame
+    // is the target of the CAL instruction that created it (return address - 1).
+    // The VM might have just returned from the main block, so never read outside of the stack.
+    for (int frame = 0; frame < MAX_DUMPED_FRAMES && base >= 1 && base < stackSize; frame++) {
+        int function = 0;
+        if (base > 1 && base + 3 < stackSize) {
+            int callAddress = stackMemory[base + 3] - 1;
+            if (callAddress >= 0 && callAddress < program->getSize() && (*program)[callAddress].op == FJP::OP_CODE::CAL) {
+                function = (*program)[callAddress].m;
+            }
+        }
+        output.append("#");
+        output.append(static_cast<long>(frame));
+        output.append(" ");
+        output.append(getFunctionName(function));
+        output.append(" [");
+        output.append(static_cast<long>(base));
+        output.append("..");
+        output.append(static_cast<long>(top));
+        output.append("]:");
+        for (int i = base; i <= top && i < stackSize; i++) {
+            if (i - base == MAX_DUMPED_SLOTS) {
+                output.append(" ...");
+                break;
+            }
+            output.append(" ");
+            output.append(static_cast<long>(stackMemory[i]));
+        }
+        output.append("\n");
+
+        // The main frame has its dynamic link set to 0.
+        if (base == 1) {
+            break;
+        }
+        int previousBase = stackMemory[base + 2];
+        if (previousBase >= base) {
+            break;
+        }
+        top = base - 1;
+        base = previousBase;
+    }
+    output.flush();
+}
@@ -0,0 +1,415 @@
+#include <loop_vectorizer.h>
+
+namespace {
+
+    /// Returns true if both values refer to the same variable.
+    bool sameVariable(const FJP::VectorValue &a, const FJP::VectorValue &b) {
+        return a.isVariable && b.isVariable && a.level == b.level && a.address == b.address;
+    }
+
+    /// Returns true if both operands refer to the same array.
+    bool sameArray(const FJP::VectorArray &a, const FJP::VectorArray &b) {
+        return a.inDataSegment == b.inDataSegment && a.level == b.level && a.address == b.address;
+    }
+
+    /// Returns true if the variable is one of the elements of the array.
+    bool variableWithinArray(const FJP::VectorValue &variable, const FJP::VectorArray &array) {
+        return variable.isVariable && !array.inDataSegment && variable.level == array.level &&
+               variable.address >= array.address && variable.address < array.address + array.size;
+    }
+}
+
+FJP::LoopVectorizer::LoopVectorizer() : program(nullptr), limit(0), loop{} {
+}
+
+
+bool FJP::LoopVectorizer::vectorizeFor(FJP::GeneratedCode &code, int startCondition) {
+    program = &code;
+    limit = code.getSize();
+    loop = {};
+
+    int end = code.getSize();
+    int position = startCondition;
+    int type;
+
+    // <counter> < <bound> (or <=), jumping to the end of the loop if it does not hold
+    if (!matchVariable(position, FJP::OP_CODE::LOD, loop.counter) || !matchCondition(position, end, type, loop.bound)) {
+        return false;
+    }
+    if (type != FJP::OPRType::OPR_LESS && type != FJP::OPRType::OPR_LESS_EQ) {
+        return false;
+    }
+    loop.inclusive = type == FJP::OPRType::OPR_LESS_EQ;
+
+    // JMP over the update part to the body.
+    int startUpdatePart = position + 1;
+    int startBody = startUpdatePart + 2;
+    if (!matchInstruction(position, FJP::OP_CODE::JMP, 0, startBody)) {
+        return false;
+    }
+
+    // <counter> := <counter> + 1
+    FJP::VectorValue updated {};
+    if (!matchIncrement(position, updated) || !sameVariable(updated, loop.counter) ||
+        !matchInstruction(position, FJP::OP_CODE::JMP, 0, startCondition)) {
+        return false;
+    }
+
+    // The body is followed by a jump back to the update part.
+    int jumpBack = end - 1;
+    if (!matchInstruction(jumpBack, FJP::OP_CODE::JMP, 0, startUpdatePart)) {
+        return false;
+    }
+    limit = end - 1;
+
+    FJP::OP_CODE op;
+    if (!matchBody(position, op) || !checkOperands(op)) {
+        return false;
+    }
+    emit(code, startCondition, end, op);
+    return true;
+}
+
+bool FJP::LoopVectorizer::vectorizeForeach(FJP::GeneratedCode &code, int startLoop, int indexAddress) {
+    program = &code;
+    limit = code.getSize();
+    loop = {};
+    loop.foreachLoop = true;
+    loop.counter = {true, 0, 0, indexAddress};
+
+    // The loop ends with the INC removing the index.
+    int last = code.getSize() - 1;
+    int position = last;
+    if (!matchInstruction(position, FJP::OP_CODE::INC, 0, -1)) {
+        return false;
+    }
+
+    // <index> := 0
+    position = startLoop;
+    if (!matchInstruction(position, FJP::OP_CODE::LIT, 0, 0) || !matchInstruction(position, FJP::OP_CODE::STO, 0, indexAddress)) {
+        return false;
+    }
+
+    // <index> != <size>, jumping to the end of the loop if it does not hold
+    int startCondition = position;
+    FJP::VectorValue size {};
+    int type;
+    if (!matchInstruction(position, FJP::OP_CODE::LOD, 0, indexAddress) || !matchCondition(position, last, type, size) ||
+        size.isVariable || type != FJP::OPRType::OPR_NEQ) {
+        return false;
+    }
+
+    // <iterator> := <array>[<index>]
+    if (!matchIndex(position) || !matchAccess(position, true, loop.first) || loop.first.size != size.value ||
+        !matchVariable(position, FJP::OP_CODE::STO, loop.iterator)) {
+        return false;
+    }
+
+    // <index> := <index> + 1
+    FJP::VectorValue updated {};
+    if (!matchIncrement(position, updated) || !sameVariable(updated, loop.counter)) {
+        return false;
+    }
+
+    // The body is followed by a jump back to the condition.
+    int jumpBack = last - 1;
+    if (!matchInstruction(jumpBack, FJP::OP_CODE::JMP, 0, startCondition)) {
+        return false;
+    }
+    limit = last - 1;
+
+    FJP::OP_CODE op;
+    if (!matchBody(position, op) || !checkOperands(op)) {
+        return false;
+    }
+    emit(code, startLoop, last, op);
+    return true;
+}
+
+bool FJP::LoopVectorizer::matchInstruction(int &position, FJP::OP_CODE op, int l, int m) {
+    if (position >= limit) {
+        return false;
+    }
+    const FJP::Instruction &instruction = (*program)[position];
+    if (instruction.op != op || instruction.l != l || instruction.m != m) {
+        return false;
+    }
+    position++;
+    return true;
+}
+
+bool FJP::LoopVectorizer::matchVariable(int &position, FJP::OP_CODE op, FJP::VectorValue &variable) {
+    if (position >= limit || (*program)[position].op != op) {
+        return false;
+    }
+    variable = {true, 0, (*program)[position].l, (*program)[position].m};
+    position++;
+    return true;
+}
+
+bool FJP::LoopVectorizer::matchValue(int &position, FJP::VectorValue &value) {
+    if (position < limit && (*program)[position].op == FJP::OP_CODE::LIT) {
+        value = {false, (*program)[position].m, 0, 0};
+        position++;
+        return true;
+    }
+    return matchVariable(position, FJP::OP_CODE::LOD, value);
+}
+
+bool FJP::LoopVectorizer::matchIncrement(int &position, FJP::VectorValue &variable) {
+    if (position >= limit || (*program)[position].op != FJP::OP_CODE::ADDVI) {
+        return false;
+    }
+    const FJP::VariableUpdate &update = program->getVariableUpdate((*program)[position].m);
+    if (update.value != 1) {
+        return false;
+    }
+    variable = {true, 0, update.level, update.address};
+    position++;
+    return true;
+}
+
+bool FJP::LoopVectorizer::matchOperation(int &position, int &type) {
+    if (position >= limit || (*program)[position].op != FJP::OP_CODE::OPR) {
+        return false;
+    }
+    type = (*program)[position].m;
+    position++;
+    return true;
+}
+
+bool FJP::LoopVectorizer::matchBranch(int &position, bool immediate, int target, int &comparison, int &operand) {
+    if (position >= limit) {
+        return false;
+    }
+    const FJP::Instruction &instruction = (*program)[position];
+    int type = FJP::branch_comparison(instruction.op);
+    if (type == -1 || FJP::is_immediate_branch(instruction.op) != immediate || instruction.m != target) {
+        return false;
+    }
+
+    // The branch skips the code guarded by the condition, so it jumps if the condition does not hold.
+    comparison = FJP::negate_comparison(type);
+    operand = instruction.l;
+    position++;
+    return true;
+}
+
+bool FJP::LoopVectorizer::matchCondition(int &position, int target, int &comparison, FJP::VectorValue &operand) {
+    // <value> <comparison> <constant>
+    int immediate;
+    if (matchBranch(position, true, target, comparison, immediate)) {
+        operand = {false, immediate, 0, 0};
+        return true;
+    }
+
+    // <value> <comparison> <variable>
+    int start = position;
+    if (matchVariable(position, FJP::OP_CODE::LOD, operand) && matchBranch(position, false, target, comparison, immediate)) {
+        return true;
+    }
+    position = start;
+    return false;
+}
+
+bool FJP::LoopVectorizer::matchIndex(int &position) {
+    FJP::VectorValue counter {};
+    return matchVariable(position, FJP::OP_CODE::LOD, counter) && sameVariable(counter, loop.counter);
+}
+
+bool FJP::LoopVectorizer::matchAccess(int &position, bool load, FJP::VectorArray &array) {
+    if (position >= limit) {
+        return false;
+    }
+    const FJP::Instruction &instruction = (*program)[position];
+
+    if (instruction.op == (load ? FJP::OP_CODE::LDX : FJP::OP_CODE::STX)) {
+        // LDX/STX <level> <address> - the size is kept aside from the instruction
+        int size = program->getArraySize(position);
+        if (size < 0) {
+            return false;
+        }
+        array = {false, instruction.l, instruction.m, size};
+    } else if (instruction.op == (load ? FJP::OP_CODE::LDD : FJP::OP_CODE::STD)) {
+        // LDD/STD <size> <address>
+        array = {true, 0, instruction.m, instruction.l};
+    } else {
+        return false;
+    }
+    position++;
+    return true;
+}
+
+bool FJP::LoopVectorizer::matchElement(int &position, FJP::VectorArray &array) {
+    // The current element of a foreach loop is held by the iterator.
+    if (loop.foreachLoop) {
+        FJP::VectorValue iterator {};
+        if (!matchVariable(position, FJP::OP_CODE::LOD, iterator) || !sameVariable(iterator, loop.iterator)) {
+            return false;
+        }
+        array = loop.first;
+        return true;
+    }
+    return matchIndex(position) && matchAccess(position, true, array);
+}
+
+bool FJP::LoopVectorizer::matchBody(int position, FJP::OP_CODE &op) {
+    // A failed attempt may leave some operands behind.
+    FJP::VectorLoop header = loop;
+    if (matchReduction(position, op)) {
+        return true;
+    }
+    loop = header;
+    return !loop.foreachLoop && matchElementWise(position, op);
+}
+
+bool FJP::LoopVectorizer::matchReduction(int position, FJP::OP_CODE &op) {
+    int start = position;
+    int type;
+    FJP::VectorValue stored {};
+
+    // <target> := <target> + <element> (updated in place)
+    if (matchElement(position, loop.first) && matchVariable(position, FJP::OP_CODE::ADDV, loop.target) && position == limit) {
+        op = FJP::OP_CODE::VSUM;
+        return true;
+    }
+
+    // if (<element> <comparison> <operand>), jumping over the body if it does not hold
+    position = start;
+    if (!matchElement(position, loop.first)) {
+        return false;
+    }
+    int afterElement = position;
+    int unused;
+    loop.secondIsArray = !loop.foreachLoop && matchElement(position, loop.second) && matchBranch(position, false, limit, type, unused);
+    if (!loop.secondIsArray) {
+        position = afterElement;
+        if (!matchCondition(position, limit, type, loop.operand)) {
+            return false;
+        }
+    }
+    int startThen = position;
+
+    // <operand> := <element> (the operand is the minimum/maximum found so far)
+    FJP::VectorArray element {};
+    if (!loop.secondIsArray && matchElement(position, element) && sameArray(element, loop.first) &&
+        matchVariable(position, FJP::OP_CODE::STO, stored) && sameVariable(stored, loop.operand) && position == limit) {
+        if (type == FJP::OPRType::OPR_LESS || type == FJP::OPRType::OPR_LESS_EQ) {
+            op = FJP::OP_CODE::VMIN;
+        } else if (type == FJP::OPRType::OPR_GRT || type == FJP::OPRType::OPR_GRT_EQ) {
+            op = FJP::OP_CODE::VMAX;
+        } else {
+            return false;
+        }
+        loop.target = loop.operand;
+        loop.operand = {};
+        return true;
+    }
+
+    // <target> := <target> + 1
+    position = startThen;
+    if (matchIncrement(position, loop.target) && position == limit) {
+        loop.comparison = type;
+        op = FJP::OP_CODE::VCMP;
+        return true;
+    }
+    return false;
+}
+
+bool FJP::LoopVectorizer::matchElementWise(int position, FJP::OP_CODE &op) {
+    // <destination>[<counter>] := ...
+    if (!matchIndex(position)) {
+        return false;
+    }
+    int afterIndex = position;
+    int type;
+
+    // ... <element> + <element> (or *)
+    if (matchElement(position, loop.first) && matchElement(position, loop.second) && matchOperation(position, type) &&
+        (type == FJP::OPRType::OPR_PLUS || type == FJP::OPRType::OPR_MUL) &&
+        matchAccess(position, false, loop.destination) && position == limit) {
+        op = type == FJP::OPRType::OPR_PLUS ? FJP::OP_CODE::VADD : FJP::OP_CODE::VMUL;
+        return true;
+    }
+
+    // ... <operand> (converted into 1/0 if the destination is an array of booleans)
+    position = afterIndex;
+    if (!matchValue(position, loop.operand)) {
+        return false;
+    }
+    loop.normalize = matchInstruction(position, FJP::OP_CODE::CMPI, FJP::OPRType::OPR_NEQ, 0);
+    if (matchAccess(position, false, loop.destination) && position == limit) {
+        op = FJP::OP_CODE::VFILL;
+        return true;
+    }
+    return false;
+}
+
+bool FJP::LoopVectorizer::checkOperands(FJP::OP_CODE op) const {
+    // Variables written by the loop followed by the ones it only reads.
+    std::vector<FJP::VectorValue> written = {loop.counter};
+    std::vector<FJP::VectorValue> variables;
+    if (loop.foreachLoop) {
+        written.push_back(loop.iterator);
+    } else {
+        variables.push_back(loop.bound);
+    }
+    std::vector<FJP::VectorArray> arrays;
+    switch (op) {
+        case FJP::OP_CODE::VSUM:
+        case FJP::OP_CODE::VMIN:
+        case FJP::OP_CODE::VMAX:
+            written.push_back(loop.target);
+            arrays.push_back(loop.first);
+            break;
+        case FJP::OP_CODE::VCMP:
+            written.push_back(loop.target);
+            arrays.push_back(loop.first);
+            if (loop.secondIsArray) {
+                arrays.push_back(loop.second);
+            } else {
+                variables.push_back(loop.operand);
+            }
+            break;
+        case FJP::OP_CODE::VADD:
+        case FJP::OP_CODE::VMUL:
+            arrays.push_back(loop.first);
+            arrays.push_back(loop.second);
+            arrays.push_back(loop.destination);
+            break;
+        case FJP::OP_CODE::VFILL:
+            variables.push_back(loop.operand);
+            arrays.push_back(loop.destination);
+            break;
+        default:
+            return false;
+    }
+    variables.insert(variables.begin(), written.begin(), written.end());
+
+    // A variable written by the loop must not be used for anything else.
+    for (size_t i = 0; i < written.size(); i++) {
+        for (size_t j = 0; j < variables.size(); j++) {
+            if (i != j && sameVariable(written[i], variables[j])) {
+                return false;
+            }
+        }
+    }
+
+    // No variable may be one of the elements of the arrays (e.g. the index of a foreach
+    // loop placed over an array due to the way the temporary index gets its address).
+    for (const auto &variable : variables) {
+        for (const auto &array : arrays) {
+            if (variableWithinArray(variable, array)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void FJP::LoopVectorizer::emit(FJP::GeneratedCode &code, int address, int end, FJP::OP_CODE op) {
+    int index = code.addVectorLoop(loop);
+
+    // The jump lands right after the loop, which moves along with the loop itself.
+    code.insertInstructions(address, {{op, 0, index}, {FJP::OP_CODE::JMP, 0, end + 2}});
+}
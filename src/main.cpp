@@ -10,16 +10,34 @@
 #include <parser.h>
 #include <iparser.h>
 #include <logger.h>
+#include <line_profiler.h>
+#include <call_profiler.h>
+#include <sampling_profiler.h>
+#include <live_stats.h>
+#include <c_emitter.h>
+#include <bytecode.h>
+#include <compile_cache.h>
 
 int main(int argc, char *argv[]) {
     // Create argument parser.
     cxxopts::ParseResult arg;
     cxxopts::Options options("./fjp <input>", "FJP compiler");
+    options.set_width(100);
 
     // Add options as to with what flags the application could be run.
     options.add_options()
             ("d,debug", "generates the following files: tokens.json, code.pl0, stacktrace.txt", cxxopts::value<bool>()->default_value("false"))
             ("r,run", "executes the program", cxxopts::value<bool>()->default_value("false"))
+            ("profile-lines", "generates profile_lines.txt (per-line profile)", cxxopts::value<bool>()->default_value("false"))
+            ("profile-calls", "generates profile_calls.txt/.folded (call graph)", cxxopts::value<bool>()->default_value("false"))
+            ("sample-profile", "generates profile_samples.txt/.folded (sampling)", cxxopts::value<bool>()->default_value("false"))
+            ("live-stats", "publishes live statistics for fjp-top", cxxopts::value<bool>()->default_value("false"))
+            ("check-bounds", "checks the indexes of arrays against their sizes", cxxopts::value<bool>()->default_value("false"))
+            ("emit-c", "translates the program into C", cxxopts::value<std::string>(), "<file>")
+            ("dump-tokens", "stores the tokens into a binary file (see README.md)", cxxopts::value<std::string>(), "<file>")
+            ("emit-bytecode", "stores the compiled program into a bytecode file", cxxopts::value<std::string>(), "<file>")
+            ("load", "executes a bytecode file instead of the source code", cxxopts::value<std::string>(), "<file>")
+            ("cache", "reuses programs compiled before (~/.cache/fjp)", cxxopts::value<bool>()->default_value("false"))
             ("h,help" , "prints help")
             ;
 
@@ -38,6 +56,12 @@ int main(int argc, char *argv[]) {
                                             "     Run './fjp --help'\n", 4);
     }
 
+    // The line profiler annotates the source code, which is not available when loading a bytecode file.
+    if (arg.count("load") && arg["profile-lines"].as<bool>()) {
+        FJP::exitProgramWithError("\nERR: --profile-lines cannot be used along with --load!\n"
+                                            "     Run './fjp --help'\n", 4);
+    }
+
     // Check if the user turned on debugging.
     bool debug = arg["debug"].as<bool>();
 
@@ -46,12 +70,57 @@ int main(int argc, char *argv[]) {
     FJP::ILexer *lexer = FJP::Lexer::getInstance();
     FJP::IVM *vm = FJP::VirtualMachine::getInstance();
 
-    // Parse the input program and generate output code.
-    lexer->init(argv[1], debug);
-    auto program = parser->parse(lexer, debug);
+    // Load the compiled program from a bytecode file, or parse the input program and generate output code.
+    // The loaded instructions stay within the mapped file, so the file has to outlive the program.
+    FJP::BytecodeFile bytecodeFile;
+    FJP::GeneratedCode program;
+    bool loaded = arg.count("load") > 0;
+    if (loaded) {
+        program = bytecodeFile.load(arg["load"].as<std::string>());
+    } else {
+        // The debug outputs (and the dump of the tokens) are generated by the lexer and the parser,
+        // so the cache is not used with them.
+        std::string tokenDumpFile = arg.count("dump-tokens") ? arg["dump-tokens"].as<std::string>() : "";
+        FJP::CompileCache cache;
+        bool useCache = arg["cache"].as<bool>() && !debug && tokenDumpFile.empty();
+        if (!useCache || !cache.load(argv[1], bytecodeFile, program)) {
+            lexer->init(argv[1], debug, tokenDumpFile);
+            program = parser->parse(lexer, debug);
+            if (useCache) {
+                cache.store(program);
+            }
+        }
+    }
+
+    // If the user added the 'emit-bytecode' option, store the compiled program.
+    if (arg.count("emit-bytecode")) {
+        FJP::BytecodeFile::store(program, arg["emit-bytecode"].as<std::string>());
+    }
+
+    // If the user added the 'emit-c' option, translate the program into C.
+    if (arg.count("emit-c")) {
+        FJP::CEmitter emitter(program, arg["check-bounds"].as<bool>());
+        emitter.emit(arg["emit-c"].as<std::string>());
+    }
 
-    // If the user added the 'run' option, execute the program.
-    if (arg["run"].as<bool>()) {
+    // If the user added the 'run' option (or loaded a compiled program), execute the program.
+    if (arg["run"].as<bool>() || loaded) {
+        // Attach the profilers if requested.
+        FJP::LineProfiler lineProfiler(argv[1]);
+        if (arg["profile-lines"].as<bool>()) {
+            vm->addProfiler(&lineProfiler);
+        }
+        FJP::CallProfiler callProfiler;
+        if (arg["profile-calls"].as<bool>()) {
+            vm->addProfiler(&callProfiler);
+        }
+        if (arg["sample-profile"].as<bool>()) {
+            vm->setSamplingProfiler(FJP::SamplingProfiler::getInstance());
+        }
+        if (arg["live-stats"].as<bool>()) {
+            vm->setLiveStats(FJP::LiveStats::getInstance());
+        }
+        vm->setBoundsChecking(arg["check-bounds"].as<bool>());
         vm->execute(program, debug);
     }
     return 0;
@@ -6,6 +6,8 @@
 #include <isa.h>
 #include <parser.h>
 #include <errors.h>
+#include <probes.h>
+#include <stack_analyzer.h>
 
 #define PRINT_ADDRESSES
 
@@ -22,15 +24,17 @@ FJP::Parser* FJP::Parser::getInstance() {
     return instance;
 }
 
-FJP::Parser::Parser() : lexer(nullptr), nextFreeAddress(0) {
+FJP::Parser::Parser() : lexer(nullptr), nextFreeAddress(0), lastLabelAddress(-1) {
 }
 
 FJP::GeneratedCode FJP::Parser::parse(FJP::ILexer *i_lexer, bool debug) {
     // Make sure that the i_lexer is not nullptr.
     assert(i_lexer != nullptr);
+    FJP_PROBE0(parser_parse_start);
 
     this->lexer = i_lexer;
     generatedCode = FJP::GeneratedCode();
+    lastLabelAddress = -1;
 
     // START
     token = i_lexer->getNextToken();
@@ -47,6 +51,9 @@ FJP::GeneratedCode FJP::Parser::parse(FJP::ILexer *i_lexer, bool debug) {
         FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_36, ERR_CODE, token.lineNumber);
     }
 
+    // Let the lexer go through whatever follows END.
+    i_lexer->finish();
+
     // Make sure that all undefined labels were eventually defined.
     for (auto &label : undefinedLabels) {
         std::string errMsg = "label '";
@@ -55,11 +62,16 @@ FJP::GeneratedCode FJP::Parser::parse(FJP::ILexer *i_lexer, bool debug) {
         FJP::exitProgramWithError(__FUNCTION__, errMsg.c_str(), ERR_CODE, token.lineNumber);
     }
 
+    // Compute how much of the stack the program needs, so the virtual machine can size it up front.
+    generatedCode.setStackBound(FJP::StackAnalyzer(generatedCode).analyze());
+
     // If the debug flag is on, spill the generated code out into a file.
     if (debug == true) {
         storeCodeInstructionsIntoFile();
     }
 
+    FJP_PROBE1(parser_parse_end, generatedCode.getSize());
+
     // Return the generated program co it can be executed by the virtual machine.
     return generatedCode;
 }
@@ -98,6 +110,9 @@ void FJP::Parser::processBlock() {
     nextFreeAddress = FRAME_INIT_VAR_COUNT;
     symbolTable.createFrame();
 
+    // The frame allocation belongs to the line the block starts on.
+    generatedCode.setLineNumber(token.lineNumber);
+
     // Added a new instruction that will allocate a certain amount
     // of variable on the stack. The particular value will be specified
     // once the block has been completely parsed.
@@ -132,6 +147,7 @@ void FJP::Parser::processBlock() {
     symbolTable.destroyFrame();
 
     // Add a return operation as a return from the function.
+    generatedCode.setLineNumber(token.lineNumber);
     generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_RET});
 }
 
@@ -179,7 +195,7 @@ void FJP::Parser::processConst() {
                         FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_07, ERR_CODE, token.lineNumber);
                     }
                     // Convert the token value into an int and set to the identifier in the symbol table.
-                    value = atoi(token.value.c_str());
+                    value = token.number;
                     symbolTable.addSymbol({FJP::SymbolType::SYMBOL_CONST, identifier, value, 0, 0, 0});
                     break;
 
@@ -219,7 +235,9 @@ void FJP::Parser::processVariable(int &frameVariableCount) {
         return;
     }
 
-    int arrayAddress;  // start address of an array
+    // Instructions initializing arrays belong to the line of the declaration.
+    generatedCode.setLineNumber(token.lineNumber);
+
     int arraySize = 0; // size of an array
     int arrayDepth;    // level/depth of an array
 
@@ -263,13 +281,12 @@ void FJP::Parser::processVariable(int &frameVariableCount) {
         // '['
         token = lexer->getNextToken();
         if (token.tokenType == FJP::TokenType::LEFT_SQUARED_BRACKET) {
-            arrayAddress = nextFreeAddress - 1;
             token = lexer->getNextToken();
 
             switch (token.tokenType) {
                 // number e.g. arr[10]
                 case FJP::TokenType::NUMBER:
-                    arraySize = atoi(token.value.c_str());
+                    arraySize = token.number;
                     if (arraySize <= 0) {
                         FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_40, ERR_CODE, token.lineNumber);
                     }
@@ -310,6 +327,19 @@ void FJP::Parser::processVariable(int &frameVariableCount) {
             if (token.tokenType != FJP::TokenType::RIGHT_SQUARED_BRACKET) {
                 FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_16, ERR_CODE, token.lineNumber);
             }
+
+            // Arrays of the main block (global arrays) exist for the whole run of the program,
+            // so they are moved out of the stack into the data segment. This way, they can
+            // be much larger than the stack and their elements are checked for bounds.
+            if (arrayDepth == 0) {
+                if (arraySize > MAX_DATA_SIZE - generatedCode.getDataSize()) {
+                    FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_46, ERR_CODE, token.lineNumber);
+                }
+                nextFreeAddress -= arraySize;
+                frameVariableCount -= arraySize;
+                symbolTable.moveToDataSegment(identifier, generatedCode.allocateData(arraySize));
+            }
+            symbol = symbolTable.findSymbol(identifier);
             token = lexer->getNextToken();
 
             // '='
@@ -322,6 +352,7 @@ void FJP::Parser::processVariable(int &frameVariableCount) {
 
                 // If the user decides to initialize the array, they need
                 // to initialize all elements, not just a subarray.
+                std::vector<int> values;
                 for (int i = 0; i < arraySize; i++) {
                     token = lexer->getNextToken();
                     switch (dataType) {
@@ -330,9 +361,8 @@ void FJP::Parser::processVariable(int &frameVariableCount) {
                             if (token.tokenType != FJP::TokenType::NUMBER) {
                                 FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_07, ERR_CODE, token.lineNumber);
                             }
-                            number = atoi(token.value.c_str());
-                            generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, number});
-                            generatedCode.addInstruction({FJP::OP_CODE::STO, symbolTable.getDepthLevel() - arrayDepth, arrayAddress + i});
+                            number = token.number;
+                            values.push_back(number);
                             break;
 
                         // 'bool'
@@ -341,8 +371,7 @@ void FJP::Parser::processVariable(int &frameVariableCount) {
                             if (!(token.tokenType == FJP::TokenType::TRUE || token.tokenType == FJP::TokenType::FALSE)) {
                                 FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_10, ERR_CODE, token.lineNumber);
                             }
-                            generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, token.tokenType == FJP::TokenType::TRUE});
-                            generatedCode.addInstruction({FJP::OP_CODE::STO, symbolTable.getDepthLevel() - arrayDepth, arrayAddress + i});
+                            values.push_back(token.tokenType == FJP::TokenType::TRUE);
                             break;
                         default:
                             break;
@@ -358,6 +387,15 @@ void FJP::Parser::processVariable(int &frameVariableCount) {
                     FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_19, ERR_CODE, token.lineNumber);
                 }
                 token = lexer->getNextToken();
+
+                // The values are stored in the constant pool and copied into
+                // the array all at once by a single instruction (CPY/CPD).
+                int poolAddress = generatedCode.addConstants(symbol.address, values);
+                if (symbol.inDataSegment) {
+                    generatedCode.addInstruction({FJP::OP_CODE::CPD, 0, poolAddress});
+                } else {
+                    generatedCode.addInstruction({FJP::OP_CODE::CPY, symbolTable.getDepthLevel() - arrayDepth, poolAddress});
+                }
             }
         }
         // ','
@@ -397,7 +435,8 @@ void FJP::Parser::processFunction() {
         }
 
         // Add the symbol into the symbol table.
-        symbolTable.addSymbol({FJP::SymbolType::SYMBOL_FUNCTION, token.value, generatedCode.getSize(), symbolTable.getDepthLevel(), nextFreeAddress, 0});
+        int functionAddress = generatedCode.getSize();
+        symbolTable.addSymbol({FJP::SymbolType::SYMBOL_FUNCTION, std::string(token.value), functionAddress, symbolTable.getDepthLevel(), nextFreeAddress, 0});
 
         // '('
         token = lexer->getNextToken();
@@ -421,6 +460,9 @@ void FJP::Parser::processFunction() {
         token = lexer->getNextToken();
         processBlock();
 
+        // Now that the whole body has been generated, we know the range of the function.
+        generatedCode.addFunction(functionAddress, generatedCode.getSize(), identifier);
+
         // '}'
         if (token.tokenType != FJP::TokenType::RIGHT_CURLY_BRACKET) {
             FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_19, ERR_CODE, token.lineNumber);
@@ -432,6 +474,9 @@ void FJP::Parser::processFunction() {
 }
 
 void FJP::Parser::processStatement() {
+    // All instructions generated from now on belong to the line the statement starts on.
+    generatedCode.setLineNumber(token.lineNumber);
+
     // ';' - nop
     if (token.tokenType == FJP::TokenType::SEMICOLON) {
         token = lexer->getNextToken();
@@ -454,6 +499,8 @@ void FJP::Parser::processStatement() {
 
 // <identifier> := <expression>;
 // <identifier> := <identifier> := <identifier> := <expression>;
+// <identifier> += <expression>; (also -=, *=)
+// <identifier>++; (also --)
 bool FJP::Parser::processAssignment(bool expectSemicolon) {
     // <identifier>
     if (token.tokenType != FJP::TokenType::IDENTIFIER) {
@@ -466,19 +513,25 @@ bool FJP::Parser::processAssignment(bool expectSemicolon) {
     FJP::Symbol variable = symbolTable.findSymbol(token.value);
     if (variable.symbolType == FJP::SymbolType::SYMBOL_NOT_FOUND) {
         // Process the label and return the function.
-        return processLabel(token.value);
+        return processLabel(std::string(token.value));
     }
 
     FJP::Symbol symbolIdentifier;
     std::string identifierName;
     std::list<std::string> identifiers;
+    int startExpression;
 
     switch (variable.symbolType) {
         // If the identifier is an integer or bool.
         case FJP::SymbolType::SYMBOL_INT:
         case FJP::SymbolType::SYMBOL_BOOL:
-            // ':='
+            // '+=', '-=', '*=', '++', '--'
             token = lexer->getNextToken();
+            if (processCompoundAssignment(variable)) {
+                break;
+            }
+
+            // ':='
             if (token.tokenType != FJP::TokenType::ASSIGN) {
                 FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_14, ERR_CODE, token.lineNumber);
             }
@@ -504,12 +557,17 @@ bool FJP::Parser::processAssignment(bool expectSemicolon) {
                 }
             }
             // <expression>
+            startExpression = generatedCode.getSize();
             processExpression();
 
+            // <identifier> := <identifier> <operator> <expression> updates the variable in place.
+            if (identifiers.empty() && generateInPlaceAssignment(variable, startExpression)) {
+                break;
+            }
+
             // If the identifier was a boolean, convert the result of the expression into 1/0.
             if (variable.symbolType == FJP::SymbolType::SYMBOL_BOOL) {
-                generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, 0 });
-                generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_NEQ });
+                generatedCode.addInstruction({FJP::OP_CODE::CMPI, FJP::OPRType::OPR_NEQ, 0});
             }
             generatedCode.addInstruction({ FJP::OP_CODE::STO, symbolTable.getDepthLevel() - variable.level, variable.address });
 
@@ -535,14 +593,10 @@ bool FJP::Parser::processAssignment(bool expectSemicolon) {
                 FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_17, ERR_CODE, token.lineNumber);
             }
 
-            // <expression>
+            // <expression> (the index of the element)
             token = lexer->getNextToken();
             processExpression();
 
-            // Calculate the address of the element in the array (base + offset).
-            generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, variable.address });
-            generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_PLUS });
-
             // ']'
             if (token.tokenType != FJP::TokenType::RIGHT_SQUARED_BRACKET) {
                 FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_16, ERR_CODE, token.lineNumber);
@@ -560,10 +614,9 @@ bool FJP::Parser::processAssignment(bool expectSemicolon) {
 
             // If the identifier was a boolean, convert the result of the expression into 1/0.
             if (variable.symbolType == FJP::SymbolType::SYMBOL_BOOL_ARRAY) {
-                generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, 0 });
-                generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_NEQ });
+                generatedCode.addInstruction({FJP::OP_CODE::CMPI, FJP::OPRType::OPR_NEQ, 0});
             }
-            generatedCode.addInstruction({FJP::OP_CODE::STA, symbolTable.getDepthLevel() - variable.level, 0});
+            generateArrayStore(variable);
             break;
         default:
             FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_29, ERR_CODE, token.lineNumber);
@@ -581,10 +634,49 @@ bool FJP::Parser::processAssignment(bool expectSemicolon) {
     return true;
 }
 
+// <identifier> += <expression> (also -=, *=)
+// <identifier>++ (also --)
+bool FJP::Parser::processCompoundAssignment(const FJP::Symbol &variable) {
+    FJP::TokenType type = token.tokenType;
+    FJP::OP_CODE op;
+    switch (type) {
+        case FJP::TokenType::PLUS_ASSIGN:
+        case FJP::TokenType::INCREMENT:
+            op = FJP::OP_CODE::ADDV;
+            break;
+        case FJP::TokenType::MINUS_ASSIGN:
+        case FJP::TokenType::DECREMENT:
+            op = FJP::OP_CODE::SUBV;
+            break;
+        case FJP::TokenType::MUL_ASSIGN:
+            op = FJP::OP_CODE::MULV;
+            break;
+        default:
+            return false;
+    }
+
+    // Only integers can be updated.
+    if (variable.symbolType != FJP::SymbolType::SYMBOL_INT) {
+        FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_29, ERR_CODE, token.lineNumber);
+    }
+
+    // '++' and '--' update the variable by one, the others by the value of the expression.
+    int start = generatedCode.getSize();
+    token = lexer->getNextToken();
+    if (type == FJP::TokenType::INCREMENT || type == FJP::TokenType::DECREMENT) {
+        generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, 1});
+    } else {
+        processExpression();
+    }
+    generateUpdate(op, variable, start);
+    return true;
+}
+
 // <identifier> :
 bool FJP::Parser::processLabel(const std::string label) {
     // We don't have to check if the name is already taken as it was done above.
     symbolTable.addSymbol({FJP::SymbolType::SYMBOL_LABEL, label, 0, 0, generatedCode.getSize(), 0});
+    lastLabelAddress = generatedCode.getSize();
 
     // ':'
     token = lexer->getNextToken();
@@ -685,13 +777,9 @@ bool FJP::Parser::processIf() {
     }
 
     // <condition>
-    token = lexer->getNextToken();
-    processCondition();
-
-    // Insert a JPC instruction (conditional jump).
     // If the result of the condition is false, we'll just skip the body of the if statement.
-    int currentInstruction1 = generatedCode.getSize();
-    generatedCode.addInstruction({FJP::OP_CODE::JPC, 0, 0});
+    token = lexer->getNextToken();
+    int currentInstruction1 = processCondition();
 
     // ')'
     if (token.tokenType != FJP::TokenType::RIGHT_PARENTHESIS) {
@@ -705,6 +793,7 @@ bool FJP::Parser::processIf() {
     // else
     if (token.tokenType == FJP::TokenType::ELSE) {
         // Add a JMP instruction, so we can skip the else branch in case the condition is satisfied.
+        generatedCode.setLineNumber(token.lineNumber);
         int currentInstruction2 = generatedCode.getSize();
         generatedCode.addInstruction({FJP::OP_CODE::JMP, 0, 0});
 
@@ -734,6 +823,7 @@ bool FJP::Parser::processWhile() {
 
     // Start address of the while loop.
     int startWhileLoop = generatedCode.getSize();
+    int lineNumber = token.lineNumber;
 
     // '('
     token = lexer->getNextToken();
@@ -742,24 +832,21 @@ bool FJP::Parser::processWhile() {
     }
 
     // <condition>
+    // The conditional jump skips the body of the while loop in case the condition is not satisfied.
     token = lexer->getNextToken();
-    processCondition();
-    int endOfWhileCondition = generatedCode.getSize();
+    int endOfWhileCondition = processCondition();
 
     // ')'
     if (token.tokenType != FJP::TokenType::RIGHT_PARENTHESIS) {
         FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_13, ERR_CODE, token.lineNumber);
     }
 
-    // Add a JPC instruction (conditional jump) in order to skip the body of the
-    // while loop in case the condition is not satisfied.
-    generatedCode.addInstruction({FJP::OP_CODE::JPC, 0, 0 });
-
     // <statement>
     token = lexer->getNextToken();
     processStatement();
 
     // Jump back to the condition of the while loop.
+    generatedCode.setLineNumber(lineNumber);
     generatedCode.addInstruction({FJP::OP_CODE::JMP, 0, startWhileLoop});
 
     // Set the target jump address of the JPC instruction (in order to skip the body of the loop).
@@ -796,6 +883,7 @@ bool FJP::Parser::processDoWhile() {
     if (token.tokenType != FJP::TokenType::WHILE) {
         FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_38, ERR_CODE, token.lineNumber);
     }
+    generatedCode.setLineNumber(token.lineNumber);
 
     // '('
     token = lexer->getNextToken();
@@ -804,14 +892,10 @@ bool FJP::Parser::processDoWhile() {
     }
 
     // <condition>
-    token = lexer->getNextToken();
-    processCondition();
-
     // If the result of condition is true (1) jump to the first address
     // of the body of the do-while loop.
-    generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, 0});
-    generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_EQ});
-    generatedCode.addInstruction({FJP::OP_CODE::JPC, 0, doWhileStart });
+    token = lexer->getNextToken();
+    generatedCode[processCondition(true)].m = doWhileStart;
 
     // ')'
     if (token.tokenType != FJP::TokenType::RIGHT_PARENTHESIS) {
@@ -859,6 +943,7 @@ bool FJP::Parser::processRepeatUntil() {
     if (token.tokenType != FJP::TokenType::UNTIL) {
         FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_39, ERR_CODE, token.lineNumber);
     }
+    generatedCode.setLineNumber(token.lineNumber);
 
     // '('
     token = lexer->getNextToken();
@@ -867,12 +952,10 @@ bool FJP::Parser::processRepeatUntil() {
     }
 
     // <condition>
-    token = lexer->getNextToken();
-    processCondition();
-
     // If the result of condition is false (0) jump to the first address
     // of the body of the repeat-until loop.
-    generatedCode.addInstruction({FJP::OP_CODE::JPC, 0, repeatUntilStart });
+    token = lexer->getNextToken();
+    generatedCode[processCondition()].m = repeatUntilStart;
 
     // ')'
     if (token.tokenType != FJP::TokenType::RIGHT_PARENTHESIS) {
@@ -896,6 +979,7 @@ bool FJP::Parser::processForeach() {
     if (token.tokenType != FJP::TokenType::FOREACH) {
         return false;
     }
+    int lineNumber = token.lineNumber;
 
     // '('
     token = lexer->getNextToken();
@@ -981,35 +1065,28 @@ bool FJP::Parser::processForeach() {
     int startForeachBody = generatedCode.getSize();
 
     // Check if we have just reached the end of the array (current index == array.size).
-    generatedCode.addInstruction({FJP::OP_CODE::LOD, 0, indexAddress});
-    generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, dataArray.size});
-    generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_NEQ});
-
     // Skip the body of the foreach loop if the end of the array has been reached.
+    generatedCode.addInstruction({FJP::OP_CODE::LOD, 0, indexAddress});
     int exitForeachAddress = generatedCode.getSize();
-    generatedCode.addInstruction({FJP::OP_CODE::JPC, 0, 0});
+    generatedCode.addInstruction({FJP::OP_CODE::JEQI, dataArray.size, 0});
 
     // Load array[index] to the top of the stack. We need to take the base address
     // of the array and add the current index to it, so we get the address of
     // the current element.
     generatedCode.addInstruction({FJP::OP_CODE::LOD, 0, indexAddress});
-    generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, dataArray.address});
-    generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_PLUS});
-    generatedCode.addInstruction({FJP::OP_CODE::LDA, symbolTable.getDepthLevel() - dataArray.level, 0});
+    generateArrayLoad(dataArray);
 
     // Store the value (array[index]) into the iterator.
     generatedCode.addInstruction({FJP::OP_CODE::STO, symbolTable.getDepthLevel() - iterVariable.level, iterVariable.address});
 
     // Increment the current index (moving on to the next element).
-    generatedCode.addInstruction({FJP::OP_CODE::LOD, 0, indexAddress});
-    generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, 1});
-    generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_PLUS});
-    generatedCode.addInstruction({FJP::OP_CODE::STO, 0, indexAddress});
+    generatedCode.addInstruction({FJP::OP_CODE::ADDVI, 0, generatedCode.addVariableUpdate({0, indexAddress, 1})});
 
     // <statement>
     processStatement();
 
     // Jump to the incrementation part of the loop (index++).
+    generatedCode.setLineNumber(lineNumber);
     generatedCode.addInstruction({FJP::OP_CODE::JMP, 0, startForeachBody});
 
     // Set the address to jump to in case the condition is not satisfied (end of the foreach loop).
@@ -1017,6 +1094,12 @@ bool FJP::Parser::processForeach() {
 
     // Remove the temporary variable (index) off the stack.
     generatedCode.addInstruction({FJP::OP_CODE::INC, 0, -1});
+
+    // If the loop is a simple reduction of the array, put a vector instruction in front of it.
+    // A label within the loop would not move along with the inserted instructions, so such a loop is left alone.
+    if (lastLabelAddress < startForeachBody - 2) {
+        vectorizer.vectorizeForeach(generatedCode, startForeachBody - 2, indexAddress);
+    }
     return true;
 }
 
@@ -1026,6 +1109,7 @@ bool FJP::Parser::processFor() {
     if (token.tokenType != FJP::TokenType::FOR) {
         return false;
     }
+    int lineNumber = token.lineNumber;
 
     // '('
     token = lexer->getNextToken();
@@ -1041,13 +1125,11 @@ bool FJP::Parser::processFor() {
     int startCondition = generatedCode.getSize();
 
     // <condition>
-    processCondition();
-
-    // Generate a JPC instruction to skip the body of the for loop if the
-    // condition is not satisfied. Also, create a JMP instruction in order to
-    // skip the incrementation part of the for loop - we need to jump straight
+    // The conditional jump skips the body of the for loop if the condition
+    // is not satisfied. Also, create a JMP instruction in order to skip
+    // the incrementation part of the for loop - we need to jump straight
     // to the body of the loop.
-    generatedCode.addInstruction({FJP::OP_CODE::JPC, 0, 0 });
+    int exitForAddress = processCondition();
     generatedCode.addInstruction({FJP::OP_CODE::JMP, 0, 0});
 
     // Store the start address of the update part of the for loop (e.g. i++).
@@ -1078,13 +1160,20 @@ bool FJP::Parser::processFor() {
     processStatement();
 
     // Once the body has been executed, jump straight to the update part (incrementation part).
+    generatedCode.setLineNumber(lineNumber);
     generatedCode.addInstruction({FJP::OP_CODE::JMP, 0, startUpdatePart});
 
     // Set the address to jump to in case the condition isn't satisfied (end of the loop).
-    generatedCode[startUpdatePart - 2].m = generatedCode.getSize();
+    generatedCode[exitForAddress].m = generatedCode.getSize();
 
     // Set the address to jump to after the condition has been processed (the body of the for loop).
     generatedCode[startUpdatePart - 1].m = endUpdatePart;
+
+    // If the loop is a simple loop over arrays, put a vector instruction in front of it.
+    // A label within the loop would not move along with the inserted instructions, so such a loop is left alone.
+    if (lastLabelAddress < startCondition) {
+        vectorizer.vectorizeFor(generatedCode, startCondition);
+    }
     return true;
 }
 
@@ -1094,6 +1183,9 @@ bool FJP::Parser::processSwitch() {
     // once the end address is known (the end of the switch statement).
     std::list<int> breaks;
 
+    // Case values mapped onto the addresses of their bodies.
+    std::map<int, int> cases;
+
     // switch
     if (token.tokenType != FJP::TokenType::SWITCH) {
         return false;
@@ -1129,9 +1221,15 @@ bool FJP::Parser::processSwitch() {
         FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_18, ERR_CODE, token.lineNumber);
     }
 
+    // Dispatch the switch statement by the value of the variable. The jump table
+    // is built once all cases have been processed (their addresses are known).
+    generatedCode.addInstruction({FJP::OP_CODE::LOD, symbolTable.getDepthLevel() - variable.level, variable.address});
+    int jtb_address = generatedCode.getSize();
+    generatedCode.addInstruction({FJP::OP_CODE::JTB, 0, 0});
+
     // <cases>
     token = lexer->getNextToken();
-    processCases(variable, breaks);
+    processCases(variable, breaks, cases);
 
     // '}'
     if (token.tokenType != FJP::TokenType::RIGHT_CURLY_BRACKET) {
@@ -1144,85 +1242,120 @@ bool FJP::Parser::processSwitch() {
         generatedCode[item].m = generatedCode.getSize();
     }
 
+    // If no case matches the value of the variable, jump onto the end of the switch statement.
+    generatedCode[jtb_address].m = addJumpTable(cases, generatedCode.getSize());
+
     // Load up the next token, so it can be processed.
     token = lexer->getNextToken();
     return true;
 }
 
 
-// case <literal> : <statement> (<break>;)?
-void FJP::Parser::processCases(Symbol &variable, std::list<int> &breaks) {
+// (case <literal> : <statement> (<break>;)?)*
+void FJP::Parser::processCases(Symbol &variable, std::list<int> &breaks, std::map<int, int> &cases) {
+    bool firstCase = true;
+
     // case
-    if (token.tokenType != FJP::TokenType::CASE) {
-        return;
-    }
+    while (token.tokenType == FJP::TokenType::CASE) {
+        generatedCode.setLineNumber(token.lineNumber);
 
-    // Check if the token is indeed a literal (number, true, false).
-    token = lexer->getNextToken();
-    int token_value;
-    if (token.tokenType != FJP::TokenType::NUMBER &&
-        token.tokenType != FJP::TokenType::TRUE &&
-        token.tokenType != FJP::TokenType::FALSE) {
-        FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_34, ERR_CODE, token.lineNumber);
-    }
+        // Check if the token is indeed a literal (number, true, false).
+        token = lexer->getNextToken();
+        int token_value;
+        if (token.tokenType != FJP::TokenType::NUMBER &&
+            token.tokenType != FJP::TokenType::TRUE &&
+            token.tokenType != FJP::TokenType::FALSE) {
+            FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_34, ERR_CODE, token.lineNumber);
+        }
 
-    // Parse the literal. If it is a number, convert it into an integer, and if
-    // it is a boolean, convert it into 1/0.
-    if (token.tokenType == FJP::TokenType::NUMBER) {
-        token_value = atoi(token.value.c_str());
-    } else {
-        token_value = token.value == "true";
-    }
+        // Parse the literal. If it is a number, convert it into an integer, and if
+        // it is a boolean, convert it into 1/0.
+        if (token.tokenType == FJP::TokenType::NUMBER) {
+            token_value = token.number;
+        } else {
+            token_value = token.value == "true";
+        }
 
-    // Make sure the literal is the same datatype as the variable used in the switch statement.
-    if (((variable.symbolType == SYMBOL_INT) && token.tokenType != NUMBER) ||
-        ((variable.symbolType == SYMBOL_BOOL) && !(token.tokenType == TRUE || token.tokenType == FALSE))) {
-        FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_35, ERR_CODE, token.lineNumber);
-    }
+        // Make sure the literal is the same datatype as the variable used in the switch statement.
+        if (((variable.symbolType == SYMBOL_INT) && token.tokenType != NUMBER) ||
+            ((variable.symbolType == SYMBOL_BOOL) && !(token.tokenType == TRUE || token.tokenType == FALSE))) {
+            FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_35, ERR_CODE, token.lineNumber);
+        }
 
-    // ':'
-    token = lexer->getNextToken();
-    if (token.tokenType != FJP::TokenType::COLON) {
-        FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_11, ERR_CODE, token.lineNumber);
-    }
+        // ':'
+        token = lexer->getNextToken();
+        if (token.tokenType != FJP::TokenType::COLON) {
+            FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_11, ERR_CODE, token.lineNumber);
+        }
 
-    // Compare the literal against the variable used in the switch statement.
-    generatedCode.addInstruction({FJP::OP_CODE::LOD, symbolTable.getDepthLevel() - variable.level, variable.address});
-    generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, token_value});
-    generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_EQ});
+        // The JTB instruction jumps straight onto the body of the first case matching the variable.
+        // The literal has to be compared against the variable only when the body of the previous
+        // case (with no break) falls through onto this case. The first case has no previous case.
+        int jpc_address = -1;
+        if (firstCase == false) {
+            // If it doesn't match up, skip the body of the case statement and jump onto the next case.
+            generatedCode.addInstruction({FJP::OP_CODE::LOD, symbolTable.getDepthLevel() - variable.level, variable.address});
+            jpc_address = generatedCode.getSize();
+            generatedCode.addInstruction({FJP::OP_CODE::JNEI, token_value, 0});
+        }
+        firstCase = false;
 
-    // If it doesn't match up, skip the body of the case statement and jump onto the next case.
-    int jpc_address = generatedCode.getSize();
-    generatedCode.addInstruction({FJP::OP_CODE::JPC, 0, 0});
+        // Only the first case of the same value can ever be dispatched to.
+        cases.emplace(token_value, generatedCode.getSize());
 
-    // <statement>
-    token = lexer->getNextToken();
-    processStatement();
+        // <statement>
+        token = lexer->getNextToken();
+        processStatement();
 
-    // Set the jump address to jump to in case the literal doesn't mach the value of the variable
-    // used in the switch statement (jump onto the next case).
-    generatedCode[jpc_address].m = generatedCode.getSize();
+        // <break>
+        if (token.tokenType == FJP::TokenType::BREAK) {
+            // Add the address of the break statement to the list of all breaks.
+            // The jump address will be known after the entire switch has been processed.
+            generatedCode.setLineNumber(token.lineNumber);
+            breaks.push_back(generatedCode.getSize());
+            generatedCode.addInstruction({FJP::OP_CODE::JMP, 0, 0});
 
-    // <break>
-    if (token.tokenType == FJP::TokenType::BREAK) {
-        // Add the address of the break statement to the list of all breaks.
-        // The jump address will be known after the entire switch has been processed.
-        breaks.push_back(generatedCode.getSize());
-        generatedCode.addInstruction({FJP::OP_CODE::JMP, 0, 0});
+            // ';'
+            token = lexer->getNextToken();
+            if (token.tokenType != FJP::TokenType::SEMICOLON) {
+                FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_15, ERR_CODE, token.lineNumber);
+            }
+            token = lexer->getNextToken();
+        }
 
-        // ';'
-        token = lexer->getNextToken();
-        if (token.tokenType != FJP::TokenType::SEMICOLON) {
-            FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_15, ERR_CODE, token.lineNumber);
+        // Set the jump address to jump to in case the literal doesn't mach the value of the variable
+        // used in the switch statement (jump onto the next case, skipping the break if there is one).
+        if (jpc_address != -1) {
+            generatedCode[jpc_address].m = generatedCode.getSize();
         }
+    }
+}
 
-        // Also, we need to skip the break itself in case we're jumping onto the next case.
-        token = lexer->getNextToken();
-        generatedCode[jpc_address].m++;
+int FJP::Parser::addJumpTable(const std::map<int, int> &cases, int defaultTarget) {
+    FJP::JumpTable table = {false, 0, {}, {}, defaultTarget};
+    if (cases.empty()) {
+        return generatedCode.addJumpTable(table);
+    }
+
+    // If the values are compact enough, every value within their range gets a slot of the table.
+    int64_t low = cases.begin()->first;
+    int64_t high = cases.rbegin()->first;
+    if (high - low + 1 <= static_cast<int64_t>(cases.size()) * JUMP_TABLE_DENSITY) {
+        table.dense = true;
+        table.low = static_cast<int>(low);
+        table.targets.assign(static_cast<size_t>(high - low + 1), defaultTarget);
+        for (const auto &item : cases) {
+            table.targets[item.first - low] = item.second;
+        }
+        return generatedCode.addJumpTable(table);
     }
 
-    // Process the next statement.
-    processCases(variable, breaks);
+    // Otherwise, only the case values are stored (in ascending order, as they are kept in the map).
+    for (const auto &item : cases) {
+        table.values.push_back(item.first);
+        table.targets.push_back(item.second);
+    }
+    return generatedCode.addJumpTable(table);
 }
 
 // goto <identifier> ;
@@ -1245,7 +1378,7 @@ bool FJP::Parser::processGoto() {
     // of labels that are still yet be declared (later on).
     // If the identifier is found, make sure its type is label.
     if (symbol.symbolType == FJP::SymbolType::SYMBOL_NOT_FOUND) {
-        undefinedLabels[token.value].push_back(generatedCode.getSize());
+        undefinedLabels[std::string(token.value)].push_back(generatedCode.getSize());
     } else if (symbol.symbolType != FJP::SymbolType::SYMBOL_LABEL) {
         FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_33, ERR_CODE, token.lineNumber);
     }
@@ -1273,85 +1406,83 @@ bool FJP::Parser::processGoto() {
 // <expression> => <expression>
 // <expression> && <expression>
 // <expression> || <expression>
-void FJP::Parser::processCondition() {
+int FJP::Parser::processCondition(bool jumpIfTrue) {
     // '!'
     if (token.tokenType == FJP::TokenType::EXCLAMATION_MARK) {
         // <expression>
         token = lexer->getNextToken();
         processExpression();
 
-        // Compare the result of the expression to 0, and store the result
-        // of the comparison on the top of the stack.
+        // Compare the result of the expression to 0.
+        int startZero = generatedCode.getSize();
         generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, 0});
-        generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_EQ});
-    } else {
-        // <expression>
-        processExpression();
+        return generateBranch(FJP::OPRType::OPR_EQ, jumpIfTrue, startZero);
+    }
 
-        FJP::OPRType instructionType = FJP::OPRType::OPR_RET;
-        FJP::TokenType logicalOperation = FJP::TokenType::UNKNOWN;
-        switch (token.tokenType) {
-            // '=='
-            case FJP::TokenType::EQUALS:
-                instructionType = FJP::OPRType::OPR_EQ;
-                break;
-            // '!='
-            case FJP::TokenType::NOT_EQUALS:
-                instructionType = FJP::OPRType::OPR_NEQ;
-                break;
-            // '<'
-            case FJP::TokenType::LESS:
-                instructionType = FJP::OPRType::OPR_LESS;
-                break;
-            // '<='
-            case FJP::TokenType::LESS_OR_EQUAL:
-                instructionType = FJP::OPRType::OPR_LESS_EQ;
-                break;
-            // '>'
-            case FJP::TokenType::GREATER:
-                instructionType = FJP::OPRType::OPR_GRT;
-                break;
-            // '>='
-            case FJP::TokenType::GREATER_OR_EQUAL:
-                instructionType = FJP::OPRType::OPR_GRT_EQ;
-                break;
-            // '&&'
-            case FJP::TokenType::LOGICAL_AND:
-            // '||'
-            case FJP::TokenType::LOGICAL_OR:
-                logicalOperation = token.tokenType;
-                break;
-            default:
-                FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_28, ERR_CODE, token.lineNumber);
-        }
+    // <expression>
+    processExpression();
 
-        // <expression>
-        token = lexer->getNextToken();
-        processExpression();
+    FJP::OPRType instructionType = FJP::OPRType::OPR_RET;
+    FJP::TokenType logicalOperation = FJP::TokenType::UNKNOWN;
+    switch (token.tokenType) {
+        // '=='
+        case FJP::TokenType::EQUALS:
+            instructionType = FJP::OPRType::OPR_EQ;
+            break;
+        // '!='
+        case FJP::TokenType::NOT_EQUALS:
+            instructionType = FJP::OPRType::OPR_NEQ;
+            break;
+        // '<'
+        case FJP::TokenType::LESS:
+            instructionType = FJP::OPRType::OPR_LESS;
+            break;
+        // '<='
+        case FJP::TokenType::LESS_OR_EQUAL:
+            instructionType = FJP::OPRType::OPR_LESS_EQ;
+            break;
+        // '>'
+        case FJP::TokenType::GREATER:
+            instructionType = FJP::OPRType::OPR_GRT;
+            break;
+        // '>='
+        case FJP::TokenType::GREATER_OR_EQUAL:
+            instructionType = FJP::OPRType::OPR_GRT_EQ;
+            break;
+        // '&&'
+        case FJP::TokenType::LOGICAL_AND:
+        // '||'
+        case FJP::TokenType::LOGICAL_OR:
+            logicalOperation = token.tokenType;
+            break;
+        default:
+            FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_28, ERR_CODE, token.lineNumber);
+    }
 
-        // Based on the type of comparison, person an operation
-        // wit the two values (the results of the two expressions)
-        // on the top of the stack. The result is going to be 1/0.
-        switch (logicalOperation) {
-            // If the operation is something other than '&&' or '||'.
-            case FJP::TokenType::UNKNOWN:
-                generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, instructionType});
-                break;
-            // '&&' - it needs to be done only by the operations supported by PL0
-            case FJP::TokenType::LOGICAL_AND:
-                generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_MUL});
-                generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, 0});
-                generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_NEQ});
-                break;
-            // '||' - it needs to be done only by the operations supported by PL0
-            case FJP::TokenType::LOGICAL_OR:
-                generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_PLUS});
-                generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, 0});
-                generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_NEQ});
-                break;
-            default:
-                break;
-        }
+    // <expression>
+    token = lexer->getNextToken();
+    int startExpression = generatedCode.getSize();
+    processExpression();
+
+    // Based on the type of comparison, compare the two values (the results
+    // of the two expressions) on the top of the stack and jump accordingly.
+    int startZero;
+    switch (logicalOperation) {
+        // '&&' - it needs to be done only by the operations supported by PL0
+        case FJP::TokenType::LOGICAL_AND:
+            generateOperation(FJP::OPRType::OPR_MUL, startExpression);
+            startZero = generatedCode.getSize();
+            generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, 0});
+            return generateBranch(FJP::OPRType::OPR_NEQ, jumpIfTrue, startZero);
+        // '||' - it needs to be done only by the operations supported by PL0
+        case FJP::TokenType::LOGICAL_OR:
+            generateOperation(FJP::OPRType::OPR_PLUS, startExpression);
+            startZero = generatedCode.getSize();
+            generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, 0});
+            return generateBranch(FJP::OPRType::OPR_NEQ, jumpIfTrue, startZero);
+        // If the operation is something other than '&&' or '||'.
+        default:
+            return generateBranch(instructionType, jumpIfTrue, startExpression);
     }
 }
 
@@ -1360,7 +1491,7 @@ void FJP::Parser::processCondition() {
 void FJP::Parser::processTernaryOperator() {
     // <condition>
     token = lexer->getNextToken();
-    processCondition();
+    int jpcInstructionAddress = processCondition();
 
     // '?'
     if (token.tokenType != FJP::TokenType::QUESTION_MARK) {
@@ -1369,7 +1500,7 @@ void FJP::Parser::processTernaryOperator() {
 
     // Add JMP instructions, so we can jump to the appropriate
     // expression based on the result of the condition.
-    generatedCode.addInstruction({FJP::OP_CODE::JPC, 0, generatedCode.getSize() + 2});
+    generatedCode[jpcInstructionAddress].m = jpcInstructionAddress + 2;
     int jmpInstructionAddress = generatedCode.getSize();
     generatedCode.addInstruction({FJP::OP_CODE::JMP, 0, 0});
     int jmp2InstructionAddress = generatedCode.getSize();
@@ -1427,17 +1558,18 @@ void FJP::Parser::processExpression() {
 
         // <term>
         token = lexer->getNextToken();
+        int startTerm = generatedCode.getSize();
         processTerm();
 
         // Add instruction to cary out the operation on top of the stack.
         switch (currTokenType) {
             // '+'
             case FJP::TokenType::PLUS:
-                generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_PLUS});
+                generateOperation(FJP::OPRType::OPR_PLUS, startTerm);
                 break;
             // '-'
             case FJP::TokenType::MINUS:
-                generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_MINUS});
+                generateOperation(FJP::OPRType::OPR_MINUS, startTerm);
                 break;
             default:
                 break;
@@ -1458,17 +1590,18 @@ void FJP::Parser::processTerm() {
 
         // <factor>
         token = lexer->getNextToken();
+        int startFactor = generatedCode.getSize();
         processFactor();
 
         // Add instruction to perform the operation on the top of the stack.
         switch (currTokenType) {
             // '*'
             case FJP::TokenType::ASTERISK:
-                generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_MUL});
+                generateOperation(FJP::OPRType::OPR_MUL, startFactor);
                 break;
             // '/'
             case FJP::TokenType::SLASH:
-                generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_DIV});
+                generateOperation(FJP::OPRType::OPR_DIV, startFactor);
                 break;
             default:
                 break;
@@ -1545,12 +1678,9 @@ void FJP::Parser::processFactor() {
                         token = lexer->getNextToken();
                         processExpression();
 
-                        // Calculate the address of the element within the array. Add up the base address and the index.
-                        generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, symbol.address});
-                        generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_PLUS});
-
-                        // Load the value to the top of the stack.
-                        generatedCode.addInstruction({FJP::OP_CODE::LDA, symbolTable.getDepthLevel() - symbol.level, 0});
+                        // Calculate the address of the element within the array (base + index)
+                        // and load the value to the top of the stack.
+                        generateArrayLoad(symbol);
 
                         // ']'
                         if (token.tokenType != FJP::TokenType::RIGHT_SQUARED_BRACKET) {
@@ -1566,7 +1696,7 @@ void FJP::Parser::processFactor() {
             break;
         // <number>
         case FJP::TokenType::NUMBER:
-            numberValue = atoi(token.value.c_str());
+            numberValue = token.number;
             generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, numberValue});
             break;
         // <true/false>
@@ -1627,10 +1757,9 @@ bool FJP::Parser::processRead() {
         // bool
         case FJP::SymbolType::SYMBOL_BOOL:
             generatedCode.addInstruction({FJP::OP_CODE::SIO, 0, FJP::SIO_TYPE::SIO_READ});
-            generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, 0 });
 
             // Convert an integer into a boolean (1/0).
-            generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_NEQ });
+            generatedCode.addInstruction({FJP::OP_CODE::CMPI, FJP::OPRType::OPR_NEQ, 0});
             generatedCode.addInstruction({FJP::OP_CODE::STO, symbolTable.getDepthLevel() - symbol.level, symbol.address});
             break;
         // array
@@ -1646,19 +1775,16 @@ bool FJP::Parser::processRead() {
             token = lexer->getNextToken();
             processExpression();
 
-            // Calculate the address of the element (base + offset).
-            generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, symbol.address });
-            generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_PLUS });
+            // The index of the element stays below the value being read.
             generatedCode.addInstruction({FJP::OP_CODE::SIO, 0, FJP::SIO_TYPE::SIO_READ});
 
             // If it is an array of booleans, interpret the numbers as booleans (1/0).
             if (symbol.symbolType == FJP::SymbolType::SYMBOL_BOOL_ARRAY) {
-                generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, 0 });
-                generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_NEQ });
+                generatedCode.addInstruction({FJP::OP_CODE::CMPI, FJP::OPRType::OPR_NEQ, 0});
             }
 
             // ']'
-            generatedCode.addInstruction({FJP::OP_CODE::STA, symbolTable.getDepthLevel() - symbol.level, 0});
+            generateArrayStore(symbol);
             if (token.tokenType != FJP::TokenType::RIGHT_SQUARED_BRACKET) {
                 FJP::exitProgramWithError(__FUNCTION__, FJP::CompilationErrors::ERROR_16, ERR_CODE, token.lineNumber);
             }
@@ -1730,10 +1856,8 @@ bool FJP::Parser::processWrite() {
                     token = lexer->getNextToken();
                     processExpression();
 
-                    // Calculate the address of the element (base + offset).
-                    generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, symbol.address});
-                    generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, FJP::OPRType::OPR_PLUS});
-                    generatedCode.addInstruction({FJP::OP_CODE::LDA, symbolTable.getDepthLevel() - symbol.level, 0});
+                    // Calculate the address of the element (base + offset) and load it.
+                    generateArrayLoad(symbol);
 
                     // ']'
                     if (token.tokenType != FJP::TokenType::RIGHT_SQUARED_BRACKET) {
@@ -1751,7 +1875,7 @@ bool FJP::Parser::processWrite() {
             break;
         // <number>
         case FJP::TokenType::NUMBER:
-            number = atoi(token.value.c_str());
+            number = token.number;
             generatedCode.addInstruction({FJP::OP_CODE::LIT, 0, number});
             break;
         // <true/false>
@@ -1782,4 +1906,172 @@ bool FJP::Parser::processWrite() {
     // Load up the next token, so it can be processed.
     token = lexer->getNextToken();
     return true;
-}
\ No newline at end of file
+}
+
+void FJP::Parser::generateOperation(FJP::OPRType type, int start) {
+    // The second operand is a constant if it is made up of a single LIT instruction.
+    int last = generatedCode.getSize() - 1;
+    bool constant = last == start && generatedCode[last].op == FJP::OP_CODE::LIT;
+
+    switch (type) {
+        // x + <constant>
+        case FJP::OPRType::OPR_PLUS:
+            if (constant) {
+                generatedCode[last] = {FJP::OP_CODE::ADDI, 0, generatedCode[last].m};
+                return;
+            }
+            break;
+        // x - <constant>
+        case FJP::OPRType::OPR_MINUS:
+            if (constant) {
+                generatedCode[last] = {FJP::OP_CODE::SUBI, 0, generatedCode[last].m};
+                return;
+            }
+            break;
+        // x * <constant>
+        case FJP::OPRType::OPR_MUL:
+            if (constant) {
+                generatedCode[last] = {FJP::OP_CODE::MULI, 0, generatedCode[last].m};
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+    generatedCode.addInstruction({FJP::OP_CODE::OPR, 0, type});
+}
+
+void FJP::Parser::generateUpdate(FJP::OP_CODE op, const FJP::Symbol &variable, int start) {
+    int level = symbolTable.getDepthLevel() - variable.level;
+    int last = generatedCode.getSize() - 1;
+
+    // The value is a constant if it is made up of a single LIT instruction.
+    // The immediate forms are ordered the same way as the stack ones.
+    if (last == start && generatedCode[last].op == FJP::OP_CODE::LIT) {
+        int index = generatedCode.addVariableUpdate({level, variable.address, generatedCode[last].m});
+        generatedCode[last] = {static_cast<FJP::OP_CODE>(FJP::OP_CODE::ADDVI + (op - FJP::OP_CODE::ADDV)), 0, index};
+        return;
+    }
+    generatedCode.addInstruction({op, level, variable.address});
+}
+
+bool FJP::Parser::generateInPlaceAssignment(const FJP::Symbol &variable, int start) {
+    int last = generatedCode.getSize() - 1;
+    if (variable.symbolType != FJP::SymbolType::SYMBOL_INT || last <= start) {
+        return false;
+    }
+
+    // The expression has to start with loading the variable itself.
+    const FJP::Instruction &first = generatedCode[start];
+    if (first.op != FJP::OP_CODE::LOD || first.l != symbolTable.getDepthLevel() - variable.level || first.m != variable.address) {
+        return false;
+    }
+
+    // ... followed by the other operand and the operation itself. If the operand is a constant, it has
+    // been merged into an instruction with an immediate operand, which is turned back into the constant.
+    FJP::Instruction &operation = generatedCode[last];
+    FJP::OP_CODE op;
+    if (operation.op == FJP::OP_CODE::ADDI || operation.op == FJP::OP_CODE::SUBI || operation.op == FJP::OP_CODE::MULI) {
+        if (last != start + 1) {
+            return false;
+        }
+        op = static_cast<FJP::OP_CODE>(FJP::OP_CODE::ADDV + (operation.op - FJP::OP_CODE::ADDI));
+        operation = {FJP::OP_CODE::LIT, 0, operation.m};
+    } else if (operation.op == FJP::OP_CODE::OPR && isSingleValue(start + 1, last)) {
+        switch (operation.m) {
+            case FJP::OPRType::OPR_PLUS:
+                op = FJP::OP_CODE::ADDV;
+                break;
+            case FJP::OPRType::OPR_MINUS:
+                op = FJP::OP_CODE::SUBV;
+                break;
+            case FJP::OPRType::OPR_MUL:
+                op = FJP::OP_CODE::MULV;
+                break;
+            default:
+                return false;
+        }
+        generatedCode.removeInstruction(last);
+    } else {
+        return false;
+    }
+
+    // Drop the load of the variable, so only the other operand is left on the stack.
+    generatedCode.removeInstruction(start);
+    generateUpdate(op, variable, start);
+    return true;
+}
+
+bool FJP::Parser::isSingleValue(int start, int end) const {
+    int depth = 0;
+    for (int i = start; i < end; i++) {
+        const FJP::Instruction &instruction = generatedCode[i];
+        int pops;
+        switch (instruction.op) {
+            case FJP::OP_CODE::LIT:
+            case FJP::OP_CODE::LOD:
+                pops = 0;
+                break;
+            case FJP::OP_CODE::ADDI:
+            case FJP::OP_CODE::SUBI:
+            case FJP::OP_CODE::MULI:
+            case FJP::OP_CODE::CMPI:
+            case FJP::OP_CODE::LDA:
+            case FJP::OP_CODE::LDD:
+            case FJP::OP_CODE::LDX:
+                pops = 1;
+                break;
+            case FJP::OP_CODE::OPR:
+                pops = instruction.m == FJP::OPRType::OPR_INVERT_VALUE || instruction.m == FJP::OPRType::OPR_ODD ? 1 : 2;
+                break;
+            default:
+                // Anything else (e.g. a jump) is not a plain calculation.
+                return false;
+        }
+
+        // The instruction would use a value placed below the range.
+        if (depth < pops) {
+            return false;
+        }
+        depth = depth - pops + 1;
+    }
+    return depth == 1;
+}
+
+int FJP::Parser::generateBranch(int comparison, bool jumpIfTrue, int start) {
+    // The instruction jumps if the comparison holds, so it may need to be negated.
+    if (jumpIfTrue == false) {
+        comparison = FJP::negate_comparison(comparison);
+    }
+
+    // If the second operand is a constant (a single LIT instruction), compare against it directly.
+    int last = generatedCode.getSize() - 1;
+    if (last == start && generatedCode[last].op == FJP::OP_CODE::LIT) {
+        generatedCode[last] = {FJP::branch_on(comparison, true), generatedCode[last].m, 0};
+        return last;
+    }
+    generatedCode.addInstruction({FJP::branch_on(comparison, false), 0, 0});
+    return generatedCode.getSize() - 1;
+}
+
+void FJP::Parser::generateArrayLoad(const FJP::Symbol &array) {
+    // LDD size base - the size is used by the VM to check the bounds of the array.
+    if (array.inDataSegment) {
+        generatedCode.addInstruction({FJP::OP_CODE::LDD, array.size, array.address});
+        return;
+    }
+    // LDX level base - the size is kept aside, so the VM can check the bounds of the array if asked to.
+    generatedCode.setArraySize(generatedCode.getSize(), array.size);
+    generatedCode.addInstruction({FJP::OP_CODE::LDX, symbolTable.getDepthLevel() - array.level, array.address});
+}
+
+void FJP::Parser::generateArrayStore(const FJP::Symbol &array) {
+    // STD size base - the size is used by the VM to check the bounds of the array.
+    if (array.inDataSegment) {
+        generatedCode.addInstruction({FJP::OP_CODE::STD, array.size, array.address});
+        return;
+    }
+    // STX level base - the size is kept aside, so the VM can check the bounds of the array if asked to.
+    generatedCode.setArraySize(generatedCode.getSize(), array.size);
+    generatedCode.addInstruction({FJP::OP_CODE::STX, symbolTable.getDepthLevel() - array.level, array.address});
+}
@@ -0,0 +1,188 @@
+#include <map>
+#include <fstream>
+#include <iomanip>
+
+#if defined(__unix__) || defined(__APPLE__)
+# include <csignal>
+# include <sys/time.h>
+# define SAMPLING_SUPPORTED
+#endif
+
+#include <sampling_profiler.h>
+#include <errors.h>
+
+FJP::SamplingProfiler *FJP::SamplingProfiler::instance = nullptr;
+
+FJP::SamplingProfiler* FJP::SamplingProfiler::getInstance() {
+    if (instance == nullptr) {
+        instance = new SamplingProfiler;
+    }
+    return instance;
+}
+
+FJP::SamplingProfiler::SamplingProfiler() : sampleCount(0), droppedCount(0), publishedEIP(0), activeFrames(0), publishedEBP(-1), stackMemory(nullptr), stackSize(0) {
+    for (auto &chain : frames) {
+        chain.depth = 1;
+    }
+}
+
+void FJP::SamplingProfiler::start(const int *stack, int size) {
+    stackMemory = stack;
+    stackSize = size;
+
+    // Nothing has been published yet, the first instruction publishes the chain of frames.
+    publishedEIP = 0;
+    publishedEBP = -1;
+    for (auto &chain : frames) {
+        chain.depth = 1;
+    }
+
+    // Allocate the whole buffer up front, so the signal handler never allocates memory.
+    samples.resize(MAX_SAMPLES);
+    sampleCount = 0;
+    droppedCount = 0;
+
+#ifdef SAMPLING_SUPPORTED
+    // Install the signal handler. SA_RESTART makes sure reading the
+    // input of the program (read) is not interrupted by the timer.
+    struct sigaction action {};
+    action.sa_handler = &SamplingProfiler::handleSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, nullptr);
+
+    // Start the timer measuring the CPU time of the process.
+    struct itimerval timer {};
+    timer.it_interval.tv_usec = SAMPLE_INTERVAL_US;
+    timer.it_value.tv_usec = SAMPLE_INTERVAL_US;
+    setitimer(ITIMER_PROF, &timer, nullptr);
+#endif
+}
+
+void FJP::SamplingProfiler::stop() {
+#ifdef SAMPLING_SUPPORTED
+    // Stop the timer and restore the default signal handler.
+    struct itimerval timer {};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    signal(SIGPROF, SIG_DFL);
+#endif
+}
+
+void FJP::SamplingProfiler::handleSignal(int signal) {
+    // Just so the compiler doesn't complain about an unused value.
+    (void)signal;
+
+    if (instance != nullptr) {
+        instance->takeSample();
+    }
+}
+
+void FJP::SamplingProfiler::takeSample() {
+    // Reserve a slot in the buffer. If it's full, just count the sample as dropped.
+    int index = sampleCount.fetch_add(1, std::memory_order_relaxed);
+    if (index >= MAX_SAMPLES) {
+        sampleCount.store(MAX_SAMPLES, std::memory_order_relaxed);
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // The instruction pointer always refers to the function of the current frame
+    // (after a call, it is the first address of the function being called).
+    Sample &sample = samples[index];
+    sample.addresses[0] = publishedEIP.load(std::memory_order_relaxed);
+
+    // The active chain is not written to until another one has been published.
+    const Frames &chain = frames[activeFrames.load(std::memory_order_acquire)];
+    sample.depth = chain.depth.load(std::memory_order_relaxed);
+    for (int i = 1; i < sample.depth; i++) {
+        sample.addresses[i] = chain.addresses[i].load(std::memory_order_relaxed);
+    }
+}
+
+void FJP::SamplingProfiler::publishFrames(int ebp) {
+    int inactive = 1 - activeFrames.load(std::memory_order_relaxed);
+    Frames &chain = frames[inactive];
+
+    // Walk the dynamic links of the frames (base + 2) and store the addresses of the
+    // calls that created them (return address - 1). The main frame has its dynamic link set to 0.
+    int depth = 1;
+    int base = ebp;
+    while (base > 1 && base + 3 < stackSize && depth < MAX_FRAMES) {
+        chain.addresses[depth++].store(stackMemory[base + 3] - 1, std::memory_order_relaxed);
+        int previousBase = stackMemory[base + 2];
+        if (previousBase >= base) {
+            break;
+        }
+        base = previousBase;
+    }
+    chain.depth.store(depth, std::memory_order_relaxed);
+
+    // Let the signal handler read the new chain.
+    activeFrames.store(inactive, std::memory_order_release);
+    publishedEBP = ebp;
+}
+
+void FJP::SamplingProfiler::report(const FJP::GeneratedCode &program) {
+    int count = std::min(sampleCount.load(), static_cast<int>(MAX_SAMPLES));
+
+    // Translate every sample into a call path of functions. The function of a frame
+    // is the target of the CAL instruction that created it. This way, the call path stays
+    // consistent even if the sample was taken in the middle of a call or a return.
+    std::map<std::string, int> callPaths;
+    std::map<int, int> selfSamples;
+    std::map<int, int> lineSamples;
+    for (int i = 0; i < count; i++) {
+        const Sample &sample = samples[i];
+        lineSamples[program.getLineNumber(sample.addresses[0])]++;
+        std::string path = program.getFunctionName(0);
+        int function = 0;
+        for (int frame = sample.depth - 1; frame >= 1; frame--) {
+            int callAddress = sample.addresses[frame];
+            if (callAddress >= 0 && callAddress < program.getSize() && program[callAddress].op == FJP::OP_CODE::CAL) {
+                function = program[callAddress].m;
+            } else {
+                function = program.findFunction(callAddress);
+            }
+            path += ";" + program.getFunctionName(function);
+        }
+        callPaths[path]++;
+        selfSamples[function]++;
+    }
+
+    // Collapsed stacks (flame-graph input).
+    std::ofstream foldedFile(OUTPUT_FOLDED_FILE);
+    if (!foldedFile.is_open()) {
+        FJP::exitProgramWithError(FJP::IOErrors::ERROR_01, ERR_CODE);
+    }
+    for (const auto &callPath : callPaths) {
+        foldedFile << callPath.first << " " << callPath.second << "\n";
+    }
+    foldedFile.close();
+
+    // Flat profile - the share of the samples taken in each function.
+    std::ofstream file(OUTPUT_FILE);
+    if (!file.is_open()) {
+        FJP::exitProgramWithError(FJP::IOErrors::ERROR_01, ERR_CODE);
+    }
+    file << "samples: " << count << " (interval " << SAMPLE_INTERVAL_US << " us, dropped " << droppedCount.load() << ")\n\n";
+    file << std::setw(10) << "samples" << std::setw(8) << "%" << "  function\n";
+    for (const auto &function : selfSamples) {
+        double percentage = 100.0 * function.second / std::max(count, 1);
+        file << std::setw(10) << function.second
+             << std::setw(8) << std::fixed << std::setprecision(2) << percentage
+             << "  " << program.getFunctionName(function.first) << "\n";
+    }
+
+    // Samples per line of the source code (taken from the instruction pointer).
+    file << "\n" << std::setw(10) << "samples" << std::setw(8) << "%" << "  line\n";
+    for (const auto &line : lineSamples) {
+        double percentage = 100.0 * line.second / std::max(count, 1);
+        file << std::setw(10) << line.second
+             << std::setw(8) << std::fixed << std::setprecision(2) << percentage
+             << "  " << (line.first + 1) << "\n";
+    }
+#ifndef SAMPLING_SUPPORTED
+    file << "\nsampling is not supported on this platform\n";
+#endif
+    file.close();
+}
@@ -0,0 +1,189 @@
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# include <immintrin.h>
+# define SCAN_KERNELS_X86
+# define FJP_TARGET(features) __attribute__((target(features)))
+#endif
+
+#include <scan_kernels.h>
+
+namespace {
+
+    /// Checks whether a character is white (the same characters isspace recognizes in the "C" locale).
+    bool isWhite(char c) {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
+
+    // -------------------------------------------------------------------------------------
+    // Scalar kernels (also used to process the remaining characters of the SIMD kernels).
+    // -------------------------------------------------------------------------------------
+
+    long skipSpacesScalar(const char *text, long index, long length, int &lineNumber) {
+        while (index < length && isWhite(text[index])) {
+            if (text[index] == '\n') {
+                lineNumber++;
+            }
+            index++;
+        }
+        return index;
+    }
+
+    long findCommentDelimiterScalar(const char *text, long index, long length, int &lineNumber) {
+        for (; index + 1 < length; index++) {
+            if ((text[index] == '/' && text[index + 1] == '*') || (text[index] == '*' && text[index + 1] == '/')) {
+                return index;
+            }
+            if (text[index] == '\n') {
+                lineNumber++;
+            }
+        }
+        return -1;
+    }
+
+#ifdef SCAN_KERNELS_X86
+    // -------------------------------------------------------------------------------------
+    // SSE2 kernels (16 characters at a time).
+    // -------------------------------------------------------------------------------------
+
+    FJP_TARGET("sse2")
+    long skipSpacesSse2(const char *text, long index, long length, int &lineNumber) {
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i carriageReturn = _mm_set1_epi8('\r');
+        const __m128i newLine = _mm_set1_epi8('\n');
+        while (index + 16 <= length) {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + index));
+
+            // '\t' <= c <= '\r' (unsigned), or c == ' '
+            __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(_mm_max_epu8(chunk, tab), carriageReturn), chunk);
+            __m128i white = _mm_or_si128(control, _mm_cmpeq_epi8(chunk, space));
+            unsigned other = ~static_cast<unsigned>(_mm_movemask_epi8(white)) & 0xFFFFu;
+            unsigned newLines = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newLine)));
+            if (other != 0) {
+                int offset = __builtin_ctz(other);
+                lineNumber += __builtin_popcount(newLines & ((1u << offset) - 1));
+                return index + offset;
+            }
+            lineNumber += __builtin_popcount(newLines);
+            index += 16;
+        }
+        return skipSpacesScalar(text, index, length, lineNumber);
+    }
+
+    FJP_TARGET("sse2")
+    long findCommentDelimiterSse2(const char *text, long index, long length, int &lineNumber) {
+        const __m128i slash = _mm_set1_epi8('/');
+        const __m128i asterisk = _mm_set1_epi8('*');
+        const __m128i newLine = _mm_set1_epi8('\n');
+
+        // Each character is compared together with the one following it.
+        while (index + 17 <= length) {
+            __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + index));
+            __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i *>(text + index + 1));
+            __m128i start = _mm_and_si128(_mm_cmpeq_epi8(current, slash), _mm_cmpeq_epi8(next, asterisk));
+            __m128i end = _mm_and_si128(_mm_cmpeq_epi8(current, asterisk), _mm_cmpeq_epi8(next, slash));
+            unsigned delimiters = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(start, end)));
+            unsigned newLines = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(current, newLine)));
+            if (delimiters != 0) {
+                int offset = __builtin_ctz(delimiters);
+                lineNumber += __builtin_popcount(newLines & ((1u << offset) - 1));
+                return index + offset;
+            }
+            lineNumber += __builtin_popcount(newLines);
+            index += 16;
+        }
+        return findCommentDelimiterScalar(text, index, length, lineNumber);
+    }
+
+    // -------------------------------------------------------------------------------------
+    // AVX2 kernels (32 characters at a time).
+    // -------------------------------------------------------------------------------------
+
+    FJP_TARGET("avx2")
+    long skipSpacesAvx2(const char *text, long index, long length, int &lineNumber) {
+        const __m256i space = _mm256_set1_epi8(' ');
+        const __m256i tab = _mm256_set1_epi8('\t');
+        const __m256i carriageReturn = _mm256_set1_epi8('\r');
+        const __m256i newLine = _mm256_set1_epi8('\n');
+        while (index + 32 <= length) {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + index));
+
+            // '\t' <= c <= '\r' (unsigned), or c == ' '
+            __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(_mm256_max_epu8(chunk, tab), carriageReturn), chunk);
+            __m256i white = _mm256_or_si256(control, _mm256_cmpeq_epi8(chunk, space));
+            unsigned other = ~static_cast<unsigned>(_mm256_movemask_epi8(white));
+            unsigned newLines = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, newLine)));
+            if (other != 0) {
+                int offset = __builtin_ctz(other);
+                lineNumber += __builtin_popcount(newLines & ((1u << offset) - 1));
+                return index + offset;
+            }
+            lineNumber += __builtin_popcount(newLines);
+            index += 32;
+        }
+        return skipSpacesSse2(text, index, length, lineNumber);
+    }
+
+    FJP_TARGET("avx2")
+    long findCommentDelimiterAvx2(const char *text, long index, long length, int &lineNumber) {
+        const __m256i slash = _mm256_set1_epi8('/');
+        const __m256i asterisk = _mm256_set1_epi8('*');
+        const __m256i newLine = _mm256_set1_epi8('\n');
+
+        // Each character is compared together with the one following it.
+        while (index + 33 <= length) {
+            __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + index));
+            __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(text + index + 1));
+            __m256i start = _mm256_and_si256(_mm256_cmpeq_epi8(current, slash), _mm256_cmpeq_epi8(next, asterisk));
+            __m256i end = _mm256_and_si256(_mm256_cmpeq_epi8(current, asterisk), _mm256_cmpeq_epi8(next, slash));
+            unsigned delimiters = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(start, end)));
+            unsigned newLines = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(current, newLine)));
+            if (delimiters != 0) {
+                int offset = __builtin_ctz(delimiters);
+                lineNumber += __builtin_popcount(newLines & ((1u << offset) - 1));
+                return index + offset;
+            }
+            lineNumber += __builtin_popcount(newLines);
+            index += 32;
+        }
+        return findCommentDelimiterSse2(text, index, length, lineNumber);
+    }
+#endif
+}
+
+FJP::ScanKernels *FJP::ScanKernels::instance = nullptr;
+
+FJP::ScanKernels *FJP::ScanKernels::getInstance() {
+    if (instance == nullptr) {
+        instance = new ScanKernels;
+    }
+    return instance;
+}
+
+FJP::ScanKernels::ScanKernels() : name("scalar"), skipSpacesKernel(skipSpacesScalar),
+                                  findCommentDelimiterKernel(findCommentDelimiterScalar) {
+#ifdef SCAN_KERNELS_X86
+    // Pick the widest implementation the CPU supports.
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        name = "avx2";
+        skipSpacesKernel = skipSpacesAvx2;
+        findCommentDelimiterKernel = findCommentDelimiterAvx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        name = "sse2";
+        skipSpacesKernel = skipSpacesSse2;
+        findCommentDelimiterKernel = findCommentDelimiterSse2;
+    }
+#endif
+}
+
+const char *FJP::ScanKernels::getName() const {
+    return name;
+}
+
+long FJP::ScanKernels::skipSpaces(const char *text, long index, long length, int &lineNumber) const {
+    return skipSpacesKernel(text, index, length, lineNumber);
+}
+
+long FJP::ScanKernels::findCommentDelimiter(const char *text, long index, long length, int &lineNumber) const {
+    return findCommentDelimiterKernel(text, index, length, lineNumber);
+}
@@ -0,0 +1,361 @@
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+
+#include <scanner.h>
+#include <errors.h>
+
+namespace {
+
+    /// Classes of characters the first character of a token is classified by.
+    enum CharClass : uint8_t {
+        OTHER,  ///< anything else (operators, delimiters, unknown characters)
+        LETTER, ///< [a-zA-Z_] - start of a keyword or an identifier
+        DIGIT   ///< [0-9] - start of a number
+    };
+
+    /// Builds the table of the classes of all characters.
+    /// \return the class of each character
+    constexpr std::array<CharClass, 256> make_char_classes() {
+        std::array<CharClass, 256> classes{};
+        for (int c = 'a'; c <= 'z'; c++) {
+            classes[c] = LETTER;
+            classes[c - 'a' + 'A'] = LETTER;
+        }
+        classes['_'] = LETTER;
+        for (int c = '0'; c <= '9'; c++) {
+            classes[c] = DIGIT;
+        }
+        return classes;
+    }
+
+    /// Classes of all characters.
+    constexpr std::array<CharClass, 256> CHAR_CLASSES = make_char_classes();
+
+    /// Returns the class of a character.
+    /// \param c the character
+    /// \return the class of the character
+    constexpr CharClass char_class(char c) {
+        return CHAR_CLASSES[static_cast<unsigned char>(c)];
+    }
+
+    /// Number of slots of the perfect hash table of alphabetic keywords (a power of two).
+    constexpr uint32_t KEYWORD_TABLE_SIZE = 128;
+
+    /// Slot of the perfect hash table of alphabetic keywords.
+    struct KeywordSlot {
+        std::string_view text; ///< the keyword (empty if the slot is not used)
+        FJP::TokenType type;   ///< type of the token
+    };
+
+    /// Adds another character to the hash of a word (32-bit FNV-1a), so a word
+    /// can be hashed while it is being scanned.
+    /// \param hash hash of the preceding characters
+    /// \param c the character
+    /// \return hash including the character
+    constexpr uint32_t hash_step(uint32_t hash, char c) {
+        return (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+
+    /// Calculates the hash of a whole word.
+    /// \param word the word
+    /// \param seed initial value of the hash
+    /// \return the hash
+    constexpr uint32_t hash_word(std::string_view word, uint32_t seed) {
+        uint32_t hash = seed;
+        for (char c : word) {
+            hash = hash_step(hash, c);
+        }
+        return hash;
+    }
+
+    /// Checks whether a keyword is made up of letters only (e.g. 'while' but not 'int[]' or ':=').
+    /// \param keyword the keyword
+    /// \return true if the keyword is alphabetic
+    constexpr bool is_alphabetic(std::string_view keyword) {
+        for (char c : keyword) {
+            if (char_class(c) != LETTER) {
+                return false;
+            }
+        }
+        return !keyword.empty();
+    }
+
+    /// Checks whether no two alphabetic keywords share the same slot of the table.
+    /// \param seed initial value of the hash
+    /// \return true if the hash is perfect
+    constexpr bool is_perfect_seed(uint32_t seed) {
+        bool used[KEYWORD_TABLE_SIZE]{};
+        for (const auto &keyword : FJP::keywords) {
+            if (is_alphabetic(keyword.first)) {
+                uint32_t slot = hash_word(keyword.first, seed) & (KEYWORD_TABLE_SIZE - 1);
+                if (used[slot]) {
+                    return false;
+                }
+                used[slot] = true;
+            }
+        }
+        return true;
+    }
+
+    /// Looks for the first seed which makes the hash perfect (starting from the FNV offset basis).
+    /// \return the seed
+    constexpr uint32_t find_perfect_seed() {
+        uint32_t seed = 2166136261u;
+        while (!is_perfect_seed(seed)) {
+            seed++;
+        }
+        return seed;
+    }
+
+    /// Initial value of the hash of a word (found at compile time).
+    constexpr uint32_t KEYWORD_SEED = find_perfect_seed();
+
+    /// Builds the perfect hash table of alphabetic keywords.
+    /// \return the table
+    constexpr std::array<KeywordSlot, KEYWORD_TABLE_SIZE> make_keyword_table() {
+        std::array<KeywordSlot, KEYWORD_TABLE_SIZE> table{};
+        for (const auto &keyword : FJP::keywords) {
+            if (is_alphabetic(keyword.first)) {
+                table[hash_word(keyword.first, KEYWORD_SEED) & (KEYWORD_TABLE_SIZE - 1)] = {keyword.first, keyword.second};
+            }
+        }
+        return table;
+    }
+
+    /// Perfect hash table of alphabetic keywords (e.g. 'while', 'START').
+    constexpr std::array<KeywordSlot, KEYWORD_TABLE_SIZE> KEYWORD_TABLE = make_keyword_table();
+
+    static_assert(KEYWORD_TABLE[hash_word("instanceof", KEYWORD_SEED) & (KEYWORD_TABLE_SIZE - 1)].type == FJP::INSTANCEOF,
+                  "the keyword table has not been built correctly");
+}
+
+FJP::Scanner::Scanner() : scanKernels(FJP::ScanKernels::getInstance()), currentCharIndex(0), currentLineNumber(0), error{} {
+}
+
+void FJP::Scanner::init(std::string_view source) {
+    content = source;
+    currentCharIndex = 0;
+    currentLineNumber = 0;
+    identifierIds.clear();
+    error = {};
+}
+
+bool FJP::Scanner::fail(const char *methodName, const char *message) {
+    error.methodName = methodName;
+    error.message = message;
+    error.lineNumber = currentLineNumber;
+    return false;
+}
+
+int FJP::Scanner::getLineNumber() const {
+    return currentLineNumber;
+}
+
+const std::unordered_map<std::string_view, int> &FJP::Scanner::getIdentifierIds() const {
+    return identifierIds;
+}
+
+const FJP::LexicalError &FJP::Scanner::getError() const {
+    return error;
+}
+
+bool FJP::Scanner::parseNextToken(FJP::Token &token, bool commentSkipped) {
+    // Skip all comments if there are any.
+    if (!commentSkipped && !skipComments()) {
+        return false;
+    }
+
+    // The text is always terminated by '\0' or a white character, which does not belong to any
+    // token, so the characters can be scanned without checking the end of the text.
+    const char *text = content.data();
+    const long start = currentCharIndex;
+
+    switch (char_class(text[start])) {
+        case LETTER: {
+            // Consume the whole word while hashing it, so a single lookup
+            // into the table tells whether it's a keyword or an identifier.
+            uint32_t hash = KEYWORD_SEED;
+            while (char_class(text[currentCharIndex]) != OTHER) {
+                hash = hash_step(hash, text[currentCharIndex]);
+                currentCharIndex++;
+            }
+            const std::string_view word(text + start, currentCharIndex - start);
+            const KeywordSlot &slot = KEYWORD_TABLE[hash & (KEYWORD_TABLE_SIZE - 1)];
+
+            if (slot.text == word) {
+                // 'int' and 'bool' directly followed by '[]' make up the type of an array.
+                FJP::TokenType type = slot.type;
+                if ((type == INT || type == BOOL) && text[currentCharIndex] == '[' && text[currentCharIndex + 1] == ']') {
+                    type = type == INT ? INT_ARRAY : BOOL_ARRAY;
+                    currentCharIndex += 2;
+                }
+
+                // If a keyword has been found, skip all the white spaces
+                // and return the token.
+                const std::string_view keyword(text + start, currentCharIndex - start);
+                skipWhiteCharacters();
+                token = {
+                        type,             // type of the token
+                        keyword,          // value of the token
+                        currentLineNumber // number of the line the token is on
+                };
+                return true;
+            }
+
+            // It's not a keyword, so it has to be an identifier.
+            // Check if the identifier doesn't exceed the maximum length.
+            if (word.length() > MAX_IDENTIFIER_LEN) {
+                return fail(__FUNCTION__, FJP::CompilationErrors::ERROR_03);
+            }
+
+            // All occurrences of the same name share the same ID.
+            auto id = identifierIds.try_emplace(word, static_cast<int>(identifierIds.size())).first->second;
+
+            // Skip all the white spaces and return the token.
+            skipWhiteCharacters();
+            token = {
+                    IDENTIFIER,        // type of the token
+                    word,              // value of the token
+                    currentLineNumber, // number of the line the token is on
+                    0,                 // value of a number
+                    id                 // ID of the identifier
+            };
+            return true;
+        }
+        case DIGIT: {
+            // If it is a digit, get all the following digits as well
+            // until you find a non-digit character.
+            while (char_class(text[currentCharIndex]) == DIGIT) {
+                currentCharIndex++;
+            }
+            // Convert the number right away (the digits are followed by a non-digit character,
+            // so they can be converted in place), and check if the digit is not too long
+            // (it fits into the datatype).
+            int number = static_cast<int>(std::strtol(text + start, nullptr, 10));
+            if (number < 0) {
+                return fail(__FUNCTION__, FJP::CompilationErrors::ERROR_02);
+            }
+
+            // Skip all the white spaces and return the token.
+            const std::string_view digits(text + start, currentCharIndex - start);
+            skipWhiteCharacters();
+            token = {
+                    NUMBER,            // type of the token
+                    digits,            // value of the token
+                    currentLineNumber, // number of the line the token is on
+                    number             // value of the number
+            };
+            return true;
+        }
+        case OTHER:
+            break;
+    }
+
+    // It's neither a keyword, an identifier, nor a number, so it has to be an operator.
+    token = parseOperator();
+    if (token.tokenType != UNKNOWN) {
+        skipWhiteCharacters();
+        token.lineNumber = currentLineNumber;
+        return true;
+    }
+
+    // If the program gets to this point, it's an unknown character (printed out along with the error).
+    error.text = std::string_view(content.data() + currentCharIndex, 1);
+    return fail(__FUNCTION__, FJP::CompilationErrors::ERROR_04);
+}
+
+FJP::Token FJP::Scanner::parseOperator() {
+    const char *text = content.data() + currentCharIndex;
+    FJP::TokenType type = UNKNOWN;
+    long length = 1;
+
+    // Takes the two-character operator if the second character matches, otherwise the single-character one.
+    auto longest = [&](char second, FJP::TokenType longType, FJP::TokenType shortType) {
+        if (text[1] == second) {
+            length = 2;
+            return longType;
+        }
+        return shortType;
+    };
+
+    switch (text[0]) {
+        case ':': type = longest('=', ASSIGN, COLON); break;
+        case '<': type = longest('=', LESS_OR_EQUAL, LESS); break;
+        case '>': type = longest('=', GREATER_OR_EQUAL, GREATER); break;
+        case '=': type = longest('=', EQUALS, CONST_INIT); break;
+        case '!': type = longest('=', NOT_EQUALS, EXCLAMATION_MARK); break;
+        case '*': type = longest('=', MUL_ASSIGN, ASTERISK); break;
+        case '&': type = longest('&', LOGICAL_AND, UNKNOWN); break;
+        case '|': type = longest('|', LOGICAL_OR, UNKNOWN); break;
+        case '+': type = text[1] == '+' ? longest('+', INCREMENT, PLUS) : longest('=', PLUS_ASSIGN, PLUS); break;
+        case '-': type = text[1] == '-' ? longest('-', DECREMENT, MINUS) : longest('=', MINUS_ASSIGN, MINUS); break;
+        case '(': type = LEFT_PARENTHESIS; break;
+        case ')': type = RIGHT_PARENTHESIS; break;
+        case '{': type = LEFT_CURLY_BRACKET; break;
+        case '}': type = RIGHT_CURLY_BRACKET; break;
+        case '[': type = LEFT_SQUARED_BRACKET; break;
+        case ']': type = RIGHT_SQUARED_BRACKET; break;
+        case '/': type = SLASH; break;
+        case ';': type = SEMICOLON; break;
+        case ',': type = COMMA; break;
+        case '.': type = PERIOD; break;
+        case '?': type = QUESTION_MARK; break;
+        case '#': type = HASH_MARK; break;
+        default:
+            break;
+    }
+    if (type == UNKNOWN) {
+        return {UNKNOWN, {}, currentLineNumber};
+    }
+
+    currentCharIndex += length;
+    return {type, std::string_view(text, length), currentLineNumber};
+}
+
+void FJP::Scanner::skipWhiteCharacters() {
+    // Skip all white spaces (several characters at a time), and
+    // keep counting the lines as you skip the white spaces.
+    currentCharIndex = scanKernels->skipSpaces(content.data(), currentCharIndex,
+                                               static_cast<long>(content.length()), currentLineNumber);
+}
+
+bool FJP::Scanner::skipComments() {
+    // First off, skip all possible white characters.
+    skipWhiteCharacters();
+
+    // Make sure we're not at the end of the file (that there's still enough room for a comment).
+    if (currentCharIndex + 2 >= static_cast<long>(content.length()))
+        return true;
+
+    // Check if the next two characters make up the start sequence of a comment.
+    if (content.compare(currentCharIndex, 2, COMMENT_START) != 0)
+        return true;
+
+    // Keep counting open comments.
+    int openComments = 1;
+
+    currentCharIndex += 2;
+    while (openComments > 0) {
+        // Jump right to the next opening or closing sequence (counting the lines on the way).
+        long delimiter = scanKernels->findCommentDelimiter(content.data(), currentCharIndex,
+                                                           static_cast<long>(content.length()), currentLineNumber);
+
+        // If we reach the end of the file and there's still an unclosed comment, it's an error.
+        if (delimiter < 0) {
+            return fail(nullptr, FJP::CompilationErrors::ERROR_01);
+        }
+
+        // Check if it's an opening of another comment or a closing sequence.
+        if (content.compare(delimiter, 2, COMMENT_START) == 0) {
+            openComments++;
+        } else {
+            openComments--;
+        }
+        currentCharIndex = delimiter + 2;
+    }
+    // Skip all white spaces.
+    skipWhiteCharacters();
+    return true;
+}
@@ -0,0 +1,93 @@
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# define MMAP_SUPPORTED
+#endif
+
+#include <source_file.h>
+
+FJP::SourceFile::SourceFile() : mapping(nullptr), mappingSize(0) {
+}
+
+FJP::SourceFile::~SourceFile() {
+    close();
+}
+
+bool FJP::SourceFile::map([[maybe_unused]] const std::string &filename) {
+#ifdef MMAP_SUPPORTED
+    int descriptor = ::open(filename.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return false;
+    }
+
+    // Only a non-empty regular file can be mapped (not a pipe, for instance).
+    struct stat status {};
+    if (fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode) || status.st_size <= 0) {
+        ::close(descriptor);
+        return false;
+    }
+    size_t size = static_cast<size_t>(status.st_size);
+
+    // Reserve enough zeroed memory for the file and the terminating '\0', and map the file
+    // over its beginning. The rest of the last page of the file is filled with zeros as well.
+    size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t reservedSize = (size + 1 + pageSize - 1) / pageSize * pageSize;
+    void *reserved = mmap(nullptr, reservedSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reserved == MAP_FAILED) {
+        ::close(descriptor);
+        return false;
+    }
+    void *address = mmap(reserved, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, descriptor, 0);
+    ::close(descriptor);
+    if (address == MAP_FAILED) {
+        munmap(reserved, reservedSize);
+        return false;
+    }
+
+    mapping = reserved;
+    mappingSize = reservedSize;
+    content = std::string_view(static_cast<const char *>(mapping), size);
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool FJP::SourceFile::open(const std::string &filename) {
+    close();
+    if (map(filename)) {
+        return true;
+    }
+
+    // The file cannot be mapped, so it is read into a buffer instead.
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+    char chunk[64 * 1024];
+    while (file.read(chunk, sizeof(chunk)) || file.gcount() > 0) {
+        buffer.append(chunk, static_cast<size_t>(file.gcount()));
+    }
+    content = buffer;
+    return true;
+}
+
+void FJP::SourceFile::close() {
+#ifdef MMAP_SUPPORTED
+    if (mapping != nullptr) {
+        munmap(mapping, mappingSize);
+    }
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    buffer.clear();
+    content = std::string_view();
+}
+
+std::string_view FJP::SourceFile::getContent() const {
+    return content;
+}
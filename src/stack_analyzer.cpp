@@ -0,0 +1,276 @@
+#include <climits>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+
+#include <stack_analyzer.h>
+
+FJP::StackAnalyzer::StackAnalyzer(const FJP::GeneratedCode &code) : program(code), valid(true) {
+}
+
+FJP::StackBound FJP::StackAnalyzer::analyze() {
+    FJP::StackBound bound {false, false, 0, 0};
+    if (program.getSize() == 0) {
+        return bound;
+    }
+
+    // Analyze all functions reachable from the main block of the program.
+    std::vector<int> pending = {0};
+    while (!pending.empty() && valid) {
+        int address = pending.back();
+        pending.pop_back();
+        if (functions.count(address) != 0) {
+            continue;
+        }
+        analyzeFunction(address);
+        for (const auto &call : functions[address].calls) {
+            pending.push_back(call.first);
+        }
+    }
+    if (!valid) {
+        return bound;
+    }
+
+    findRecursion();
+
+    // The cost of one level of recursion is the depth of the stack at a call
+    // within a cycle of the call graph (the frame of the callee starts right above it).
+    for (const auto &function : functions) {
+        for (const auto &call : function.second.calls) {
+            if (function.second.recursive && functions[call.first].component == function.second.component) {
+                bound.recursive = true;
+                bound.levelCost = std::max(bound.levelCost, call.second);
+            }
+        }
+    }
+
+    // The main block of the program starts with an empty stack (ESP = 0).
+    std::map<int, int> cache;
+    bound.maxDepth = computeRequirement(0, cache);
+    bound.known = true;
+    return bound;
+}
+
+void FJP::StackAnalyzer::analyzeFunction(int address) {
+    FunctionInfo &info = functions[address];
+    info.peak = 0;
+    info.component = -1;
+    info.recursive = false;
+
+    // Depth of the stack before each instruction (relative to the base of the frame).
+    std::map<int, int> depths;
+    std::vector<std::pair<int, int>> pending = {{address, 0}};
+
+    while (!pending.empty()) {
+        int current = pending.back().first;
+        int depth = pending.back().second;
+        pending.pop_back();
+
+        // An instruction reachable with two different depths (e.g. a goto out of a foreach
+        // loop) or a jump outside of the program means that the depth cannot be determined.
+        if (current < 0 || current >= program.getSize()) {
+            valid = false;
+            return;
+        }
+        auto visited = depths.find(current);
+        if (visited != depths.end()) {
+            if (visited->second != depth) {
+                valid = false;
+                return;
+            }
+            continue;
+        }
+        depths[current] = depth;
+
+        const FJP::Instruction &instruction = program[current];
+        int next = current + 1;
+        switch (instruction.op) {
+            case FJP::OP_CODE::LIT:
+            case FJP::OP_CODE::LOD:
+                depth++;
+                break;
+            case FJP::OP_CODE::STO:
+            case FJP::OP_CODE::ADDV:
+            case FJP::OP_CODE::SUBV:
+            case FJP::OP_CODE::MULV:
+                depth--;
+                break;
+            case FJP::OP_CODE::STA:
+            case FJP::OP_CODE::STD:
+            case FJP::OP_CODE::STX:
+                depth -= 2;
+                break;
+            case FJP::OP_CODE::INC:
+                // A frame can neither shrink below its base nor grow beyond the range of int
+                // (programs loaded from bytecode files are analyzed as well).
+                if (instruction.m < -depth || instruction.m > INT_MAX / 2 - depth) {
+                    valid = false;
+                    return;
+                }
+                depth += instruction.m;
+                break;
+            case FJP::OP_CODE::LDA:
+            case FJP::OP_CODE::LDD:
+            case FJP::OP_CODE::LDX:
+            case FJP::OP_CODE::CPY:
+            case FJP::OP_CODE::CPD:
+            case FJP::OP_CODE::ADDI:
+            case FJP::OP_CODE::SUBI:
+            case FJP::OP_CODE::MULI:
+            case FJP::OP_CODE::CMPI:
+            case FJP::OP_CODE::ADDVI:
+            case FJP::OP_CODE::SUBVI:
+            case FJP::OP_CODE::MULVI:
+                break;
+            case FJP::OP_CODE::CAL:
+                info.calls.emplace_back(instruction.m, depth);
+                break;
+            case FJP::OP_CODE::JMP:
+                next = instruction.m;
+                break;
+            case FJP::OP_CODE::VADD:
+            case FJP::OP_CODE::VMUL:
+            case FJP::OP_CODE::VSUM:
+            case FJP::OP_CODE::VMIN:
+            case FJP::OP_CODE::VMAX:
+            case FJP::OP_CODE::VCMP:
+            case FJP::OP_CODE::VFILL:
+                // Either the JMP over the loop follows, or it gets skipped.
+                pending.emplace_back(current + 2, depth);
+                break;
+            case FJP::OP_CODE::JPC:
+                depth--;
+                pending.emplace_back(instruction.m, depth);
+                break;
+            case FJP::OP_CODE::JEQ:
+            case FJP::OP_CODE::JNE:
+            case FJP::OP_CODE::JLT:
+            case FJP::OP_CODE::JLE:
+            case FJP::OP_CODE::JGT:
+            case FJP::OP_CODE::JGE:
+                depth -= 2;
+                pending.emplace_back(instruction.m, depth);
+                break;
+            case FJP::OP_CODE::JEQI:
+            case FJP::OP_CODE::JNEI:
+            case FJP::OP_CODE::JLTI:
+            case FJP::OP_CODE::JLEI:
+            case FJP::OP_CODE::JGTI:
+            case FJP::OP_CODE::JGEI:
+                depth--;
+                pending.emplace_back(instruction.m, depth);
+                break;
+            case FJP::OP_CODE::JTB:
+                // The value is popped, and the execution continues at one of the targets.
+                depth--;
+                for (int target : program.getJumpTable(instruction.m).targets) {
+                    pending.emplace_back(target, depth);
+                }
+                pending.emplace_back(program.getJumpTable(instruction.m).defaultTarget, depth);
+                next = -1;
+                break;
+            case FJP::OP_CODE::SIO:
+                if (instruction.m == FJP::SIO_TYPE::SIO_WRITE) {
+                    depth--;
+                } else if (instruction.m == FJP::SIO_TYPE::SIO_READ) {
+                    depth++;
+                } else if (instruction.m == FJP::SIO_TYPE::SIO_HALT) {
+                    next = -1;
+                }
+                break;
+            case FJP::OP_CODE::OPR:
+                if (instruction.m == FJP::OPRType::OPR_RET) {
+                    next = -1;
+                } else if (instruction.m != FJP::OPRType::OPR_INVERT_VALUE && instruction.m != FJP::OPRType::OPR_ODD) {
+                    // All the other operations are binary.
+                    depth--;
+                }
+                break;
+        }
+        info.peak = std::max(info.peak, depth);
+        if (next != -1) {
+            pending.emplace_back(next, depth);
+        }
+    }
+}
+
+void FJP::StackAnalyzer::findRecursion() {
+    std::map<int, int> index;
+    std::map<int, int> lowLink;
+    std::vector<int> stack;
+    std::map<int, bool> onStack;
+    int counter = 0;
+    int component = 0;
+
+    std::function<void(int)> visit = [&](int address) {
+        index[address] = lowLink[address] = counter++;
+        stack.push_back(address);
+        onStack[address] = true;
+
+        for (const auto &call : functions[address].calls) {
+            if (index.count(call.first) == 0) {
+                visit(call.first);
+                lowLink[address] = std::min(lowLink[address], lowLink[call.first]);
+            } else if (onStack[call.first]) {
+                lowLink[address] = std::min(lowLink[address], index[call.first]);
+            }
+        }
+
+        // The function is the root of a component - pop all of its members.
+        if (lowLink[address] == index[address]) {
+            std::vector<int> members;
+            int member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                onStack[member] = false;
+                functions[member].component = component;
+                members.push_back(member);
+            } while (member != address);
+
+            // A component is recursive if it has more than one member or the function calls itself.
+            bool recursive = members.size() > 1;
+            for (const auto &call : functions[address].calls) {
+                recursive |= call.first == address;
+            }
+            for (int m : members) {
+                functions[m].recursive = recursive;
+            }
+            component++;
+        }
+    };
+
+    for (const auto &function : functions) {
+        if (index.count(function.first) == 0) {
+            visit(function.first);
+        }
+    }
+}
+
+int FJP::StackAnalyzer::computeRequirement(int address, std::map<int, int> &cache) {
+    auto cached = cache.find(address);
+    if (cached != cache.end()) {
+        return cached->second;
+    }
+
+    // The deepest frame of a recursion can be any function of the component, so the
+    // requirement (without the levels of the recursion) is the maximum over all of its
+    // members. The calls within the component are covered by the cost of a level.
+    // The components form an acyclic graph, so the recursion of this method terminates.
+    int component = functions[address].component;
+    int64_t requirement = 0;
+    for (const auto &function : functions) {
+        if (function.first != address && (!function.second.recursive || function.second.component != component)) {
+            continue;
+        }
+        requirement = std::max<int64_t>(requirement, function.second.peak);
+        for (const auto &call : function.second.calls) {
+            if (functions[call.first].component != component) {
+                requirement = std::max(requirement, static_cast<int64_t>(call.second) + computeRequirement(call.first, cache));
+            }
+        }
+    }
+    // Saturate the requirement, so a long chain of calls cannot overflow it.
+    cache[address] = static_cast<int>(std::min<int64_t>(requirement, INT_MAX));
+    return cache[address];
+}
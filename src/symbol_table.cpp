@@ -22,7 +22,7 @@ void FJP::SymbolTable::destroyFrame() {
     frames.pop_back();
 }
 
-bool FJP::SymbolTable::existsSymbol(const std::string &name) const {
+bool FJP::SymbolTable::existsSymbol(std::string_view name) const {
     // Find the symbol in the symbol table.
     FJP::Symbol symbol = findSymbol(name);
 
@@ -35,10 +35,10 @@ int FJP::SymbolTable::getDepthLevel() const {
     return std::max(0, static_cast<int>(frames.size()) - 1);
 }
 
-FJP::Symbol FJP::SymbolTable::findSymbol(const std::string &name) const {
+FJP::Symbol FJP::SymbolTable::findSymbol(std::string_view name) const {
     // Default symbol that will be returned if the symbol has not been found - symbol type = SYMBOL_NOT_FOUND.
     // We also use this symbol to find the searched symbol - the name is set to the searched one.
-    FJP::Symbol symbol = { FJP::SymbolType::SYMBOL_NOT_FOUND, name, 0, 0, 0, 0};
+    FJP::Symbol symbol = { FJP::SymbolType::SYMBOL_NOT_FOUND, std::string(name), 0, 0, 0, 0};
 
     // Go through all the frames (from the last one back to the first one) and for each
     // frame, check if it holds the searched symbol. Once the symbol is found, return it.
@@ -58,7 +58,7 @@ void FJP::SymbolTable::addSymbol(FJP::Symbol symbol) {
 }
 
 void FJP::SymbolTable::makeArray(const std::string &name, int size) {
-    FJP::Symbol symbol = { FJP::SymbolType::SYMBOL_NOT_FOUND, name, 0, 0, 0, 0};
+    FJP::Symbol symbol = { FJP::SymbolType::SYMBOL_NOT_FOUND, std::string(name), 0, 0, 0, 0};
 
     // Go through all the frames in a reverse order.
     for (auto iter = frames.rbegin(); iter != frames.rend(); ++iter) {
@@ -91,6 +91,25 @@ void FJP::SymbolTable::makeArray(const std::string &name, int size) {
     }
 }
 
+void FJP::SymbolTable::moveToDataSegment(const std::string &name, int address) {
+    FJP::Symbol symbol = { FJP::SymbolType::SYMBOL_NOT_FOUND, std::string(name), 0, 0, 0, 0};
+
+    // Go through all the frames in a reverse order.
+    for (auto iter = frames.rbegin(); iter != frames.rend(); ++iter) {
+        // Check if the current frame holds the symbol we're searching for.
+        auto symbolIt = iter->symbols.find(symbol);
+        if (symbolIt != iter->symbols.end()) {
+            // Replace the symbol with a copy that refers to the data segment.
+            FJP::Symbol updatedSymbol = *symbolIt;
+            updatedSymbol.address = address;
+            updatedSymbol.inDataSegment = true;
+            iter->symbols.erase(*symbolIt);
+            iter->symbols.insert(updatedSymbol);
+            return;
+        }
+    }
+}
+
 std::list<FJP::Frame> &FJP::SymbolTable::getFrames() {
     return frames;
 }
@@ -117,7 +136,8 @@ std::ostream &FJP::operator<<(std::ostream &out, const FJP::Symbol &symbol) {
         << " | name: "    << symbol.name
         << " | value: "   << symbol.value
         << " | level: "   << symbol.level
-        << " | address: " << symbol.address;
+        << " | address: " << symbol.address
+        << (symbol.inDataSegment ? " (data segment)" : "");
     return out;
 }
 
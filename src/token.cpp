@@ -17,15 +17,15 @@ std::ostream &FJP::operator<<(std::ostream &out, const FJP::Token &token) {
 
 std::string FJP::token_type_to_str(FJP::TokenType tokenType) {
     // Tries to find a token by its corresponding string value (using the keywords list)
-    auto match = std::find_if(keywords.begin(), keywords.end(), [&](const auto &keyword) {
+    auto match = std::find_if(std::begin(keywords), std::end(keywords), [&](const auto &keyword) {
        return keyword.second == tokenType;
     });
 
     // If such token has not been found, it has to be either an
     // identifier or a number because those are not listed out due to
     // their variability
-    if (match != keywords.end())
-        return match->first;
+    if (match != std::end(keywords))
+        return std::string(match->first);
 
     switch (tokenType) {
         case IDENTIFIER:
@@ -0,0 +1,54 @@
+#include <thread>
+
+#include <token_queue.h>
+
+FJP::TokenQueue::TokenQueue() : head(0), consumerTail(0), tail(0), producerHead(0), closed(false), cancelled(false) {
+}
+
+void FJP::TokenQueue::reset() {
+    head.store(0, std::memory_order_relaxed);
+    consumerTail = 0;
+    tail.store(0, std::memory_order_relaxed);
+    producerHead = 0;
+    closed.store(false, std::memory_order_relaxed);
+    cancelled.store(false, std::memory_order_relaxed);
+}
+
+bool FJP::TokenQueue::waitForRoom() {
+    const size_t position = tail.load(std::memory_order_relaxed);
+    while (true) {
+        // The slots of the tokens popped so far can be reused.
+        producerHead = head.load(std::memory_order_acquire);
+        if (position - producerHead < CAPACITY) {
+            return true;
+        }
+        if (cancelled.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void FJP::TokenQueue::close() {
+    closed.store(true, std::memory_order_release);
+}
+
+bool FJP::TokenQueue::waitForToken() {
+    const size_t position = head.load(std::memory_order_relaxed);
+    while (true) {
+        consumerTail = tail.load(std::memory_order_acquire);
+        if (position != consumerTail) {
+            return true;
+        }
+        // The last tokens may have been pushed right before the queue was closed.
+        if (closed.load(std::memory_order_acquire)) {
+            consumerTail = tail.load(std::memory_order_acquire);
+            return position != consumerTail;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void FJP::TokenQueue::cancel() {
+    cancelled.store(true, std::memory_order_release);
+}
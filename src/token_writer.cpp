@@ -0,0 +1,137 @@
+#include <limits>
+#include <charconv>
+#include <cstring>
+#include <cstddef>
+
+#include <token_writer.h>
+
+namespace {
+
+    /// Magic number the binary dump starts with.
+    constexpr char MAGIC[4] = {'F', 'J', 'P', 'T'};
+
+    /// Alignment of the records within the binary dump.
+    constexpr size_t RECORD_ALIGNMENT = 8;
+}
+
+FJP::TokenWriter::TokenWriter() : format(JSON), tokenCount(0) {
+    for (int type = 0; type <= TokenType::UNKNOWN; type++) {
+        typeNames[type] = token_type_to_str(static_cast<TokenType>(type));
+    }
+}
+
+FJP::TokenWriter::~TokenWriter() {
+    close();
+}
+
+bool FJP::TokenWriter::open(const std::string &filename, Format outputFormat, std::string_view sourceCode) {
+    close();
+
+    // The records point into the source code with 32-bit offsets.
+    if (outputFormat == BINARY && sourceCode.size() > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+    file.open(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    format = outputFormat;
+    source = sourceCode;
+    tokenCount = 0;
+    buffer.clear();
+    buffer.reserve(BUFFER_SIZE + 1024);
+
+    if (format == JSON) {
+        append("[");
+        return true;
+    }
+
+    // The number of the tokens is filled in once the file is finished.
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.recordSize = sizeof(Record);
+    header.sourceSize = source.size();
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(source.data(), static_cast<std::streamsize>(source.size()));
+    const char padding[RECORD_ALIGNMENT] = {};
+    file.write(padding, static_cast<std::streamsize>((RECORD_ALIGNMENT - source.size() % RECORD_ALIGNMENT) % RECORD_ALIGNMENT));
+    return true;
+}
+
+bool FJP::TokenWriter::isOpen() const {
+    return file.is_open();
+}
+
+void FJP::TokenWriter::write(const FJP::Token &token) {
+    if (format == JSON) {
+        writeJSON(token);
+    } else {
+        writeBinary(token);
+    }
+    tokenCount++;
+
+    if (buffer.size() >= BUFFER_SIZE) {
+        flush();
+    }
+}
+
+void FJP::TokenWriter::close() {
+    if (!file.is_open()) {
+        return;
+    }
+    if (format == JSON) {
+        append(tokenCount == 0 ? "]" : "]\n");
+        flush();
+    } else {
+        flush();
+        file.seekp(offsetof(Header, tokenCount));
+        file.write(reinterpret_cast<const char *>(&tokenCount), sizeof(tokenCount));
+    }
+    file.close();
+}
+
+void FJP::TokenWriter::append(std::string_view text) {
+    buffer.insert(buffer.end(), text.begin(), text.end());
+}
+
+void FJP::TokenWriter::appendNumber(long value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    buffer.insert(buffer.end(), digits, result.ptr);
+}
+
+void FJP::TokenWriter::flush() {
+    file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+}
+
+void FJP::TokenWriter::writeJSON(const FJP::Token &token) {
+    // The same format as the one the token is printed out in (see operator<<).
+    if (tokenCount > 0) {
+        append(",\n");
+    }
+    append("{\n    \"typeId\": \"");
+    appendNumber(token.tokenType);
+    append("\",\n    \"type\": \"");
+    append(typeNames[token.tokenType]);
+    append("\",\n    \"lineNumber\": \"");
+    appendNumber(token.lineNumber);
+    append("\",\n    \"value\": \"");
+    append(token.value);
+    append("\"\n}");
+}
+
+void FJP::TokenWriter::writeBinary(const FJP::Token &token) {
+    Record record{};
+    record.offset = token.value.empty() ? 0 : static_cast<uint32_t>(token.value.data() - source.data());
+    record.length = static_cast<uint16_t>(token.value.length());
+    record.type = static_cast<uint16_t>(token.tokenType);
+    record.lineNumber = token.lineNumber;
+    record.number = token.number;
+    record.identifierId = token.identifierId;
+
+    const char *bytes = reinterpret_cast<const char *>(&record);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(record));
+}
@@ -0,0 +1,444 @@
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# include <immintrin.h>
+# define VECTOR_KERNELS_X86
+# define FJP_TARGET(features) __attribute__((target(features)))
+#endif
+
+#include <vector_kernels.h>
+
+namespace {
+
+    /// Adds up two numbers the way the virtual machine does (wrapping around on an overflow).
+    int wrappedAdd(int x, int y) {
+        return static_cast<int>(static_cast<uint32_t>(x) + static_cast<uint32_t>(y));
+    }
+
+    /// Multiplies two numbers the way the virtual machine does (wrapping around on an overflow).
+    int wrappedMul(int x, int y) {
+        return static_cast<int>(static_cast<uint32_t>(x) * static_cast<uint32_t>(y));
+    }
+
+    /// The very same condition the OPR instruction uses to detect an overflow.
+    bool overflows(int x, int y, int result) {
+        return (x < 0 && y < 0 && result > 0) || (x > 0 && y > 0 && result < 0);
+    }
+
+    // -------------------------------------------------------------------------------------
+    // Scalar kernels (also used to process the remaining elements of the SIMD kernels).
+    // -------------------------------------------------------------------------------------
+
+    int64_t sumScalar(const int *values, int count, uint64_t &absoluteSum) {
+        int64_t sum = 0;
+        for (int i = 0; i < count; i++) {
+            sum += values[i];
+            absoluteSum += values[i] < 0 ? 0ULL - static_cast<uint64_t>(values[i]) : static_cast<uint64_t>(values[i]);
+        }
+        return sum;
+    }
+
+    template <int (*OPERATION)(int, int)>
+    bool checkScalar(const int *x, const int *y, int count) {
+        for (int i = 0; i < count; i++) {
+            if (overflows(x[i], y[i], OPERATION(x[i], y[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <int (*OPERATION)(int, int)>
+    void applyScalar(int *destination, const int *x, const int *y, int count) {
+        for (int i = 0; i < count; i++) {
+            destination[i] = OPERATION(x[i], y[i]);
+        }
+    }
+
+    bool addScalar(int *destination, const int *x, const int *y, int count) {
+        if (!checkScalar<wrappedAdd>(x, y, count)) {
+            return false;
+        }
+        applyScalar<wrappedAdd>(destination, x, y, count);
+        return true;
+    }
+
+    bool mulScalar(int *destination, const int *x, const int *y, int count) {
+        if (!checkScalar<wrappedMul>(x, y, count)) {
+            return false;
+        }
+        applyScalar<wrappedMul>(destination, x, y, count);
+        return true;
+    }
+
+    int minScalar(const int *values, int count, int initial) {
+        for (int i = 0; i < count; i++) {
+            initial = std::min(initial, values[i]);
+        }
+        return initial;
+    }
+
+    int maxScalar(const int *values, int count, int initial) {
+        for (int i = 0; i < count; i++) {
+            initial = std::max(initial, values[i]);
+        }
+        return initial;
+    }
+
+    void compareScalar(const int *x, const int *y, int count, int &greater, int &equal) {
+        for (int i = 0; i < count; i++) {
+            greater += (x[i] > y[i]);
+            equal += (x[i] == y[i]);
+        }
+    }
+
+    void compareValueScalar(const int *x, int y, int count, int &greater, int &equal) {
+        for (int i = 0; i < count; i++) {
+            greater += (x[i] > y);
+            equal += (x[i] == y);
+        }
+    }
+
+#ifdef VECTOR_KERNELS_X86
+
+    // -------------------------------------------------------------------------------------
+    // SSE4.1 kernels (4 elements at a time).
+    // -------------------------------------------------------------------------------------
+
+    FJP_TARGET("sse4.1") int64_t sumSse41(const int *values, int count, uint64_t &absoluteSum) {
+        __m128i total = _mm_setzero_si128();
+        __m128i absoluteTotal = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+            total = _mm_add_epi64(total, _mm_cvtepi32_epi64(v));
+            total = _mm_add_epi64(total, _mm_cvtepi32_epi64(_mm_srli_si128(v, 8)));
+
+            // The absolute value of INT_MIN stays 0x80000000, which is right when read as unsigned.
+            __m128i a = _mm_abs_epi32(v);
+            absoluteTotal = _mm_add_epi64(absoluteTotal, _mm_cvtepu32_epi64(a));
+            absoluteTotal = _mm_add_epi64(absoluteTotal, _mm_cvtepu32_epi64(_mm_srli_si128(a, 8)));
+        }
+        alignas(16) int64_t lanes[2];
+        alignas(16) uint64_t absoluteLanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), total);
+        _mm_store_si128(reinterpret_cast<__m128i *>(absoluteLanes), absoluteTotal);
+        absoluteSum += absoluteLanes[0] + absoluteLanes[1];
+        return lanes[0] + lanes[1] + sumScalar(values + i, count - i, absoluteSum);
+    }
+
+    /// Returns all ones in the lanes where the OPR instruction would report an overflow.
+    FJP_TARGET("sse4.1") __m128i overflowMaskSse41(__m128i x, __m128i y, __m128i result) {
+        __m128i zero = _mm_setzero_si128();
+        __m128i negative = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(zero, x), _mm_cmpgt_epi32(zero, y)), _mm_cmpgt_epi32(result, zero));
+        __m128i positive = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(x, zero), _mm_cmpgt_epi32(y, zero)), _mm_cmpgt_epi32(zero, result));
+        return _mm_or_si128(negative, positive);
+    }
+
+    FJP_TARGET("sse4.1") bool addSse41(int *destination, const int *x, const int *y, int count) {
+        __m128i flags = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + i));
+            flags = _mm_or_si128(flags, overflowMaskSse41(a, b, _mm_add_epi32(a, b)));
+        }
+        if (!_mm_testz_si128(flags, flags) || !checkScalar<wrappedAdd>(x + i, y + i, count - i)) {
+            return false;
+        }
+        for (i = 0; i + 4 <= count; i += 4) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), _mm_add_epi32(a, b));
+        }
+        applyScalar<wrappedAdd>(destination + i, x + i, y + i, count - i);
+        return true;
+    }
+
+    FJP_TARGET("sse4.1") bool mulSse41(int *destination, const int *x, const int *y, int count) {
+        __m128i flags = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + i));
+            flags = _mm_or_si128(flags, overflowMaskSse41(a, b, _mm_mullo_epi32(a, b)));
+        }
+        if (!_mm_testz_si128(flags, flags) || !checkScalar<wrappedMul>(x + i, y + i, count - i)) {
+            return false;
+        }
+        for (i = 0; i + 4 <= count; i += 4) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(destination + i), _mm_mullo_epi32(a, b));
+        }
+        applyScalar<wrappedMul>(destination + i, x + i, y + i, count - i);
+        return true;
+    }
+
+    FJP_TARGET("sse4.1") int minSse41(const int *values, int count, int initial) {
+        __m128i result = _mm_set1_epi32(initial);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            result = _mm_min_epi32(result, _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i)));
+        }
+        alignas(16) int lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), result);
+        return minScalar(values + i, count - i, minScalar(lanes, 4, initial));
+    }
+
+    FJP_TARGET("sse4.1") int maxSse41(const int *values, int count, int initial) {
+        __m128i result = _mm_set1_epi32(initial);
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            result = _mm_max_epi32(result, _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i)));
+        }
+        alignas(16) int lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), result);
+        return maxScalar(values + i, count - i, maxScalar(lanes, 4, initial));
+    }
+
+    /// Adds up the lanes of the counters (each lane holds a negative count, as a mask is -1).
+    FJP_TARGET("sse4.1") int countLanesSse41(__m128i counters) {
+        alignas(16) int lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(lanes), counters);
+        return -(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    }
+
+    FJP_TARGET("sse4.1") void compareSse41(const int *x, const int *y, int count, int &greater, int &equal) {
+        __m128i greaterCount = _mm_setzero_si128();
+        __m128i equalCount = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(y + i));
+            greaterCount = _mm_add_epi32(greaterCount, _mm_cmpgt_epi32(a, b));
+            equalCount = _mm_add_epi32(equalCount, _mm_cmpeq_epi32(a, b));
+        }
+        greater += countLanesSse41(greaterCount);
+        equal += countLanesSse41(equalCount);
+        compareScalar(x + i, y + i, count - i, greater, equal);
+    }
+
+    FJP_TARGET("sse4.1") void compareValueSse41(const int *x, int y, int count, int &greater, int &equal) {
+        __m128i b = _mm_set1_epi32(y);
+        __m128i greaterCount = _mm_setzero_si128();
+        __m128i equalCount = _mm_setzero_si128();
+        int i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(x + i));
+            greaterCount = _mm_add_epi32(greaterCount, _mm_cmpgt_epi32(a, b));
+            equalCount = _mm_add_epi32(equalCount, _mm_cmpeq_epi32(a, b));
+        }
+        greater += countLanesSse41(greaterCount);
+        equal += countLanesSse41(equalCount);
+        compareValueScalar(x + i, y, count - i, greater, equal);
+    }
+
+    // -------------------------------------------------------------------------------------
+    // AVX2 kernels (8 elements at a time).
+    // -------------------------------------------------------------------------------------
+
+    FJP_TARGET("avx2") int64_t sumAvx2(const int *values, int count, uint64_t &absoluteSum) {
+        __m256i total = _mm256_setzero_si256();
+        __m256i absoluteTotal = _mm256_setzero_si256();
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i));
+            total = _mm256_add_epi64(total, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+            total = _mm256_add_epi64(total, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+
+            // The absolute value of INT_MIN stays 0x80000000, which is right when read as unsigned.
+            __m256i a = _mm256_abs_epi32(v);
+            absoluteTotal = _mm256_add_epi64(absoluteTotal, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(a)));
+            absoluteTotal = _mm256_add_epi64(absoluteTotal, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(a, 1)));
+        }
+        alignas(32) int64_t lanes[4];
+        alignas(32) uint64_t absoluteLanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), total);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(absoluteLanes), absoluteTotal);
+        absoluteSum += absoluteLanes[0] + absoluteLanes[1] + absoluteLanes[2] + absoluteLanes[3];
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sumScalar(values + i, count - i, absoluteSum);
+    }
+
+    /// Returns all ones in the lanes where the OPR instruction would report an overflow.
+    FJP_TARGET("avx2") __m256i overflowMaskAvx2(__m256i x, __m256i y, __m256i result) {
+        __m256i zero = _mm256_setzero_si256();
+        __m256i negative = _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(zero, x), _mm256_cmpgt_epi32(zero, y)), _mm256_cmpgt_epi32(result, zero));
+        __m256i positive = _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(x, zero), _mm256_cmpgt_epi32(y, zero)), _mm256_cmpgt_epi32(zero, result));
+        return _mm256_or_si256(negative, positive);
+    }
+
+    FJP_TARGET("avx2") bool addAvx2(int *destination, const int *x, const int *y, int count) {
+        __m256i flags = _mm256_setzero_si256();
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i));
+            flags = _mm256_or_si256(flags, overflowMaskAvx2(a, b, _mm256_add_epi32(a, b)));
+        }
+        if (!_mm256_testz_si256(flags, flags) || !checkScalar<wrappedAdd>(x + i, y + i, count - i)) {
+            return false;
+        }
+        for (i = 0; i + 8 <= count; i += 8) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i), _mm256_add_epi32(a, b));
+        }
+        applyScalar<wrappedAdd>(destination + i, x + i, y + i, count - i);
+        return true;
+    }
+
+    FJP_TARGET("avx2") bool mulAvx2(int *destination, const int *x, const int *y, int count) {
+        __m256i flags = _mm256_setzero_si256();
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i));
+            flags = _mm256_or_si256(flags, overflowMaskAvx2(a, b, _mm256_mullo_epi32(a, b)));
+        }
+        if (!_mm256_testz_si256(flags, flags) || !checkScalar<wrappedMul>(x + i, y + i, count - i)) {
+            return false;
+        }
+        for (i = 0; i + 8 <= count; i += 8) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination + i), _mm256_mullo_epi32(a, b));
+        }
+        applyScalar<wrappedMul>(destination + i, x + i, y + i, count - i);
+        return true;
+    }
+
+    FJP_TARGET("avx2") int minAvx2(const int *values, int count, int initial) {
+        __m256i result = _mm256_set1_epi32(initial);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            result = _mm256_min_epi32(result, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i)));
+        }
+        alignas(32) int lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), result);
+        return minScalar(values + i, count - i, minScalar(lanes, 8, initial));
+    }
+
+    FJP_TARGET("avx2") int maxAvx2(const int *values, int count, int initial) {
+        __m256i result = _mm256_set1_epi32(initial);
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            result = _mm256_max_epi32(result, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i)));
+        }
+        alignas(32) int lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), result);
+        return maxScalar(values + i, count - i, maxScalar(lanes, 8, initial));
+    }
+
+    /// Adds up the lanes of the counters (each lane holds a negative count, as a mask is -1).
+    FJP_TARGET("avx2") int countLanesAvx2(__m256i counters) {
+        alignas(32) int lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), counters);
+        int count = 0;
+        for (int lane : lanes) {
+            count -= lane;
+        }
+        return count;
+    }
+
+    FJP_TARGET("avx2") void compareAvx2(const int *x, const int *y, int count, int &greater, int &equal) {
+        __m256i greaterCount = _mm256_setzero_si256();
+        __m256i equalCount = _mm256_setzero_si256();
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + i));
+            greaterCount = _mm256_add_epi32(greaterCount, _mm256_cmpgt_epi32(a, b));
+            equalCount = _mm256_add_epi32(equalCount, _mm256_cmpeq_epi32(a, b));
+        }
+        greater += countLanesAvx2(greaterCount);
+        equal += countLanesAvx2(equalCount);
+        compareScalar(x + i, y + i, count - i, greater, equal);
+    }
+
+    FJP_TARGET("avx2") void compareValueAvx2(const int *x, int y, int count, int &greater, int &equal) {
+        __m256i b = _mm256_set1_epi32(y);
+        __m256i greaterCount = _mm256_setzero_si256();
+        __m256i equalCount = _mm256_setzero_si256();
+        int i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + i));
+            greaterCount = _mm256_add_epi32(greaterCount, _mm256_cmpgt_epi32(a, b));
+            equalCount = _mm256_add_epi32(equalCount, _mm256_cmpeq_epi32(a, b));
+        }
+        greater += countLanesAvx2(greaterCount);
+        equal += countLanesAvx2(equalCount);
+        compareValueScalar(x + i, y, count - i, greater, equal);
+    }
+
+#endif
+}
+
+FJP::VectorKernels *FJP::VectorKernels::instance = nullptr;
+
+FJP::VectorKernels* FJP::VectorKernels::getInstance() {
+    if (instance == nullptr) {
+        instance = new VectorKernels;
+    }
+    return instance;
+}
+
+FJP::VectorKernels::VectorKernels() : name("scalar"), sumKernel(sumScalar), addKernel(addScalar), mulKernel(mulScalar),
+                                      minKernel(minScalar), maxKernel(maxScalar), compareKernel(compareScalar),
+                                      compareValueKernel(compareValueScalar) {
+#ifdef VECTOR_KERNELS_X86
+    // Pick the widest implementation the CPU supports.
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        name = "avx2";
+        sumKernel = sumAvx2;
+        addKernel = addAvx2;
+        mulKernel = mulAvx2;
+        minKernel = minAvx2;
+        maxKernel = maxAvx2;
+        compareKernel = compareAvx2;
+        compareValueKernel = compareValueAvx2;
+    } else if (__builtin_cpu_supports("sse4.1")) {
+        name = "sse4.1";
+        sumKernel = sumSse41;
+        addKernel = addSse41;
+        mulKernel = mulSse41;
+        minKernel = minSse41;
+        maxKernel = maxSse41;
+        compareKernel = compareSse41;
+        compareValueKernel = compareValueSse41;
+    }
+#endif
+}
+
+const char *FJP::VectorKernels::getName() const {
+    return name;
+}
+
+int64_t FJP::VectorKernels::sum(const int *values, int count, uint64_t &absoluteSum) const {
+    return sumKernel(values, count, absoluteSum);
+}
+
+bool FJP::VectorKernels::add(int *destination, const int *x, const int *y, int count) const {
+    return addKernel(destination, x, y, count);
+}
+
+bool FJP::VectorKernels::mul(int *destination, const int *x, const int *y, int count) const {
+    return mulKernel(destination, x, y, count);
+}
+
+int FJP::VectorKernels::min(const int *values, int count, int initial) const {
+    return minKernel(values, count, initial);
+}
+
+int FJP::VectorKernels::max(const int *values, int count, int initial) const {
+    return maxKernel(values, count, initial);
+}
+
+void FJP::VectorKernels::compare(const int *x, const int *y, int count, int &greater, int &equal) const {
+    compareKernel(x, y, count, greater, equal);
+}
+
+void FJP::VectorKernels::compare(const int *x, int y, int count, int &greater, int &equal) const {
+    compareValueKernel(x, y, count, greater, equal);
+}
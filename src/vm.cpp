@@ -1,8 +1,11 @@
+#include <climits>
 #include <cstring>
 #include <iostream>
+#include <algorithm>
 
 #include <vm.h>
 #include <errors.h>
+#include <probes.h>
 
 FJP::VirtualMachine *FJP::VirtualMachine::instance = nullptr;
 
@@ -13,7 +16,8 @@ FJP::VirtualMachine* FJP::VirtualMachine::getInstance() {
     return instance;
 }
 
-FJP::VirtualMachine::VirtualMachine() {
+FJP::VirtualMachine::VirtualMachine() : stackMemory(nullptr), stackSize(0), stackBoundProven(false), instructions(nullptr), wideInstructions(nullptr), samplingProfiler(nullptr), liveStats(nullptr),
+                                         vectorKernels(FJP::VectorKernels::getInstance()), boundsChecking(false), frameChecking(false) {
 }
 
 void FJP::VirtualMachine::execute(FJP::GeneratedCode &program_code, bool debug_mode) {
@@ -23,6 +27,7 @@ void FJP::VirtualMachine::execute(FJP::GeneratedCode &program_code, bool debug_m
 
     // Init the virtual machine.
     init();
+    FJP_PROBE1(vm_execute_start, program->getSize());
 
     // If debug_mode is enabled, open up the output file.
     if (debug_mode) {
@@ -31,16 +36,70 @@ void FJP::VirtualMachine::execute(FJP::GeneratedCode &program_code, bool debug_m
             FJP::exitProgramWithError(FJP::IOErrors::ERROR_01, ERROR_CODE);
         }
 
+        // Stack requirement of the program computed at compile time.
+        const FJP::StackBound &bound = program->getStackBound();
+        outputFile << "stack requirement: ";
+        if (!bound.known) {
+            outputFile << "unknown";
+        } else {
+            outputFile << bound.maxDepth;
+            if (bound.recursive) {
+                outputFile << " + " << bound.levelCost << " per level of recursion";
+            }
+        }
+        outputFile << " (allocated " << stackSize << (stackBoundProven ? ", proven" : "") << ")\n";
+        if (!program->getVectorLoops().empty()) {
+            outputFile << "vector kernels: " << vectorKernels->getName() << "\n";
+        }
+
         // This is the header of the file.
         outputFile << "\t\t\t\tEIP\tEBP\tESP\tstack\n";
         outputFile << "initial values\t\t\t" << EIP << "\t" << EBP << "\t" << ESP << '\n';
     }
 
+    // The sampling profiler reads the copies of the registers published before every instruction.
+    if (samplingProfiler != nullptr) {
+        samplingProfiler->start(stackMemory, stackSize);
+    }
+    if (liveStats != nullptr) {
+        liveStats->start(*program, stackMemory, stackSize);
+    }
+
     // Executes the program_code. Keep fetching and executing
-    // instructions until the vm gets halted.
-    while (halt == 1 && EBP != 0) {
-        fetch();
-        execute();
+    // instructions until the vm gets halted. If there are any profilers
+    // attached, use a separate loop, so the common case stays as fast as possible.
+    // If the program is known to fit in the stack, its growth is not checked at all.
+    if (profilers.empty() && liveStats == nullptr) {
+        if (samplingProfiler != nullptr) {
+            // The sampling profiler only needs the registers published before every instruction.
+            while (halt == 1 && EBP != 0) {
+                samplingProfiler->update(EIP, EBP);
+                fetch();
+                execute<true>();
+            }
+        } else if (stackBoundProven) {
+            while (halt == 1 && EBP != 0) {
+                fetch();
+                execute<false>();
+            }
+        } else {
+            while (halt == 1 && EBP != 0) {
+                fetch();
+                execute<true>();
+            }
+        }
+    } else {
+        executeProfiled();
+    }
+
+    FJP_PROBE2(vm_halt, EIP, ESP);
+
+    if (liveStats != nullptr) {
+        liveStats->stop();
+    }
+    if (samplingProfiler != nullptr) {
+        samplingProfiler->stop();
+        samplingProfiler->report(*program);
     }
     // Close up the output file if debug_mode is enabled.
     if (outputFile.is_open() == true) {
@@ -48,6 +107,69 @@ void FJP::VirtualMachine::execute(FJP::GeneratedCode &program_code, bool debug_m
     }
 }
 
+void FJP::VirtualMachine::addProfiler(FJP::IProfiler *profiler) {
+    profilers.push_back(profiler);
+}
+
+void FJP::VirtualMachine::setSamplingProfiler(FJP::SamplingProfiler *profiler) {
+    samplingProfiler = profiler;
+}
+
+void FJP::VirtualMachine::setLiveStats(FJP::LiveStats *stats) {
+    liveStats = stats;
+}
+
+void FJP::VirtualMachine::setBoundsChecking(bool enabled) {
+    boundsChecking = enabled;
+}
+
+void FJP::VirtualMachine::executeProfiled() {
+    // Counters of the live statistics. They are kept locally
+    // and published only every now and then.
+    uint64_t instructionCount = 0;
+    uint64_t readCount = 0;
+    uint64_t writeCount = 0;
+    int peakESP = ESP;
+
+    while (halt == 1 && EBP != 0) {
+        // Publish the registers for the signal handler of the sampling profiler.
+        if (samplingProfiler != nullptr) {
+            samplingProfiler->update(EIP, EBP);
+        }
+        // Let all the profilers know which instruction is about to be executed.
+        for (auto profiler : profilers) {
+            profiler->instructionExecuted(EIP);
+        }
+        int address = EIP;
+        fetch();
+        execute<true>();
+
+        if (liveStats != nullptr) {
+            instructionCount++;
+            if (ESP > peakESP) {
+                peakESP = ESP;
+            }
+            // Publish the statistics at back-edges (loops), calls, returns, and I/O operations.
+            bool isReturn = instruction.op == OPR && instruction.m == FJP::OPRType::OPR_RET;
+            if (EIP <= address || instruction.op == CAL || instruction.op == SIO || isReturn) {
+                if (instruction.op == SIO) {
+                    readCount += (instruction.m == FJP::SIO_TYPE::SIO_READ);
+                    writeCount += (instruction.m == FJP::SIO_TYPE::SIO_WRITE);
+                }
+                liveStats->publish(instructionCount, EIP, EBP, ESP, peakESP, returnAddressCount, readCount, writeCount);
+            }
+        }
+    }
+    if (liveStats != nullptr) {
+        liveStats->publish(instructionCount, EIP, EBP, ESP, peakESP, returnAddressCount, readCount, writeCount);
+    }
+
+    // Let the profilers process the data they have collected.
+    for (auto profiler : profilers) {
+        profiler->report(*program);
+    }
+}
+
 void FJP::VirtualMachine::init() {
     ESP  = 0; // stack pointer
     EBP  = 1; // base pointer
@@ -58,17 +180,73 @@ void FJP::VirtualMachine::init() {
     // No function has been called yet.
     returnAddressCount = 0;
 
+    // A program loaded from a bytecode file might have been crafted to access memory outside of the stack.
+    frameChecking = program->getMappedInstructions() != nullptr;
+
     // Clear out the entire stack as well as the return addresses.
     memset(returnAddresses, 0, sizeof(returnAddresses));
-    memset(stackMemory, 0, sizeof(stackMemory));
+    allocateStack();
+
+    // The instructions are fetched in the packed form (8 bytes instead of 12). A program loaded
+    // from a bytecode file is already packed, so it is executed right from the mapped file.
+    if (const FJP::PackedCodeView *mapped = program->getMappedInstructions()) {
+        packedCode = {};
+        instructions = mapped->instructions;
+        wideInstructions = mapped->wideInstructions;
+    } else {
+        packedCode = program->pack();
+        instructions = packedCode.instructions.data();
+        wideInstructions = packedCode.wideInstructions.data();
+    }
+
+    // Allocate the data segment (global arrays).
+    dataMemory.assign(program->getDataSize(), 0);
+
+    // Look up the sizes of the arrays by the addresses of the instructions accessing them.
+    arrayBounds.clear();
+    if (boundsChecking) {
+        arrayBounds.assign(program->getSize(), INT_MAX);
+        for (const auto &size : program->getArraySizes()) {
+            arrayBounds[size.first] = size.second;
+        }
+    }
+}
+
+void FJP::VirtualMachine::allocateStack() {
+    const FJP::StackBound &bound = program->getStackBound();
+
+    // The stack pointer can reach maxDepth, so we need one more slot (index 0 is never used).
+    // A program loaded from a bytecode file always has its stack checked.
+    stackBoundProven = !frameChecking && bound.known && !bound.recursive && bound.maxDepth <= STACK_SIZE;
+    if (stackBoundProven) {
+        stackSize = bound.maxDepth + 1;
+    } else {
+        // The checks let the stack pointer reach STACK_SIZE, and a call writes its
+        // frame above the stack pointer before the frame gets allocated (INC).
+        stackSize = STACK_SIZE + CALL_SIZE + 1;
+
+        // Let the user know up front the program is going to fail.
+        if (bound.known && bound.maxDepth > STACK_SIZE) {
+            std::cerr << "warning: the program needs " << bound.maxDepth << " slots of the stack";
+            if (bound.recursive) {
+                std::cerr << " (+" << bound.levelCost << " per level of recursion)";
+            }
+            std::cerr << ", but the stack has only " << STACK_SIZE << "\n";
+        }
+    }
+
+    // Clear out the entire stack.
+    stackStorage.assign(stackSize, 0);
+    stackMemory = stackStorage.data();
 }
 
 void FJP::VirtualMachine::fetch() {
     // Fetch the very next instruction from the code.
-    instruction = (*program)[EIP];
+    instruction = FJP::unpack_instruction(instructions[EIP], wideInstructions);
     EIP++;
 }
 
+template <bool CHECK_STACK>
 void FJP::VirtualMachine::execute() {
     if (debug) {
         // If debug is enabled, print out the current
@@ -76,16 +254,21 @@ void FJP::VirtualMachine::execute() {
         outputFile << (EIP - 1) << "\t" << op_code_to_str(instruction.op) << "\t" << instruction.l << "\t" << instruction.m << "\t";
     }
 
+    // A program loaded from a bytecode file is never proven to fit in the stack, so it gets here with the checks on.
+    if (CHECK_STACK && frameChecking) {
+        checkInstruction();
+    }
+
     // Execute the current instruction
     switch (instruction.op) {
         case LIT:
-            execute_LIT(instruction.l, instruction.m);
+            execute_LIT<CHECK_STACK>(instruction.l, instruction.m);
             break;
         case OPR:
             execute_OPR(instruction.l, instruction.m);
             break;
         case LOD:
-            execute_LOD(instruction.l, instruction.m);
+            execute_LOD<CHECK_STACK>(instruction.l, instruction.m);
             break;
         case STO:
             execute_STO(instruction.l, instruction.m);
@@ -94,7 +277,7 @@ void FJP::VirtualMachine::execute() {
             execute_CAL(instruction.l, instruction.m);
             break;
         case INC:
-            execute_INC(instruction.l, instruction.m);
+            execute_INC<CHECK_STACK>(instruction.l, instruction.m);
             break;
         case JMP:
             execute_JMP(instruction.l, instruction.m);
@@ -102,8 +285,49 @@ void FJP::VirtualMachine::execute() {
         case JPC:
             execute_JPC(instruction.l, instruction.m);
             break;
+        case JTB:
+            execute_JTB(instruction.l, instruction.m);
+            break;
+        case JEQ:
+        case JNE:
+        case JLT:
+        case JLE:
+        case JGT:
+        case JGE:
+            execute_JCC(instruction.op, instruction.m);
+            break;
+        case JEQI:
+        case JNEI:
+        case JLTI:
+        case JLEI:
+        case JGTI:
+        case JGEI:
+            execute_JCCI(instruction.op, instruction.l, instruction.m);
+            break;
+        case ADDI:
+            execute_ADDI(instruction.l, instruction.m);
+            break;
+        case SUBI:
+            execute_SUBI(instruction.l, instruction.m);
+            break;
+        case MULI:
+            execute_MULI(instruction.l, instruction.m);
+            break;
+        case CMPI:
+            execute_CMPI(instruction.l, instruction.m);
+            break;
+        case ADDV:
+        case SUBV:
+        case MULV:
+            execute_UPD(instruction.op, instruction.l, instruction.m);
+            break;
+        case ADDVI:
+        case SUBVI:
+        case MULVI:
+            execute_UPDI(instruction.op, instruction.m);
+            break;
         case SIO:
-            execute_SIO(instruction.l, instruction.m);
+            execute_SIO<CHECK_STACK>(instruction.l, instruction.m);
             break;
         case LDA:
             execute_LDA(instruction.l, instruction.m);
@@ -111,6 +335,33 @@ void FJP::VirtualMachine::execute() {
         case STA:
             execute_STA(instruction.l, instruction.m);
             break;
+        case LDD:
+            execute_LDD(instruction.l, instruction.m);
+            break;
+        case STD:
+            execute_STD(instruction.l, instruction.m);
+            break;
+        case LDX:
+            execute_LDX(instruction.l, instruction.m);
+            break;
+        case STX:
+            execute_STX(instruction.l, instruction.m);
+            break;
+        case CPY:
+            execute_CPY(instruction.l, instruction.m);
+            break;
+        case CPD:
+            execute_CPD(instruction.l, instruction.m);
+            break;
+        case VADD:
+        case VMUL:
+        case VSUM:
+        case VMIN:
+        case VMAX:
+        case VCMP:
+        case VFILL:
+            execute_VECTOR(instruction.op, instruction.m);
+            break;
     }
     if (debug) {
         // Print out the current values of all three registers.
@@ -134,12 +385,101 @@ int FJP::VirtualMachine::base(int l, int base) {
     // Return the base pointer of the frame
     // 'levels' above (down the stack)
     while (l > 0) {
+        // The static link has to lie within the allocated part of the stack.
+        if (frameChecking && (base < 1 || base + 1 > ESP)) {
+            FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
+        }
         base = stackMemory[base + 1];
         l--;
     }
     return base;
 }
 
+int FJP::VirtualMachine::frameAddress(int l, int m) {
+    int frameBase = base(l, EBP);
+
+    // Make sure the variable exists within the stack (64 bits, so the addition cannot overflow).
+    if (frameChecking) {
+        int64_t address = static_cast<int64_t>(frameBase) + m;
+        if (address < 0 || address > ESP) {
+            FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
+        }
+    }
+    return frameBase + m;
+}
+
+void FJP::VirtualMachine::checkInstruction() {
+    // Number of values the instruction takes off the stack.
+    int operands = 0;
+    switch (instruction.op) {
+        case OPR:
+            if (instruction.m == FJP::OPRType::OPR_RET) {
+                // The return restores the registers stored by the call (or the initial ones of the main block).
+                if (EBP < 1 || EBP + 3 > ESP) {
+                    FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
+                }
+                int returnAddress = stackMemory[EBP + 3];
+                int dynamicLink = stackMemory[EBP + 2];
+                if (dynamicLink != 0 && (dynamicLink >= EBP || returnAddressCount < 1 || returnAddress < 0 || returnAddress >= program->getSize())) {
+                    FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
+                }
+            } else {
+                operands = instruction.m == FJP::OPRType::OPR_INVERT_VALUE || instruction.m == FJP::OPRType::OPR_ODD ? 1 : 2;
+            }
+            break;
+        case CAL:
+            if (returnAddressCount >= STACK_SIZE) {
+                FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
+            }
+            break;
+        case INC:
+            if (static_cast<int64_t>(ESP) + instruction.m < 0) {
+                FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
+            }
+            break;
+        case SIO:
+            operands = instruction.m == FJP::SIO_TYPE::SIO_WRITE ? 1 : 0;
+            break;
+        case STO:
+        case LDA:
+        case LDD:
+        case LDX:
+        case JPC:
+        case JTB:
+        case JEQI:
+        case JNEI:
+        case JLTI:
+        case JLEI:
+        case JGTI:
+        case JGEI:
+        case ADDI:
+        case SUBI:
+        case MULI:
+        case CMPI:
+        case ADDV:
+        case SUBV:
+        case MULV:
+            operands = 1;
+            break;
+        case STA:
+        case STD:
+        case STX:
+        case JEQ:
+        case JNE:
+        case JLT:
+        case JLE:
+        case JGT:
+        case JGE:
+            operands = 2;
+            break;
+        default:
+            break;
+    }
+    if (ESP < operands) {
+        FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
+    }
+}
+
 bool FJP::VirtualMachine::checkIfOverflows(std::function<int(int, int)> operation, int x, int y) {
     // Performs the operation.
     int result = operation(x, y);
@@ -148,12 +488,13 @@ bool FJP::VirtualMachine::checkIfOverflows(std::function<int(int, int)> operatio
     return (x < 0 && y < 0 && result > 0) || (x > 0 && y > 0 && result < 0);
 }
 
+template <bool CHECK_STACK>
 void FJP::VirtualMachine::execute_LIT(int l, int m) {
     // So the compiler doesn't complain about an unused variable.
     (void)l;
 
     // Make sure that the stack is not all taken up
-    if (ESP == STACK_SIZE) {
+    if (CHECK_STACK && ESP == STACK_SIZE) {
         FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
     }
 
@@ -170,10 +511,14 @@ void FJP::VirtualMachine::execute_OPR(int l, int m) {
     switch (m) {
         // return
         case FJP::OPRType::OPR_RET:
+            for (auto profiler : profilers) {
+                profiler->functionReturned();
+            }
             ESP = EBP - 1;
             EIP = stackMemory[ESP + 4];
             EBP = stackMemory[ESP + 3];
             returnAddressCount--;
+            FJP_PROBE2(vm_return, EIP, EBP);
             break;
         // x = -x
         case FJP::OPRType::OPR_INVERT_VALUE:
@@ -250,24 +595,30 @@ void FJP::VirtualMachine::execute_OPR(int l, int m) {
     }
 }
 
+template <bool CHECK_STACK>
 void FJP::VirtualMachine::execute_LOD(int l, int m) {
     // Make sure that the stack is not all taken up
-    if (ESP == STACK_SIZE) {
+    if (CHECK_STACK && ESP == STACK_SIZE) {
         FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
     }
 
     // Load the value from the address to the top of the stack.
+    int address = frameAddress(l, m);
     ESP++;
-    stackMemory[ESP] = stackMemory[base(l, EBP) + m];
+    stackMemory[ESP] = stackMemory[address];
 }
 
 void FJP::VirtualMachine::execute_STO(int l, int m) {
     // Stores the value at the address.
-    stackMemory[base(l, EBP) + m] = stackMemory[ESP];
+    stackMemory[frameAddress(l, m)] = stackMemory[ESP];
     ESP--;
 }
 
 void FJP::VirtualMachine::execute_CAL(int l, int m) {
+    for (auto profiler : profilers) {
+        profiler->functionCalled(m);
+    }
+
     // Push all necessary values on the stack
     // before jumping to the first address of the function.
     stackMemory[ESP + 1] = 0;
@@ -285,14 +636,17 @@ void FJP::VirtualMachine::execute_CAL(int l, int m) {
     // Store the return address.
     returnAddresses[returnAddressCount] = ESP;
     returnAddressCount++;
+
+    FJP_PROBE2(vm_call, m, stackMemory[EBP + 3]);
 }
 
+template <bool CHECK_STACK>
 void FJP::VirtualMachine::execute_INC(int l, int m) {
     // Just so the compiler doesn't complain about an unused value.
     (void)l;
 
     // Make sure that there is enough free space on the stack.
-    if (m + ESP > STACK_SIZE) {
+    if (CHECK_STACK && m + ESP > STACK_SIZE) {
         FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
     }
 
@@ -316,6 +670,125 @@ void FJP::VirtualMachine::execute_JPC(int l, int m) {
     ESP--;
 }
 
+void FJP::VirtualMachine::execute_JCC(FJP::OP_CODE op, int m) {
+    // The branches are ordered the same way as the comparisons (see FJP::branch_comparison).
+    ESP -= 2;
+    if (compare(FJP::OPRType::OPR_EQ + (op - FJP::OP_CODE::JEQ), stackMemory[ESP + 1], stackMemory[ESP + 2])) {
+        EIP = m;
+    }
+}
+
+void FJP::VirtualMachine::execute_JCCI(FJP::OP_CODE op, int l, int m) {
+    ESP--;
+    if (compare(FJP::OPRType::OPR_EQ + (op - FJP::OP_CODE::JEQI), stackMemory[ESP + 1], l)) {
+        EIP = m;
+    }
+}
+
+void FJP::VirtualMachine::execute_ADDI(int l, int m) {
+    (void)l;
+    if (checkIfOverflows([&](int x, int y) {return x + y; }, stackMemory[ESP], m)) {
+        FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_02, ERROR_CODE);
+    }
+    stackMemory[ESP] = stackMemory[ESP] + m;
+}
+
+void FJP::VirtualMachine::execute_SUBI(int l, int m) {
+    (void)l;
+    stackMemory[ESP] = stackMemory[ESP] - m;
+}
+
+void FJP::VirtualMachine::execute_MULI(int l, int m) {
+    (void)l;
+    if (checkIfOverflows([&](int x, int y) {return x * y; }, stackMemory[ESP], m)) {
+        FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_02, ERROR_CODE);
+    }
+    stackMemory[ESP] = stackMemory[ESP] * m;
+}
+
+void FJP::VirtualMachine::execute_CMPI(int l, int m) {
+    stackMemory[ESP] = compare(l, stackMemory[ESP], m);
+}
+
+void FJP::VirtualMachine::execute_UPD(FJP::OP_CODE op, int l, int m) {
+    int address = frameAddress(l, m);
+    ESP--;
+    updateVariable(op, stackMemory[address], stackMemory[ESP + 1]);
+}
+
+void FJP::VirtualMachine::execute_UPDI(FJP::OP_CODE op, int m) {
+    // The immediate forms are ordered the same way as the stack ones.
+    const FJP::VariableUpdate &update = program->getVariableUpdate(m);
+    updateVariable(static_cast<FJP::OP_CODE>(FJP::OP_CODE::ADDV + (op - FJP::OP_CODE::ADDVI)),
+                   stackMemory[frameAddress(update.level, update.address)], update.value);
+}
+
+void FJP::VirtualMachine::updateVariable(FJP::OP_CODE op, int &variable, int value) {
+    switch (op) {
+        case FJP::OP_CODE::ADDV:
+            if (checkIfOverflows([&](int x, int y) {return x + y; }, variable, value)) {
+                FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_02, ERROR_CODE);
+            }
+            variable = variable + value;
+            break;
+        case FJP::OP_CODE::SUBV:
+            variable = variable - value;
+            break;
+        case FJP::OP_CODE::MULV:
+            if (checkIfOverflows([&](int x, int y) {return x * y; }, variable, value)) {
+                FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_02, ERROR_CODE);
+            }
+            variable = variable * value;
+            break;
+        default:
+            break;
+    }
+}
+
+bool FJP::VirtualMachine::compare(int comparison, int x, int y) const {
+    switch (comparison) {
+        case FJP::OPRType::OPR_EQ:
+            return x == y;
+        case FJP::OPRType::OPR_NEQ:
+            return x != y;
+        case FJP::OPRType::OPR_LESS:
+            return x < y;
+        case FJP::OPRType::OPR_LESS_EQ:
+            return x <= y;
+        case FJP::OPRType::OPR_GRT:
+            return x > y;
+        case FJP::OPRType::OPR_GRT_EQ:
+            return x >= y;
+    }
+    return false;
+}
+
+void FJP::VirtualMachine::execute_JTB(int l, int m) {
+    (void)l;
+    const FJP::JumpTable &table = program->getJumpTable(m);
+    int value = stackMemory[ESP];
+    ESP--;
+
+    // The value is the index into a dense table (64 bits, so the subtraction cannot overflow).
+    if (table.dense) {
+        int64_t index = static_cast<int64_t>(value) - table.low;
+        if (index >= 0 && index < static_cast<int64_t>(table.targets.size())) {
+            EIP = table.targets[index];
+        } else {
+            EIP = table.defaultTarget;
+        }
+        return;
+    }
+
+    // The values of a sparse table are sorted, so they can be searched by bisection.
+    auto position = std::lower_bound(table.values.begin(), table.values.end(), value);
+    if (position != table.values.end() && *position == value) {
+        EIP = table.targets[position - table.values.begin()];
+    } else {
+        EIP = table.defaultTarget;
+    }
+}
+
 void FJP::VirtualMachine::execute_LDA(int l, int m) {
     // Just so the compiler doesn't complain about an unused value.
     (void)m;
@@ -355,6 +828,264 @@ void FJP::VirtualMachine::execute_STA(int l, int m) {
     ESP -= 2;
 }
 
+void FJP::VirtualMachine::execute_LDD(int l, int m) {
+    // Make sure the index lies within the array.
+    int index = stackMemory[ESP];
+    if (index < 0 || index >= l) {
+        FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_03, ERROR_CODE);
+    }
+
+    // Replace the index with the value of the element.
+    stackMemory[ESP] = dataMemory[m + index];
+}
+
+void FJP::VirtualMachine::execute_STD(int l, int m) {
+    // Make sure the index lies within the array.
+    int index = stackMemory[ESP - 1];
+    if (index < 0 || index >= l) {
+        FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_03, ERROR_CODE);
+    }
+
+    // Store the value from the top of the stack into the element.
+    dataMemory[m + index] = stackMemory[ESP];
+    ESP -= 2;
+}
+
+void FJP::VirtualMachine::execute_LDX(int l, int m) {
+    // Replace the index with the value of the element.
+    stackMemory[ESP] = stackMemory[elementAddress(l, m, stackMemory[ESP])];
+}
+
+void FJP::VirtualMachine::execute_STX(int l, int m) {
+    // Make sure that there are at least two values
+    // on the stack - the value and the index
+    if (ESP < 2) {
+        FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
+    }
+
+    // Store the value from the top of the stack into the element.
+    stackMemory[elementAddress(l, m, stackMemory[ESP - 1])] = stackMemory[ESP];
+    ESP -= 2;
+}
+
+int FJP::VirtualMachine::elementAddress(int l, int m, int index) {
+    // The instruction has already been fetched, so it lies right before EIP.
+    if (boundsChecking && (index < 0 || index >= arrayBounds[EIP - 1])) {
+        FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_03, ERROR_CODE);
+    }
+
+    // Make sure the element exists within the stack (64 bits, so the addition cannot overflow).
+    int64_t frameAddress = static_cast<int64_t>(base(l, EBP)) + m + index;
+    if (frameAddress > ESP || frameAddress < 0) {
+        // Adding up the base address and the index used to be a separate instruction checking the overflow.
+        if (checkIfOverflows([&](int x, int y) {return x + y; }, index, m)) {
+            FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_02, ERROR_CODE);
+        }
+        FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
+    }
+    return static_cast<int>(frameAddress);
+}
+
+void FJP::VirtualMachine::execute_CPY(int l, int m) {
+    const std::vector<int> &pool = program->getConstantPool();
+    int count = pool[m];
+    int frameAddress = base(l, EBP) + pool[m + 1];
+
+    // Make sure the whole block lands within the allocated part of the stack.
+    if (frameAddress < 0 || frameAddress + count - 1 > ESP) {
+        FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
+    }
+    std::copy(pool.begin() + m + 2, pool.begin() + m + 2 + count, stackMemory + frameAddress);
+}
+
+void FJP::VirtualMachine::execute_CPD(int l, int m) {
+    // Just so the compiler doesn't complain about an unused value.
+    (void)l;
+
+    const std::vector<int> &pool = program->getConstantPool();
+    int count = pool[m];
+    std::copy(pool.begin() + m + 2, pool.begin() + m + 2 + count, dataMemory.begin() + pool[m + 1]);
+}
+
+void FJP::VirtualMachine::execute_VECTOR(FJP::OP_CODE op, int m) {
+    const FJP::VectorLoop &loop = program->getVectorLoop(m);
+    int first = 0;
+    int count = 0;
+    bool done = false;
+
+    switch (op) {
+        // s := s + a[i]
+        case VSUM:
+            if (vectorRange(loop, {loop.first}, first, count)) {
+                int &target = vectorVariable(loop.target);
+                uint64_t absoluteSum = 0;
+                int64_t sum = vectorKernels->sum(vectorElements(loop.first, first), count, absoluteSum);
+
+                // If the absolute values add up within the range of int, none of the partial sums
+                // can overflow. Otherwise, let the loop find out whether it actually does.
+                uint64_t magnitude = target < 0 ? 0ULL - static_cast<uint64_t>(target) : static_cast<uint64_t>(target);
+                if (magnitude + absoluteSum <= static_cast<uint64_t>(INT_MAX)) {
+                    target = static_cast<int>(target + sum);
+                    done = true;
+                }
+            }
+            break;
+        // if (a[i] < m) m := a[i]
+        case VMIN:
+            if (vectorRange(loop, {loop.first}, first, count)) {
+                int &target = vectorVariable(loop.target);
+                target = vectorKernels->min(vectorElements(loop.first, first), count, target);
+                done = true;
+            }
+            break;
+        // if (a[i] > m) m := a[i]
+        case VMAX:
+            if (vectorRange(loop, {loop.first}, first, count)) {
+                int &target = vectorVariable(loop.target);
+                target = vectorKernels->max(vectorElements(loop.first, first), count, target);
+                done = true;
+            }
+            break;
+        // if (a[i] <comparison> x) c := c + 1
+        case VCMP:
+            if (loop.secondIsArray ? vectorRange(loop, {loop.first, loop.second}, first, count) : vectorRange(loop, {loop.first}, first, count)) {
+                int greater = 0;
+                int equal = 0;
+                if (loop.secondIsArray) {
+                    vectorKernels->compare(vectorElements(loop.first, first), vectorElements(loop.second, first), count, greater, equal);
+                } else {
+                    vectorKernels->compare(vectorElements(loop.first, first), vectorValue(loop.operand), count, greater, equal);
+                }
+                int less = count - greater - equal;
+                int matched = 0;
+                switch (loop.comparison) {
+                    case FJP::OPRType::OPR_EQ:
+                        matched = equal;
+                        break;
+                    case FJP::OPRType::OPR_NEQ:
+                        matched = count - equal;
+                        break;
+                    case FJP::OPRType::OPR_LESS:
+                        matched = less;
+                        break;
+                    case FJP::OPRType::OPR_LESS_EQ:
+                        matched = less + equal;
+                        break;
+                    case FJP::OPRType::OPR_GRT:
+                        matched = greater;
+                        break;
+                    case FJP::OPRType::OPR_GRT_EQ:
+                        matched = greater + equal;
+                        break;
+                    default:
+                        break;
+                }
+
+                // The counter would overflow - let the loop report it.
+                int &target = vectorVariable(loop.target);
+                if (static_cast<int64_t>(target) + matched <= INT_MAX) {
+                    target += matched;
+                    done = true;
+                }
+            }
+            break;
+        // a[i] := b[i] + c[i]
+        case VADD:
+            if (vectorRange(loop, {loop.first, loop.second, loop.destination}, first, count)) {
+                done = vectorKernels->add(vectorElements(loop.destination, first), vectorElements(loop.first, first),
+                                          vectorElements(loop.second, first), count);
+            }
+            break;
+        // a[i] := b[i] * c[i]
+        case VMUL:
+            if (vectorRange(loop, {loop.first, loop.second, loop.destination}, first, count)) {
+                done = vectorKernels->mul(vectorElements(loop.destination, first), vectorElements(loop.first, first),
+                                          vectorElements(loop.second, first), count);
+            }
+            break;
+        // a[i] := x
+        case VFILL:
+            if (vectorRange(loop, {loop.destination}, first, count)) {
+                int value = vectorValue(loop.operand);
+                if (loop.normalize) {
+                    value = (value != 0);
+                }
+                std::fill_n(vectorElements(loop.destination, first), count, value);
+                done = true;
+            }
+            break;
+        default:
+            break;
+    }
+
+    // Skip the JMP over the loop, so the loop itself gets executed.
+    if (!done) {
+        EIP++;
+        return;
+    }
+
+    // Leave the counter (and the iterator) the way the loop would.
+    if (loop.foreachLoop) {
+        vectorVariable(loop.counter) = count;
+        if (count > 0) {
+            vectorVariable(loop.iterator) = vectorElements(loop.first, 0)[count - 1];
+        }
+    } else if (count > 0) {
+        vectorVariable(loop.counter) = first + count;
+    }
+}
+
+int &FJP::VirtualMachine::vectorVariable(const FJP::VectorValue &variable) {
+    return stackMemory[frameAddress(variable.level, variable.address)];
+}
+
+int FJP::VirtualMachine::vectorValue(const FJP::VectorValue &value) {
+    return value.isVariable ? vectorVariable(value) : value.value;
+}
+
+int *FJP::VirtualMachine::vectorElements(const FJP::VectorArray &array, int first) {
+    if (array.inDataSegment) {
+        return dataMemory.data() + array.address + first;
+    }
+
+    // The whole array has to lie within the stack (the range of the elements lies within the array).
+    int address = frameAddress(array.level, array.address);
+    if (frameChecking && static_cast<int64_t>(address) + array.size - 1 > ESP) {
+        FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
+    }
+    return stackMemory + address + first;
+}
+
+bool FJP::VirtualMachine::vectorRange(const FJP::VectorLoop &loop, std::initializer_list<FJP::VectorArray> arrays, int &first, int &count) {
+    // A foreach loop goes over the whole array (the other arrays cannot be any shorter).
+    if (loop.foreachLoop) {
+        first = 0;
+        count = loop.first.size;
+        for (const auto &array : arrays) {
+            if (count < 0 || count > array.size) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // A for loop goes from the current value of the counter up to the bound.
+    first = vectorVariable(loop.counter);
+    int64_t end = static_cast<int64_t>(vectorValue(loop.bound)) + (loop.inclusive ? 1 : 0);
+    if (end <= first) {
+        count = 0;
+        return true;
+    }
+    for (const auto &array : arrays) {
+        if (first < 0 || end > array.size) {
+            return false;
+        }
+    }
+    count = static_cast<int>(end - first);
+    return true;
+}
+
+template <bool CHECK_STACK>
 void FJP::VirtualMachine::execute_SIO(int l, int m) {
     // Just so the compiler doesn't complain about an unused value.
     (void)l;
@@ -363,19 +1094,22 @@ void FJP::VirtualMachine::execute_SIO(int l, int m) {
     switch (m) {
         // write
         case FJP::SIO_TYPE::SIO_WRITE:
+            FJP_PROBE2(vm_sio, m, stackMemory[ESP]);
             std::cout << stackMemory[ESP] << '\n';
             ESP--;
             break;
         // read
         case FJP::SIO_TYPE::SIO_READ:
-            if (ESP == STACK_SIZE) {
+            if (CHECK_STACK && ESP == STACK_SIZE) {
                 FJP::exitProgramWithError(FJP::RuntimeErrors::ERROR_00, ERROR_CODE);
             }
             ESP++;
             std::cin >> stackMemory[ESP];
+            FJP_PROBE2(vm_sio, m, stackMemory[ESP]);
             break;
         // halt
         case FJP::SIO_TYPE::SIO_HALT:
+            FJP_PROBE2(vm_sio, m, 0);
             halt = 0;
             break;
         default:
@@ -0,0 +1,148 @@
+#include <ctime>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <dirent.h>
+
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <vm_stats.h>
+
+namespace {
+
+    /// Refresh interval of the output in milliseconds.
+    constexpr int REFRESH_INTERVAL_MS = 500;
+
+    /// Consistent copy of the statistics.
+    struct Snapshot {
+        uint64_t instructions;
+        int64_t currentESP;
+        int64_t peakESP;
+        int64_t callDepth;
+        uint64_t reads;
+        uint64_t writes;
+        int64_t startTime;
+        int64_t endTime;
+    };
+
+    /// Returns the current value of the monotonic clock in nanoseconds.
+    int64_t now() {
+        struct timespec time {};
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+    }
+
+    /// Finds the PID of a running virtual machine by looking for its shared memory segment.
+    /// \return the PID (-1 if there is none)
+    long findProcess() {
+        long pid = -1;
+        DIR *directory = opendir("/dev/shm");
+        if (directory == nullptr) {
+            return pid;
+        }
+        std::string prefix = std::string(FJP::VM_STATS_SHM_PREFIX).substr(1);
+        while (struct dirent *entry = readdir(directory)) {
+            std::string name = entry->d_name;
+            if (name.compare(0, prefix.size(), prefix) == 0) {
+                pid = std::atol(name.c_str() + prefix.size());
+                break;
+            }
+        }
+        closedir(directory);
+        return pid;
+    }
+
+    /// Reads a consistent snapshot of the statistics (seqlock reader).
+    Snapshot readSnapshot(const FJP::VMStats *stats) {
+        Snapshot snapshot {};
+        while (true) {
+            uint64_t sequence = stats->sequence.load(std::memory_order_acquire);
+            if (sequence % 2 == 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            snapshot.instructions = stats->instructions.load(std::memory_order_relaxed);
+            snapshot.currentESP = stats->currentESP.load(std::memory_order_relaxed);
+            snapshot.peakESP = stats->peakESP.load(std::memory_order_relaxed);
+            snapshot.callDepth = stats->callDepth.load(std::memory_order_relaxed);
+            snapshot.reads = stats->reads.load(std::memory_order_relaxed);
+            snapshot.writes = stats->writes.load(std::memory_order_relaxed);
+            snapshot.startTime = stats->startTime.load(std::memory_order_relaxed);
+            snapshot.endTime = stats->endTime.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (stats->sequence.load(std::memory_order_relaxed) == sequence) {
+                return snapshot;
+            }
+        }
+    }
+}
+
+/// Watches the live statistics of a running virtual machine (./fjp <input> -r --live-stats).
+/// Usage: ./fjp-top [pid] (if the PID is omitted, the first running virtual machine is used)
+int main(int argc, char *argv[]) {
+    long pid = argc > 1 ? std::atol(argv[1]) : findProcess();
+    if (pid <= 0) {
+        std::cerr << "ERR: no running virtual machine found (run './fjp <input> -r --live-stats')\n";
+        return 1;
+    }
+
+    // Map the shared memory segment (read only).
+    std::string name = std::string(FJP::VM_STATS_SHM_PREFIX) + std::to_string(pid);
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        std::cerr << "ERR: could not open " << name << "\n";
+        return 1;
+    }
+    void *memory = mmap(nullptr, sizeof(FJP::VMStats), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        std::cerr << "ERR: could not map " << name << "\n";
+        return 1;
+    }
+    const auto *stats = static_cast<const FJP::VMStats *>(memory);
+    if (stats->magic != FJP::VM_STATS_MAGIC || stats->version != FJP::VM_STATS_VERSION) {
+        std::cerr << "ERR: " << name << " is not a valid statistics segment\n";
+        return 1;
+    }
+
+    std::printf("%8s %16s %14s %6s %6s %6s %10s %10s\n",
+                "time[s]", "instructions", "instr/s", "ESP", "peak", "depth", "reads", "writes");
+
+    Snapshot previous = readSnapshot(stats);
+    int64_t previousTime = now();
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(REFRESH_INTERVAL_MS));
+        Snapshot current = readSnapshot(stats);
+        int64_t currentTime = current.endTime != 0 ? current.endTime : now();
+
+        double elapsed = static_cast<double>(currentTime - current.startTime) / 1e9;
+        double interval = static_cast<double>(currentTime - previousTime) / 1e9;
+        double rate = interval > 0 ? static_cast<double>(current.instructions - previous.instructions) / interval : 0;
+
+        std::printf("%8.1f %16llu %14.0f %6lld %6lld %6lld %10llu %10llu\n", elapsed,
+                    static_cast<unsigned long long>(current.instructions), rate,
+                    static_cast<long long>(current.currentESP), static_cast<long long>(current.peakESP),
+                    static_cast<long long>(current.callDepth), static_cast<unsigned long long>(current.reads),
+                    static_cast<unsigned long long>(current.writes));
+        std::fflush(stdout);
+
+        if (current.endTime != 0) {
+            std::printf("finished\n");
+            break;
+        }
+        if (kill(static_cast<pid_t>(pid), 0) != 0) {
+            std::printf("terminated\n");
+            break;
+        }
+        previous = current;
+        previousTime = currentTime;
+    }
+    munmap(memory, sizeof(FJP::VMStats));
+    return 0;
+}